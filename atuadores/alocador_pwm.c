@@ -0,0 +1,150 @@
+// alocador_pwm.c
+// Mapa dos canais de PWM da placa e configuração única das fatias
+
+#include "alocador_pwm.h"
+#include "pico/stdlib.h"
+#include "hardware/pwm.h"
+#include "hardware/clocks.h"
+#include "log_adiado.h"
+#include "placa.h"
+
+#define WRAP_TOM 4095 // período fixo do buzzer; a nota muda só o divisor
+
+typedef struct {
+  uint8_t pino;
+  bool frequencia_variavel;
+  uint32_t contagem_hz; // fatias fixas: frequência do contador, mantida em qualquer clk_sys
+  uint16_t wrap;
+} UsoPwm;
+
+// Servos: a contagem de antes (divisor 64 em 125 MHz, 0,512 µs) e período de 20000 contagens
+#define CONTAGEM_SERVOS (125000000 / 64)
+
+static const UsoPwm usos[TOTAL_CANAIS_PWM] = {
+  [PWM_SERVO_GRAOS]      = {SERVO1_PIN, false, CONTAGEM_SERVOS, 20000},
+  [PWM_SERVO_CAFE_MOIDO] = {SERVO2_PIN, false, CONTAGEM_SERVOS, 20000},
+  // Buzzer: o GPIO 15 (barra de LEDs) divide a fatia 7, mas fica como SIO e não sente o divisor
+  [PWM_BUZZER]           = {BUZZER_PIN, true, 0, WRAP_TOM},
+};
+
+// Notas usadas pelos sons da máquina: divisores calculados na inicialização e a cada troca de clk_sys
+static const uint16_t notas_hz[] = {262, 294, 330, 349, 392, 400, 500, 1000, 2000, 3000};
+#define TOTAL_NOTAS (sizeof(notas_hz) / sizeof(notas_hz[0]))
+static uint32_t divisores_notas[TOTAL_NOTAS]; // em 1/16 (parte inteira << 4 | fração)
+
+static uint32_t frequencia_atual[TOTAL_CANAIS_PWM];
+static bool iniciado = false;
+static bool sem_conflitos = true; // resultado da verificação, devolvido também às chamadas seguintes
+
+// Divisor em 1/16 para o contador rodar em contagem_hz: clk_sys / contagem_hz, arredondado para cima
+static uint32_t divisor16_para(uint64_t contagem_hz) {
+  uint32_t divisor16 = (uint32_t)(((uint64_t)clock_get_hz(clk_sys) * 16 + contagem_hz - 1) / contagem_hz);
+  if (divisor16 < 16) divisor16 = 16;          // divisor mínimo 1,0
+  if (divisor16 > 0xFFF) divisor16 = 0xFFF;    // máximo 255 + 15/16
+  return divisor16;
+}
+
+// Divisor da nota: clk_sys / (freq * (WRAP_TOM + 1))
+static void calcular_notas(void) {
+  for (unsigned n = 0; n < TOTAL_NOTAS; n++) {
+    divisores_notas[n] = divisor16_para((uint64_t)notas_hz[n] * (WRAP_TOM + 1));
+  }
+}
+
+static uint32_t divisor_nota(uint32_t freq) {
+  for (unsigned n = 0; n < TOTAL_NOTAS; n++) {
+    if (notas_hz[n] == freq) return divisores_notas[n];
+  }
+  return divisor16_para((uint64_t)freq * (WRAP_TOM + 1)); // nota fora da tabela
+}
+
+static void aplicar_divisor(uint fatia, uint32_t divisor16) {
+  pwm_set_clkdiv_int_frac(fatia, divisor16 >> 4, divisor16 & 0xF);
+}
+
+static bool verificar_conflitos(void) {
+  bool ok = true;
+  for (int a = 0; a < TOTAL_CANAIS_PWM; a++) {
+    for (int b = a + 1; b < TOTAL_CANAIS_PWM; b++) {
+      const UsoPwm *ua = &usos[a], *ub = &usos[b];
+      if (pwm_gpio_to_slice_num(ua->pino) != pwm_gpio_to_slice_num(ub->pino)) continue;
+      if (pwm_gpio_to_channel(ua->pino) == pwm_gpio_to_channel(ub->pino)) {
+        LOG("PWM: GPIO %d e %d usam o mesmo canal\n", ua->pino, ub->pino);
+        ok = false;
+      } else if (ua->frequencia_variavel || ub->frequencia_variavel ||
+                 ua->contagem_hz != ub->contagem_hz || ua->wrap != ub->wrap) {
+        LOG("PWM: GPIO %d e %d dividem a fatia %d com configurações diferentes\n",
+            ua->pino, ub->pino, pwm_gpio_to_slice_num(ua->pino));
+        ok = false;
+      }
+    }
+  }
+  return ok;
+}
+
+bool pwm_alocador_iniciar(void) {
+  if (iniciado) return sem_conflitos;
+  sem_conflitos = verificar_conflitos();
+
+  calcular_notas();
+
+  uint32_t configuradas = 0; // uma vez por fatia
+  for (int c = 0; c < TOTAL_CANAIS_PWM; c++) {
+    const UsoPwm *u = &usos[c];
+    uint fatia = pwm_gpio_to_slice_num(u->pino);
+    gpio_set_function(u->pino, GPIO_FUNC_PWM);
+    pwm_set_chan_level(fatia, pwm_gpio_to_channel(u->pino), 0);
+    if (configuradas & (1u << fatia)) continue;
+    configuradas |= 1u << fatia;
+    if (!u->frequencia_variavel) aplicar_divisor(fatia, divisor16_para(u->contagem_hz));
+    pwm_set_wrap(fatia, u->wrap);
+    pwm_set_enabled(fatia, true);
+  }
+  iniciado = true;
+  return sem_conflitos;
+}
+
+// clk_sys mudou (frequencia.c): as fatias fixas voltam à mesma contagem, as notas são recalculadas e o
+// tom em andamento continua na mesma altura. Período e níveis não mudam.
+void pwm_alocador_recalcular(void) {
+  if (!iniciado) return;
+  calcular_notas();
+
+  uint32_t configuradas = 0;
+  for (int c = 0; c < TOTAL_CANAIS_PWM; c++) {
+    const UsoPwm *u = &usos[c];
+    uint fatia = pwm_gpio_to_slice_num(u->pino);
+    if (configuradas & (1u << fatia)) continue;
+    configuradas |= 1u << fatia;
+    if (!u->frequencia_variavel) {
+      aplicar_divisor(fatia, divisor16_para(u->contagem_hz));
+    } else if (frequencia_atual[c] != 0) {
+      aplicar_divisor(fatia, divisor_nota(frequencia_atual[c]));
+    }
+  }
+}
+
+int pwm_canal_do_pino(unsigned pino) {
+  for (int c = 0; c < TOTAL_CANAIS_PWM; c++) {
+    if (usos[c].pino == pino) return c;
+  }
+  return -1;
+}
+
+void pwm_canal_nivel(CanalPwm canal, uint16_t nivel) {
+  pwm_set_gpio_level(usos[canal].pino, nivel);
+}
+
+void pwm_canal_tom(CanalPwm canal, uint32_t freq, float duty_cycle) {
+  const UsoPwm *u = &usos[canal];
+  if (!u->frequencia_variavel || freq == 0) return;
+  if (freq != frequencia_atual[canal]) { // a mesma nota repetida não reescreve o divisor
+    aplicar_divisor(pwm_gpio_to_slice_num(u->pino), divisor_nota(freq));
+    frequencia_atual[canal] = freq;
+  }
+  pwm_set_gpio_level(u->pino, (uint16_t)(WRAP_TOM * duty_cycle));
+}
+
+void pwm_canal_parar(CanalPwm canal) {
+  pwm_set_gpio_level(usos[canal].pino, 0);
+}
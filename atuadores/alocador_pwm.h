@@ -0,0 +1,29 @@
+// alocador_pwm.h
+// Alocador das fatias de PWM: conhece o mapa pino -> fatia/canal de cada uso da placa, verifica
+// conflitos na inicialização e configura cada fatia uma única vez (divisor, período e habilitação).
+// Em tempo de execução só são escritos o nível do canal e, no buzzer, o divisor pré-calculado da nota;
+// parar um canal zera o nível sem desligar a fatia, que pode ter outro canal em uso.
+// Os divisores saem de clock_get_hz(clk_sys); depois de uma troca de clock, pwm_alocador_recalcular
+// mantém o tempo de cada contagem (pulsos dos servos) e a altura das notas.
+
+#ifndef ALOCADOR_PWM_H
+#define ALOCADOR_PWM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef enum {
+  PWM_SERVO_GRAOS,      // GPIO 11, fatia 5B
+  PWM_SERVO_CAFE_MOIDO, // GPIO 10, fatia 5A
+  PWM_BUZZER,           // GPIO 14, fatia 7A (frequência variável)
+  TOTAL_CANAIS_PWM,
+} CanalPwm;
+
+bool pwm_alocador_iniciar(void);                  // false se houver conflito (detalhes no LOG)
+void pwm_alocador_recalcular(void);               // após mudar clk_sys
+int pwm_canal_do_pino(unsigned pino);             // CanalPwm ou -1
+void pwm_canal_nivel(CanalPwm canal, uint16_t nivel);
+void pwm_canal_tom(CanalPwm canal, uint32_t freq, float duty_cycle); // fatias de frequência variável
+void pwm_canal_parar(CanalPwm canal);
+
+#endif // ALOCADOR_PWM_H
@@ -1,24 +1,17 @@
 // atuadores.c
 // Inclui os LEDs, os servomotores, o motor de passo e o buzzer
 
-#include <math.h>  // Para usar fmax
 #include <stdio.h>
 #include "pico/stdlib.h"
 #include "hardware/pwm.h"
 #include "atuadores.h"
+#include "rastreio.h"
+#include "placa.h"
+#include "hal_gpio.h"
+#include "barra_leds.h"
+#include "alocador_pwm.h"
+#include "log_adiado.h"
 
-#define LED_VERDE 7          // LED verde: indica que o sistema está ligado
-#define LED_VERMELHO 12      // LED vermelho: indica que a máquina precisa ser reabastecida
-#define LED_AZUL 13          // LED azul: indica que a rotina de preparo do café está ativa
-// barra de LEDs para exibir a intensidade do preparo do café
-const uint LED_BAR_PINS[10] = {6, 9, 15, 22, 21, 20, 19, 18, 17, 16};
-// Definição dos pinos dos servos
-#define SERVO1_PIN 11 // Servo 1: Comporta de grãos
-#define SERVO2_PIN 10 // Servo 2: Comporta de café moído
-// Definição dos pinos do motor de passo
-#define DIR_PIN 2    // Pino para controle da direção
-#define STEP_PIN 3   // Pino para controle dos passos
-#define BUZZER_PIN 14// Buzzer: usado para notificações sonoras
 
 // -------------------------------------------------------------------------------------------------- //
 // LEDs
@@ -43,61 +36,34 @@ void init_leds() {
 
 // Função para inicializar a barra de LEDs
 void init_led_bar() {
-  for (int i = 0; i < 10; i++) {
-    gpio_init(LED_BAR_PINS[i]);
-    gpio_set_dir(LED_BAR_PINS[i], GPIO_OUT);
-    gpio_put(LED_BAR_PINS[i], 0); // Apaga todos os LEDs no início
-  }
+  barra_leds_iniciar();
 }
 
-// Função para piscar barra de LEDs no fim do preparo do café
+// Função para piscar barra de LEDs no fim do preparo do café (retorna logo; o pisca segue no temporizador)
 void piscar_led_bar(int vezes, int intervalo_ms) {
-  for (int i = 0; i < vezes; i++) {
-    // Liga todos os LEDs
-    for (int j = 0; j < 10; j++) {
-      gpio_put(LED_BAR_PINS[j], 1);
-    }
-    sleep_ms(intervalo_ms);
-
-    // Desliga todos os LEDs
-    for (int j = 0; j < 10; j++) {
-      gpio_put(LED_BAR_PINS[j], 0);
-    }
-    sleep_ms(intervalo_ms);
-  }
+  barra_leds_piscar(vezes, intervalo_ms);
 }
 
-// Função para ligar barra de LEDs conforme intensidade selecionada
+// Função para ligar barra de LEDs conforme intensidade selecionada, com preenchimento progressivo
+// (um LED a cada 200 ms) sem bloquear; o último LED aceso mostra a fração em brilho (16 níveis)
 void atualizar_led_bar(int pressao) {
-  int num_leds = (int)fmax(1, (pressao * 10) / 100); // Converte para int e pelo menos 1 LED acende
-
-  for (int i = 0; i < 10; i++) {
-    gpio_put(LED_BAR_PINS[i], (i < num_leds) ? 1 : 0);
-    sleep_ms(200); // Efeito de preenchimento progressivo
-  }
+  int intensidade = pressao * BARRA_MAXIMO / 100;
+  if (intensidade < BARRA_NIVEIS - 1) intensidade = BARRA_NIVEIS - 1; // pelo menos 1 LED acende
+  barra_leds_preencher(intensidade, 200);
 }
 
 // -------------------------------------------------------------------------------------------------- //
 // Servomotores
 
-// Inicializa o PWM para os servos
+// Inicializa o PWM para os servos: o alocador configura cada fatia uma vez (a 5 tem os dois servos).
+// Um conflito de pinos (placa.h) não impede o boot, mas fica no LOG
 void servo_init(void)
 {
-  // Configuração do servo 1
-  gpio_set_function(SERVO1_PIN, GPIO_FUNC_PWM);
-  uint slice1 = pwm_gpio_to_slice_num(SERVO1_PIN);
-  pwm_set_clkdiv(slice1, 64.0f); // Ajusta o divisor de clock (50 Hz)
-  pwm_set_wrap(slice1, 20000);   // Configura o período do PWM para 20ms
-  pwm_set_gpio_level(SERVO1_PIN, 0);
-  pwm_set_enabled(slice1, true);
-
-  // Configuração do servo 2
-  gpio_set_function(SERVO2_PIN, GPIO_FUNC_PWM);
-  uint slice2 = pwm_gpio_to_slice_num(SERVO2_PIN);
-  pwm_set_clkdiv(slice2, 64.0f); // Ajusta o divisor de clock (50 Hz)
-  pwm_set_wrap(slice2, 20000);   // Configura o período do PWM para 20ms
-  pwm_set_gpio_level(SERVO2_PIN, 0);
-  pwm_set_enabled(slice2, true);
+  if (!pwm_alocador_iniciar()) {
+    LOG("PWM: conflito no mapa de pinos, servos e buzzer podem nao responder\n");
+  }
+  pwm_canal_nivel(PWM_SERVO_GRAOS, 0);
+  pwm_canal_nivel(PWM_SERVO_CAFE_MOIDO, 0);
 }
 
 // Move o servo 1 para o ângulo especificado (0 a 180 graus)
@@ -105,7 +71,7 @@ void servo1_move(uint angle)
 {
   if (angle > 180) angle = 180;
   uint pulse_width = 870 + (angle * 2000 / 180);
-  pwm_set_gpio_level(SERVO1_PIN, pulse_width);
+  pwm_canal_nivel(PWM_SERVO_GRAOS, pulse_width);
 }
 
 // Move o servo 2 para o ângulo especificado (0 a 180 graus)
@@ -113,12 +79,13 @@ void servo2_move(uint angle)
 {
   if (angle > 180) angle = 180;
   uint pulse_width = 870 + (angle * 2000 / 180);
-  pwm_set_gpio_level(SERVO2_PIN, pulse_width);
+  pwm_canal_nivel(PWM_SERVO_CAFE_MOIDO, pulse_width);
 }
 
 // Simula o ciclo de movimento para liberação de grãos
 void servo1_movimento(void)
 {
+  rastreio_evento(RASTREIO_ATUADOR_INICIO, ATUADOR_SERVO_GRAOS, 180);
   servo1_move(0);
   servo2_move(0);
   sleep_ms(500);
@@ -130,11 +97,13 @@ void servo1_movimento(void)
   sleep_ms(1000);
   servo1_move(0);
   sleep_ms(100);
+  rastreio_evento(RASTREIO_ATUADOR_FIM, ATUADOR_SERVO_GRAOS, 0);
 }
 
 // Simula o ciclo de movimento para liberação de café moído
 void servo2_movimento(void)
 {
+  rastreio_evento(RASTREIO_ATUADOR_INICIO, ATUADOR_SERVO_CAFE_MOIDO, 180);
  // printf("Abrindo comporta de café moído...\n");
   servo2_move(90);
   sleep_ms(1000);
@@ -142,6 +111,7 @@ void servo2_movimento(void)
   sleep_ms(1000);
   servo2_move(0);
   sleep_ms(100);
+  rastreio_evento(RASTREIO_ATUADOR_FIM, ATUADOR_SERVO_CAFE_MOIDO, 0);
 }
 
 // -------------------------------------------------------------------------------------------------- //
@@ -162,50 +132,92 @@ void stepper_init(void)
 // Gira o motor continuamente por um tempo (em ms) no sentido especificado
 void stepper_rotate(bool direction, uint32_t duration_ms, uint32_t step_delay_ms) 
 {
+    rastreio_evento(RASTREIO_ATUADOR_INICIO, ATUADOR_MOTOR_PASSO, duration_ms);
     gpio_put(DIR_PIN, direction); // Define a direção
     uint32_t steps = duration_ms / step_delay_ms; // Calcula o número de passos
     for (uint32_t i = 0; i < steps; i++) 
     {
-        gpio_put(STEP_PIN, 1); // Pulso alto
+        hal_gpio_ligar(STEP_PIN); // Pulso alto
         sleep_ms(step_delay_ms / 2); // Meio ciclo
-        gpio_put(STEP_PIN, 0); // Pulso baixo
+        hal_gpio_desligar(STEP_PIN); // Pulso baixo
         sleep_ms(step_delay_ms / 2); // Meio ciclo
     }
+    rastreio_evento(RASTREIO_ATUADOR_FIM, ATUADOR_MOTOR_PASSO, 0);
 }
 
 // -------------------------------------------------------------------------------------------------- //
 //Buzzer
 
+// Liga o tom no canal do pino: só o divisor da nota (pré-calculado) e o nível são escritos
 void setup_pwm(uint pin, uint freq, float duty_cycle) {
-  gpio_set_function(pin, GPIO_FUNC_PWM); // Configura o pino para PWM
-
-  uint slice_num = pwm_gpio_to_slice_num(pin);
-  uint channel = pwm_gpio_to_channel(pin);
+  int canal = pwm_canal_do_pino(pin);
+  if (canal < 0) return; // pino sem canal de PWM alocado
+  pwm_canal_tom(canal, freq, duty_cycle);
+}
 
-  uint32_t clock = 125000000; // Frequência do clock do Pico (125 MHz)
-  uint32_t divider16 = clock / freq / 4096 + (clock % (freq * 4096) != 0);
-  pwm_set_clkdiv(slice_num, divider16 / 16.0f);
+// Silencia o canal; a fatia continua habilitada para o outro canal
+void stop_pwm(uint pin) {
+  int canal = pwm_canal_do_pino(pin);
+  if (canal < 0) return;
+  pwm_canal_parar(canal);
+}
 
-  // Configura duty cycle
-  uint32_t level = (uint32_t)(4095 * duty_cycle);
-  pwm_set_wrap(slice_num, 4095);
-  pwm_set_chan_level(slice_num, channel, level);
+// Melodia em segundo plano: o alarme de cada nota liga a seguinte e se reagenda pela duração dela
+static struct {
+  uint pino;
+  const Nota *notas;
+  uint8_t total, proxima;
+  volatile alarm_id_t alarme;
+} melodia;
+
+static int64_t avancar_melodia(alarm_id_t id, void *dados) {
+  if (melodia.proxima >= melodia.total) {
+    stop_pwm(melodia.pino);
+    rastreio_evento(RASTREIO_ATUADOR_FIM, ATUADOR_BUZZER, 0);
+    melodia.alarme = 0;
+    return 0;
+  }
+  const Nota *nota = &melodia.notas[melodia.proxima++];
+  if (nota->freq_hz) {
+    setup_pwm(melodia.pino, nota->freq_hz, 0.5);
+  } else {
+    stop_pwm(melodia.pino);
+  }
+  return (int64_t)nota->duracao_ms * 1000;
+}
 
-  pwm_set_enabled(slice_num, true); // Ativa o PWM
+void parar_melodia(void) {
+  alarm_id_t alarme = melodia.alarme;
+  if (alarme > 0 && cancel_alarm(alarme)) {
+    stop_pwm(melodia.pino);
+    rastreio_evento(RASTREIO_ATUADOR_FIM, ATUADOR_BUZZER, 0);
+  }
+  melodia.alarme = 0;
 }
 
-void stop_pwm(uint pin) {
-  uint slice_num = pwm_gpio_to_slice_num(pin);
-  uint channel = pwm_gpio_to_channel(pin);
+bool melodia_tocando(void) {
+  return melodia.alarme > 0;
+}
 
-  pwm_set_chan_level(slice_num, channel, 0); // Desativa o PWM
-  pwm_set_enabled(slice_num, false);        // Desativa o slice
+void tocar_melodia(uint pin, const Nota *notas, uint8_t total) {
+  parar_melodia();
+  if (total == 0) return;
+  melodia.pino = pin;
+  melodia.notas = notas;
+  melodia.total = total;
+  melodia.proxima = 0;
+  rastreio_evento(RASTREIO_ATUADOR_INICIO, ATUADOR_BUZZER, notas[0].freq_hz);
+  int64_t duracao_us = avancar_melodia(0, NULL); // a primeira nota começa já
+  melodia.alarme = add_alarm_in_us(duracao_us, avancar_melodia, NULL, true);
 }
 
 void play_tone(uint pin, uint freq, uint duration_ms, float duty_cycle) {
+  parar_melodia(); // o tom bloqueante assume o buzzer
+  rastreio_evento(RASTREIO_ATUADOR_INICIO, ATUADOR_BUZZER, freq);
   setup_pwm(pin, freq, duty_cycle);
   sleep_ms(duration_ms);
   stop_pwm(pin);
+  rastreio_evento(RASTREIO_ATUADOR_FIM, ATUADOR_BUZZER, 0);
 }
 
 void play_error_tone(uint pin) {
@@ -223,9 +235,12 @@ void play_beep_pattern(uint pin, uint freq, uint duration_ms, uint pause_ms, int
 }
 
 void play_success_tone(uint pin) {
-  play_tone(pin, 1000, 500, 0.5); // Tom baixo de sucesso
-  sleep_ms(100);
-  play_tone(pin, 2000, 500, 0.5); // Tom alto de sucesso
+  static const Nota tom_sucesso[] = {
+    {1000, 500}, // Tom baixo de sucesso
+    {0, 100},
+    {2000, 500}, // Tom alto de sucesso
+  };
+  tocar_melodia(pin, tom_sucesso, sizeof(tom_sucesso) / sizeof(tom_sucesso[0]));
 }
 
 void play_coffee_ready(uint pin) {
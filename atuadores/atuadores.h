@@ -27,6 +27,10 @@ void stepper_init(void); // Inicializa os pinos do motor de passo
 void stepper_rotate(bool direction, uint32_t duration_ms, uint32_t step_delay_ms);
 
 //Funções para controle do buzzer
+typedef struct {
+  uint16_t freq_hz;    // 0: pausa
+  uint16_t duracao_ms;
+} Nota;
 // Configura o PWM para o pino especificado com frequência e duty cycle
 void setup_pwm(uint pin, uint freq, float duty_cycle);
 // Para o PWM no pino especificado
@@ -37,7 +41,11 @@ void play_tone(uint pin, uint freq, uint duration_ms, float duty_cycle);
 void play_beep_pattern(uint pin, uint freq, uint duration_ms, uint pause_ms, int repetitions, float duty_cycle);
 // Reproduz um tom de erro
 void play_error_tone(uint pin);
-// Reproduz um tom de sucesso (frequências crescentes)
+// Toca uma sequência de notas em segundo plano (alarme), sem bloquear; substitui a melodia em andamento
+void tocar_melodia(uint pin, const Nota *notas, uint8_t total);
+void parar_melodia(void);
+bool melodia_tocando(void);
+// Reproduz um tom de sucesso (frequências crescentes), em segundo plano
 void play_success_tone(uint pin);
 // Reproduz um som para sinalizar que o café está pronto
 void play_coffee_ready(uint pin);
@@ -0,0 +1,195 @@
+// barra_leds.c
+// Padrões e brilho da barra de LEDs por BAM em um temporizador repetitivo
+
+#include "barra_leds.h"
+#include "pico/stdlib.h"
+#include "hardware/gpio.h"
+#include "hardware/sync.h"
+#include "rastreio.h"
+#include "placa.h"
+#include "hal_gpio.h"
+#include "na_ram.h"
+#include "log_adiado.h"
+
+#define BASE_BAM_US 250 // duração do plano menos significativo
+#define TOTAL_PLANOS 4
+
+static const uint pinos[BARRA_TOTAL_LEDS] = PINOS_BARRA_LEDS;
+
+typedef enum {
+  PADRAO_FIXO,
+  PADRAO_PREENCHER,
+  PADRAO_PISCAR,
+  PADRAO_PULSAR,
+} PadraoBarra;
+
+// Padrão atual (escrito no loop principal com as interrupções desligadas, lido na IRQ)
+static struct {
+  PadraoBarra padrao;
+  uint32_t inicio_us; // piscar e pulsar: início da fase atual, avançado a cada fase concluída
+  int intensidade;
+  uint32_t passo_us;  // preencher: por LED; piscar: meio ciclo; pulsar: período
+  int vezes;
+  uint32_t fase;      // piscar: meios ciclos concluídos
+} atual;
+
+static uint32_t planos[TOTAL_PLANOS]; // saídas de cada plano do BAM
+static int plano = 0;
+static repeating_timer_t temporizador;
+static volatile bool temporizador_ativo = false;
+
+// Brilho de cada LED para uma intensidade total: os LEDs enchem em ordem, o último com a fração
+static void distribuir(int intensidade, uint8_t *niveis) {
+  for (int i = 0; i < BARRA_TOTAL_LEDS; i++) {
+    int n = intensidade - i * (BARRA_NIVEIS - 1);
+    niveis[i] = n <= 0 ? 0 : (n >= BARRA_NIVEIS - 1 ? BARRA_NIVEIS - 1 : n);
+  }
+}
+
+// valor * 256 / total por subtrações (9 bits de quociente), para valor <= total + 1: as divisões da
+// libgcc e do SDK ficam na flash e este cálculo roda no tique
+static inline uint32_t fracao_256(uint32_t valor, uint32_t total) {
+  uint32_t q = 0;
+  for (int b = 0; b < 9; b++) {
+    q <<= 1;
+    if (valor >= total) {
+      valor -= total;
+      q |= 1;
+    }
+    valor <<= 1;
+  }
+  return q;
+}
+
+// Avança o início para a fase corrente; retorna o tempo dentro dela (o resto da divisão, sem dividir)
+static inline uint32_t avancar_fases(uint32_t decorrido_us) {
+  while (decorrido_us >= atual.passo_us) {
+    decorrido_us -= atual.passo_us;
+    atual.inicio_us += atual.passo_us;
+    atual.fase++;
+  }
+  return decorrido_us;
+}
+
+// Calcula o quadro do padrão pelo tempo decorrido; retorna true se o padrão terminou. Roda no tique, na
+// SRAM: só somas, comparações e multiplicações, sem chamadas à flash
+static bool calcular_niveis(uint32_t decorrido_us, uint8_t *niveis) {
+  switch (atual.padrao) {
+    case PADRAO_FIXO:
+      distribuir(atual.intensidade, niveis);
+      return false;
+    case PADRAO_PREENCHER: {
+      uint32_t acesos = 1;
+      for (uint32_t limite = atual.passo_us; acesos < BARRA_TOTAL_LEDS && decorrido_us >= limite;
+           limite += atual.passo_us) {
+        acesos++;
+      }
+      distribuir(atual.intensidade, niveis);
+      for (uint32_t i = acesos; i < BARRA_TOTAL_LEDS; i++) niveis[i] = 0;
+      return acesos >= BARRA_TOTAL_LEDS;
+    }
+    case PADRAO_PISCAR: {
+      avancar_fases(decorrido_us);
+      distribuir(atual.fase % 2 == 0 ? BARRA_MAXIMO : 0, niveis);
+      return atual.fase >= 2u * atual.vezes;
+    }
+    case PADRAO_PULSAR: {
+      uint32_t t = avancar_fases(decorrido_us);
+      uint32_t meio = atual.passo_us / 2;
+      uint32_t escala = (t < meio) ? fracao_256(t, meio) : fracao_256(atual.passo_us - t, meio); // triângulo 0-256
+      distribuir(atual.intensidade, niveis);
+      for (int i = 0; i < BARRA_TOTAL_LEDS; i++) niveis[i] = (niveis[i] * escala) >> 8;
+      return false;
+    }
+  }
+  return true;
+}
+
+// Monta os planos do BAM; retorna true se todos os LEDs estão no mínimo ou no máximo (sem modulação)
+static bool montar_planos(const uint8_t *niveis) {
+  bool binario = true;
+  for (int b = 0; b < TOTAL_PLANOS; b++) planos[b] = 0;
+  for (int i = 0; i < BARRA_TOTAL_LEDS; i++) {
+    for (int b = 0; b < TOTAL_PLANOS; b++) {
+      if (niveis[i] & (1u << b)) planos[b] |= 1u << pinos[i];
+    }
+    if (niveis[i] != 0 && niveis[i] != BARRA_NIVEIS - 1) binario = false;
+  }
+  return binario;
+}
+
+// Tique do BAM: cada chamada acende o plano seguinte e programa a próxima para daqui a 2^plano
+// períodos-base; no início do quadro o padrão é recalculado
+static bool NA_RAM(tique)(repeating_timer_t *t) {
+  if (plano == 0) {
+    uint8_t niveis[BARRA_TOTAL_LEDS];
+    bool fim = calcular_niveis(time_us_32() - atual.inicio_us, niveis); // time_us_32: leitura inline do temporizador
+    if (fim) {
+      rastreio_evento(RASTREIO_ATUADOR_FIM, ATUADOR_BARRA_LEDS, 0);
+      if (atual.padrao == PADRAO_PISCAR) atual.intensidade = 0; // o pisca termina com a barra apagada
+      atual.padrao = PADRAO_FIXO;
+      distribuir(atual.intensidade, niveis);
+    }
+    if (montar_planos(niveis) && atual.padrao == PADRAO_FIXO) {
+      hal_gpio_escrever_mascara(MASCARA_BARRA_LEDS, planos[0]); // estático: uma escrita e o temporizador para
+      temporizador_ativo = false;
+      return false;
+    }
+  }
+  hal_gpio_escrever_mascara(MASCARA_BARRA_LEDS, planos[plano]);
+  t->delay_us = -(int64_t)(BASE_BAM_US << plano);
+  plano = (plano + 1) % TOTAL_PLANOS;
+  return true;
+}
+
+// Troca o padrão e garante o temporizador rodando; o próximo quadro começa imediatamente
+static void iniciar_padrao(PadraoBarra padrao, int intensidade, uint32_t passo_ms, int vezes) {
+  if (intensidade < 0) intensidade = 0;
+  if (intensidade > BARRA_MAXIMO) intensidade = BARRA_MAXIMO;
+  if (passo_ms == 0) passo_ms = 1;
+
+  uint32_t irq = save_and_disable_interrupts();
+  atual.padrao = padrao;
+  atual.inicio_us = time_us_32();
+  atual.intensidade = intensidade;
+  atual.passo_us = passo_ms * 1000;
+  atual.vezes = vezes;
+  atual.fase = 0;
+  plano = 0;
+  bool iniciar = !temporizador_ativo;
+  temporizador_ativo = true;
+  restore_interrupts(irq);
+
+  if (padrao != PADRAO_FIXO) rastreio_evento(RASTREIO_ATUADOR_INICIO, ATUADOR_BARRA_LEDS, intensidade);
+  // Sem alarme livre o padrão não anda: a barra fica apagada e o próximo padrão tenta de novo
+  if (iniciar && !add_repeating_timer_us(-BASE_BAM_US, tique, NULL, &temporizador)) {
+    temporizador_ativo = false;
+    LOG("LED barra sem temporizador (padrao %d)\n", padrao);
+  }
+}
+
+void barra_leds_iniciar(void) {
+  gpio_init_mask(MASCARA_BARRA_LEDS);
+  gpio_set_dir_out_masked(MASCARA_BARRA_LEDS);
+  hal_gpio_escrever_mascara(MASCARA_BARRA_LEDS, 0); // Apaga todos os LEDs no início
+}
+
+void barra_leds_fixar(int intensidade) {
+  iniciar_padrao(PADRAO_FIXO, intensidade, 1, 0);
+}
+
+void barra_leds_preencher(int intensidade, int passo_ms) {
+  iniciar_padrao(PADRAO_PREENCHER, intensidade, passo_ms, 0);
+}
+
+void barra_leds_piscar(int vezes, int intervalo_ms) {
+  iniciar_padrao(PADRAO_PISCAR, BARRA_MAXIMO, intervalo_ms, vezes);
+}
+
+void barra_leds_pulsar(int intensidade, int periodo_ms) {
+  iniciar_padrao(PADRAO_PULSAR, intensidade, periodo_ms < 2 ? 2 : periodo_ms, 0);
+}
+
+bool barra_leds_ocupada(void) {
+  return temporizador_ativo;
+}
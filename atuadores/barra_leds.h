@@ -0,0 +1,26 @@
+// barra_leds.h
+// Driver da barra de 10 LEDs: todos os segmentos são escritos de uma vez (escrita mascarada no SIO) e os
+// padrões (preencher, piscar, pulsar) avançam em um temporizador, sem bloquear quem os inicia.
+// O brilho de cada LED tem 16 níveis por modulação por ângulo de bit (BAM, 4 planos de 250/500/1000/
+// 2000 µs, quadro de 3,75 ms): o PWM não serve porque os pinos 6 e 22 caem no mesmo canal (3A) e o
+// pino 15 divide a fatia 7 com o buzzer, que muda o divisor a cada nota.
+// Com todos os LEDs totalmente acesos ou apagados e nenhum padrão em andamento, o temporizador para.
+
+#ifndef BARRA_LEDS_H
+#define BARRA_LEDS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define BARRA_TOTAL_LEDS 10
+#define BARRA_NIVEIS 16                                  // brilho de 0 a 15 por LED
+#define BARRA_MAXIMO (BARRA_TOTAL_LEDS * (BARRA_NIVEIS - 1)) // 150 passos de intensidade na barra
+
+void barra_leds_iniciar(void);
+void barra_leds_fixar(int intensidade);                          // 0 a BARRA_MAXIMO, sem animação
+void barra_leds_preencher(int intensidade, int passo_ms);        // acende um LED a cada passo até a intensidade
+void barra_leds_piscar(int vezes, int intervalo_ms);             // pisca tudo e termina apagada
+void barra_leds_pulsar(int intensidade, int periodo_ms);         // respira até outro padrão
+bool barra_leds_ocupada(void);                                   // padrão animado ou BAM em andamento
+
+#endif // BARRA_LEDS_H
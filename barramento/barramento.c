@@ -0,0 +1,83 @@
+// barramento.c
+// Perfis de frequência por dispositivo e reserva do barramento I2C
+
+#include "barramento.h"
+#include "pico/stdlib.h"
+#include "hardware/gpio.h"
+#include "hardware/sync.h"
+#include "placa.h"
+
+typedef struct {
+  uint8_t endereco;
+  uint32_t frequencia_hz;
+} PerfilI2C;
+
+static PerfilI2C perfis[] = {
+  {LCD_ADDR, BARRAMENTO_LCD_HZ},
+  {RTC_ADDR, BARRAMENTO_RTC_HZ},
+};
+
+static uint32_t frequencia_atual = 0;
+static uint32_t trocas = 0;
+static volatile uint32_t reservas = 0;
+
+void barramento_iniciar(void) {
+  i2c_init(I2C_PORT, BARRAMENTO_RTC_HZ); // começa na frequência que todos aceitam
+  frequencia_atual = BARRAMENTO_RTC_HZ;
+  gpio_set_function(SDA_PIN, GPIO_FUNC_I2C);
+  gpio_set_function(SCL_PIN, GPIO_FUNC_I2C);
+  // habilita resistores de pull up para comunicação estável
+  gpio_pull_up(SDA_PIN);
+  gpio_pull_up(SCL_PIN);
+}
+
+// Dispositivos sem perfil ficam na frequência mais baixa
+static uint32_t frequencia_do(uint8_t endereco) {
+  for (unsigned i = 0; i < sizeof(perfis) / sizeof(perfis[0]); i++) {
+    if (perfis[i].endereco == endereco) return perfis[i].frequencia_hz;
+  }
+  return BARRAMENTO_RTC_HZ;
+}
+
+// Chamada com o barramento reservado, entre transações (após o STOP da anterior)
+i2c_inst_t *barramento_selecionar(uint8_t endereco) {
+  uint32_t hz = frequencia_do(endereco);
+  if (hz != frequencia_atual) {
+    i2c_set_baudrate(I2C_PORT, hz);
+    frequencia_atual = hz;
+    trocas++;
+  }
+  return I2C_PORT;
+}
+
+// clk_peri mudou (frequencia.c): recalcula os divisores do I2C para a frequência em uso.
+// Chamada com o barramento reservado
+void barramento_recalcular(void) {
+  i2c_set_baudrate(I2C_PORT, frequencia_atual);
+}
+
+void barramento_definir_frequencia(uint8_t endereco, uint32_t hz) {
+  for (unsigned i = 0; i < sizeof(perfis) / sizeof(perfis[0]); i++) {
+    if (perfis[i].endereco == endereco) perfis[i].frequencia_hz = hz;
+  }
+}
+
+uint32_t barramento_trocas_frequencia(void) {
+  return trocas;
+}
+
+void barramento_reservar(void) {
+  uint32_t irq = save_and_disable_interrupts();
+  reservas++;
+  restore_interrupts(irq);
+}
+
+void barramento_liberar(void) {
+  uint32_t irq = save_and_disable_interrupts();
+  if (reservas > 0) reservas--;
+  restore_interrupts(irq);
+}
+
+bool barramento_livre(void) {
+  return reservas == 0;
+}
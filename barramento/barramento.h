@@ -0,0 +1,32 @@
+// barramento.h
+// Barramento I2C compartilhado pelo LCD (PCF8574, 0x27) e pelo RTC (DS1307, 0x68).
+// Cada dispositivo tem um perfil com a frequência máxima que suporta; antes de cada transação o
+// barramento é reconfigurado se o perfil do destino for diferente do atual (o DS1307 só aceita
+// 100 kHz, o LCD roda em Fast-mode). A troca acontece entre transações, com o barramento parado.
+// A reserva impede que as animações do LCD, que escrevem numa IRQ de software, entrem no meio de
+// uma transação ou de uma sequência do loop principal.
+
+#ifndef BARRAMENTO_H
+#define BARRAMENTO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "hardware/i2c.h"
+
+#ifndef BARRAMENTO_LCD_HZ
+#define BARRAMENTO_LCD_HZ (400 * 1000) // a folha do PCF8574 garante 100 kHz; o PCF8574A/T dos módulos e o Wokwi aceitam 400 kHz
+#endif
+#define BARRAMENTO_RTC_HZ (100 * 1000) // DS1307: somente Standard-mode
+
+void barramento_iniciar(void);                                    // i2c0 nos pinos 4 (SDA) e 5 (SCL)
+i2c_inst_t *barramento_selecionar(uint8_t endereco);              // aplica o perfil do dispositivo
+void barramento_definir_frequencia(uint8_t endereco, uint32_t hz); // muda o perfil (benchmark)
+void barramento_recalcular(void);                                 // após mudar clk_peri (frequencia.h)
+uint32_t barramento_trocas_frequencia(void);
+
+// Exclusão entre o loop principal e a IRQ das animações (contador: as reservas podem ser aninhadas)
+void barramento_reservar(void);
+void barramento_liberar(void);
+bool barramento_livre(void);
+
+#endif // BARRAMENTO_H
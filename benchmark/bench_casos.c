@@ -0,0 +1,315 @@
+// bench_casos.c
+// Casos de benchmark compartilhados pelos alvos de medição de desempenho do firmware
+
+#include "bench_casos.h"
+#include <stdio.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hardware/structs/xip_ctrl.h"
+#include "controle_ir.h"
+#include "sensores.h"
+#include "lcd_i2c.h"
+#include "estado.h"
+#include "atuadores.h"
+#include "log_adiado.h"
+#include "tela.h"
+#include "glifos.h"
+#include "barramento.h"
+#include "alocador_pwm.h"
+#include "placa.h"
+#include "armazenamento.h"
+
+// Resultados escritos em variáveis voláteis para o compilador não eliminar as operações medidas
+static volatile uint32_t sumidouro;
+static char texto[32];
+
+// A leitura de FLUSH só retorna depois que o cache terminou de ser invalidado
+void bench_esvaziar_cache_xip(void) {
+  xip_ctrl_hw->flush = 1;
+  (void)xip_ctrl_hw->flush;
+}
+
+void bench_preparar_perifericos(void) {
+  init_i2c_lcd();
+  pwm_alocador_iniciar();
+  init_adc();
+  gpio_init(DHT_PIN);
+}
+
+// -------------------------------------------------------------------------------------------------- //
+// Decodificação do IR (quadro NEC completo da tecla PLAY)
+
+static void ir_callback_vazio(uint16_t address, uint16_t command, int type) {
+  sumidouro += command;
+}
+
+static void preparar_ir(void) {
+  const uint32_t quadro = 0x57A8FF00; // adr 0x00, ~adr, cmd 0xA8 (PLAY), ~cmd (enviado LSB primeiro)
+  user_function_callback = ir_callback_vazio;
+  ir_data.rises[0] = 0;
+  ir_data.rises[1] = 13500; // pulso inicial de 9 ms + espaço de 4,5 ms
+  for (int i = 0; i < 32; i++) {
+    uint32_t espaco = (quadro >> i) & 1 ? ONE_SPACE : ZERO_SPACE;
+    ir_data.rises[i + 2] = ir_data.rises[i + 1] + espaco;
+  }
+  ir_data.cnt = 34;
+}
+
+static void executar_ir(void) {
+  process_ir_data(NORMAL);
+}
+
+// -------------------------------------------------------------------------------------------------- //
+// Entrada na IRQ do IR: a borda de descida vem do override da entrada do pad (sem o receptor), e a
+// medição vai da escrita do override até irq_callback guardar a borda. Com o cache XIP vazio, a
+// diferença entre mínimo e máximo mostra o efeito das faltas (compare com -DCODIGO_NA_RAM=0)
+
+static void preparar_irq_ir(void) {
+  init_ir_irq_receiver(IR_SENSOR_GPIO_PIN, ir_callback_vazio);
+  gpio_set_inover(IR_SENSOR_GPIO_PIN, GPIO_OVERRIDE_HIGH); // nível de repouso do receptor
+}
+
+static void executar_irq_ir(void) {
+  reset_ir_data();
+  gpio_set_inover(IR_SENSOR_GPIO_PIN, GPIO_OVERRIDE_LOW);
+  while (*(volatile size_t *)&ir_data.cnt == 0) { // escrito pela IRQ
+    tight_loop_contents();
+  }
+  gpio_set_inover(IR_SENSOR_GPIO_PIN, GPIO_OVERRIDE_HIGH); // borda de subida: sem IRQ
+}
+
+// -------------------------------------------------------------------------------------------------- //
+// DHT22: apenas a decodificação dos 40 bits (a leitura depende do sensor real)
+
+static void executar_decodificar_dht(void) {
+  static const int dados[5] = {0x03, 0x57, 0x01, 0x39, 0x94}; // 85,5% e 31,3 °C, checksum válido
+  dht_reading leitura;
+  decodificar_dht(dados, 40, &leitura);
+  sumidouro += (uint32_t)leitura.temp_celsius;
+}
+
+// -------------------------------------------------------------------------------------------------- //
+// LCD, RTC e formatação
+
+static void executar_lcd_send_char(void) {
+  lcd_send_char('A');
+}
+
+static void executar_lcd_set_cursor(void) {
+  lcd_set_cursor(1, 5);
+}
+
+// Redesenho completo: limpa a tela e escreve as 4 linhas de 20 colunas
+static void executar_redesenho_tela(void) {
+  lcd_clear();
+  for (int linha = 0; linha < LCD_ROWS; linha++) {
+    lcd_set_cursor(linha, 0);
+    lcd_print("12345678901234567890");
+  }
+}
+
+static void executar_lcd_print(void) {
+  lcd_set_cursor(0, 0);
+  lcd_print("HOW MANY CUPS?");
+}
+
+// Tela declarativa com três campos: sem mudança nenhum byte vai ao I2C; com uma fonte alterada,
+// apenas o campo correspondente é reescrito
+static FonteDados fonte_bench[3];
+
+static void formatar_bench(char *destino, size_t tamanho) {
+  snprintf(destino, tamanho, "%02d:%02d", 14, 45);
+}
+
+static const Campo campos_bench[] = {
+  {2, 0, 14, &fonte_bench[0], formatar_bench},
+  {3, 0, 15, &fonte_bench[1], formatar_bench},
+  {3, 15, 5, &fonte_bench[2], formatar_bench},
+};
+static uint32_t versoes_bench[TOTAL_ITENS(campos_bench)];
+static const Tela tela_bench = {NULL, 0, campos_bench, TOTAL_ITENS(campos_bench), versoes_bench};
+
+static void executar_tela_sem_mudanca(void) {
+  tela_atualizar(&tela_bench);
+}
+
+static void executar_tela_um_campo(void) {
+  fonte_publicar(&fonte_bench[2]);
+  tela_atualizar(&tela_bench);
+}
+
+// Tela cheia (80 caracteres, todos diferentes do quadro anterior) em cada frequência do LCD;
+// caracteres por segundo = 80 / tempo por repetição
+static void preparar_tela_cheia_100k(void) {
+  barramento_definir_frequencia(LCD_ADDR, 100 * 1000);
+}
+
+static void preparar_tela_cheia_400k(void) {
+  barramento_definir_frequencia(LCD_ADDR, BARRAMENTO_LCD_HZ);
+}
+
+static void executar_tela_cheia(void) {
+  static bool alternar = false;
+  const char *texto = alternar ? "ABCDEFGHIJKLMNOPQRST" : "abcdefghijklmnopqrst";
+  alternar = !alternar;
+  for (int linha = 0; linha < LCD_ROWS; linha++) {
+    lcd_compor(linha, 0, texto, LCD_COLS);
+  }
+}
+
+static void executar_rtc_read(void) {
+  uint8_t rtc_data[7];
+  rtc_read(I2C_PORT, SDA_PIN, SCL_PIN, rtc_data);
+  sumidouro += rtc_data[1];
+}
+
+static void executar_format_time(void) {
+  uint8_t rtc_data[7] = {0x30, 0x45, 0x14, 0x02, 0x19, 0x10, 0x26};
+  char hora[64], data[64];
+  format_time(rtc_data, hora, data);
+  sumidouro += hora[0] + data[0];
+}
+
+static void executar_formatar_estoque(void) {
+  snprintf(texto, sizeof(texto), "B:%.0fg|W:%.2fL", 240.0f, 850.0f / 1000);
+  sumidouro += texto[2];
+}
+
+static void executar_formatar_ambiente(void) {
+  snprintf(texto, sizeof(texto), "%.1fC|H:%.1f%%", 31.3f, 85.5f);
+  sumidouro += texto[0];
+}
+
+static void executar_formatar_relogio(void) {
+  snprintf(texto, sizeof(texto), "%02d:%02d", 14, 45);
+  sumidouro += texto[0];
+}
+
+// Mesmo conteúdo do relógio pelo log adiado: nada é formatado no firmware.
+// O buffer é esvaziado antes; 4 palavras por registro cabem nas repetições do caso.
+static void preparar_log_adiado(void) {
+  log_adiado_limpar();
+}
+
+static void executar_log_adiado(void) {
+  LOG("%02d:%02d\n", 14, 45);
+}
+
+// -------------------------------------------------------------------------------------------------- //
+// ADC, DHT22 e buzzer
+
+static void executar_adc_read(void) {
+  adc_select_input(0);
+  sumidouro += adc_read();
+}
+
+// Caminho completo de leitura de um potenciômetro (seleção, estabilização, leitura descartada)
+static void executar_ler_intensidade(void) {
+  sumidouro += ler_intensidade();
+}
+
+static void executar_read_from_dht(void) {
+  dht_reading leitura;
+  read_from_dht(&leitura, DHT_PIN);
+  sumidouro += (uint32_t)leitura.humidity;
+}
+
+// Configuração de um tom com duty cycle zero, para medir o custo sem acionar o buzzer
+static void executar_setup_pwm(void) {
+  setup_pwm(BUZZER_PIN, 1000, 0.0f);
+}
+
+// -------------------------------------------------------------------------------------------------- //
+// Glifos da CGRAM: acerto no cache (nenhuma escrita) e barra de progresso avançando uma coluna de pixel
+
+static void executar_glifo_acerto(void) {
+  sumidouro += glifo_caractere(GLIFO_XICARA);
+}
+
+static int porcentagem_bench = 0;
+
+static void preparar_barra(void) {
+  lcd_clear();
+  porcentagem_bench = 0;
+}
+
+static void executar_barra(void) {
+  glifos_barra(1, 0, LCD_COLS, porcentagem_bench);
+  porcentagem_bench = (porcentagem_bench + 1) % 101;
+}
+
+// -------------------------------------------------------------------------------------------------- //
+// Passo da máquina de estados sem mudança de tela (caminho mais frequente do loop principal)
+
+static void preparar_passo_estado(void) {
+  estado_iniciar(ESTADO_QUANTIDADE_XICARAS);
+}
+
+static void executar_passo_estado(void) {
+  gerenciar_estado();
+}
+
+// -------------------------------------------------------------------------------------------------- //
+// Registro na flash: gravação na RAM e descarga de um registro (uma programação de página, com as
+// interrupções desligadas). A cada ~250 descargas o setor enche e a descarga seguinte inclui a
+// compactação e o apagamento, que aparecem no máximo; o relatório ARMZ traz os registros por apagamento.
+// No alvo da placa o registro fica nos setores de rascunho (FLASH_BENCH_INICIO, placa.h), e a chave
+// do estoque gravada aqui não é a do firmware
+
+static uint32_t valor_bench = 0;
+
+static void preparar_armazenamento(void) {
+  armazenamento_iniciar();
+}
+
+static void executar_armazenamento_gravar(void) {
+  valor_bench++;
+  armazenamento_gravar(CHAVE_AGUA_ML, &valor_bench, sizeof(valor_bench));
+}
+
+static void executar_armazenamento_descarga(void) {
+  executar_armazenamento_gravar();
+  armazenamento_descarregar();
+}
+
+static void relatar_armazenamento(void) {
+  armazenamento_solicitar_relatorio();
+  armazenamento_servico();
+}
+
+// -------------------------------------------------------------------------------------------------- //
+
+const CasoBench casos_bench[] = {
+  // nome                 preparação             operação                    iter  pausa  só hw  frio
+  {"process_ir_data",     preparar_ir,           executar_ir,                1000, 0,     false, false},
+  {"process_ir_data_frio", preparar_ir,          executar_ir,                500,  0,     true,  true},
+  {"irq_ir_borda",        preparar_irq_ir,       executar_irq_ir,            500,  0,     true,  false},
+  {"irq_ir_borda_frio",   preparar_irq_ir,       executar_irq_ir,            500,  0,     true,  true},
+  {"decodificar_dht",     NULL,                  executar_decodificar_dht,   1000, 0,     false, false},
+  {"lcd_send_char",       NULL,                  executar_lcd_send_char,     200,  0,     false, false},
+  {"lcd_set_cursor",      NULL,                  executar_lcd_set_cursor,    200,  0,     false, false},
+  {"lcd_print_14",        NULL,                  executar_lcd_print,         100,  0,     false, false},
+  {"redesenho_tela",      NULL,                  executar_redesenho_tela,    20,   0,     false, false},
+  {"tela_sem_mudanca",    NULL,                  executar_tela_sem_mudanca,  200,  0,     false, false},
+  {"tela_um_campo",       NULL,                  executar_tela_um_campo,     200,  0,     false, false},
+  {"tela_cheia_100k",     preparar_tela_cheia_100k, executar_tela_cheia,     50,   0,     false, false},
+  {"tela_cheia_400k",     preparar_tela_cheia_400k, executar_tela_cheia,     50,   0,     false, false},
+  {"glifo_acerto",        NULL,                  executar_glifo_acerto,      1000, 0,     false, false},
+  {"barra_progresso",     preparar_barra,        executar_barra,             100,  0,     false, false},
+  {"rtc_read",            NULL,                  executar_rtc_read,          100,  0,     false, false},
+  {"format_time",         NULL,                  executar_format_time,       200,  0,     false, false},
+  {"snprintf_estoque",    NULL,                  executar_formatar_estoque,  200,  0,     false, false},
+  {"snprintf_ambiente",   NULL,                  executar_formatar_ambiente, 200,  0,     false, false},
+  {"snprintf_relogio",    NULL,                  executar_formatar_relogio,  200,  0,     false, false},
+  {"log_adiado",          preparar_log_adiado,   executar_log_adiado,        100,  0,     false, false},
+  {"adc_read",            NULL,                  executar_adc_read,          500,  0,     false, false},
+  {"ler_intensidade",     NULL,                  executar_ler_intensidade,   100,  0,     false, false},
+  {"read_from_dht",       NULL,                  executar_read_from_dht,     10,   2000,  true,  false},
+  {"setup_pwm",           NULL,                  executar_setup_pwm,         200,  0,     false, false},
+  {"gerenciar_estado",    preparar_passo_estado, executar_passo_estado,      1000, 0,     false, false},
+  {"armz_gravar",         NULL,                  executar_armazenamento_gravar, 1000, 0,  false, false},
+  {"armz_descarga",       preparar_armazenamento, executar_armazenamento_descarga, 600, 0, true, false,
+   relatar_armazenamento, true},
+};
+
+const size_t total_casos_bench = sizeof(casos_bench) / sizeof(casos_bench[0]);
@@ -0,0 +1,31 @@
+// bench_casos.h
+// Casos de benchmark compartilhados pelos alvos de medição de desempenho do firmware
+// Cada caso tem uma preparação (fora da medição) e uma operação repetida N vezes dentro da medição.
+
+#ifndef BENCH_CASOS_H
+#define BENCH_CASOS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+typedef struct {
+  const char *nome;          // identificador estável, usado nos relatórios e na comparação entre versões
+  void (*preparar)(void);    // executado uma vez antes da medição (pode ser NULL)
+  void (*executar)(void);    // operação medida
+  uint32_t iteracoes;        // repetições por medição
+  uint32_t pausa_ms;         // pausa entre repetições, fora da medição (o DHT22 exige 2 s entre leituras)
+  bool somente_hardware;     // depende de periférico real (ex.: DHT22), pulado no emulador
+  bool cache_frio;           // esvazia o cache XIP antes de cada repetição, fora da medição (só na placa)
+  void (*relatar)(void);     // métricas próprias do caso, impressas após a medição (pode ser NULL)
+  bool uma_vez;              // só na primeira rodada da placa (desgasta a flash de rascunho)
+} CasoBench;
+
+extern const CasoBench casos_bench[];
+extern const size_t total_casos_bench;
+
+// Inicializa os periféricos usados pelos casos (I2C/LCD, ADC, GPIOs)
+void bench_preparar_perifericos(void);
+void bench_esvaziar_cache_xip(void);
+
+#endif // BENCH_CASOS_H
@@ -0,0 +1,49 @@
+// bench_emulador.c
+// Firmware de benchmark para execução no emulador RP2040 (rp2040js) com periféricos simulados
+// Compilado no lugar de main.c com COFFEETIME_BENCH_EMULADOR definido. Cada medição é delimitada
+// por instruções BKPT que o executor (ferramentas/bench_emulador.mjs) intercepta para ler o
+// contador de ciclos do núcleo emulado:
+//   bkpt #1  início do caso (r0 = índice, r1 = iterações, r2 = ponteiro para o nome)
+//   bkpt #2  fim do caso
+//   bkpt #3  fim de todos os casos
+
+#if defined(COFFEETIME_BENCH_EMULADOR)
+
+#include "pico/stdlib.h"
+#include "bench_casos.h"
+
+#if defined(__arm__)
+#define MARCADOR_EMULADOR(n, a0, a1, a2) do {                  \
+    register uint32_t r0 __asm("r0") = (uint32_t)(a0);         \
+    register uint32_t r1 __asm("r1") = (uint32_t)(a1);         \
+    register uint32_t r2 __asm("r2") = (uint32_t)(a2);         \
+    __asm volatile("bkpt #" #n :: "r"(r0), "r"(r1), "r"(r2) : "memory"); \
+  } while (0)
+#else
+#define MARCADOR_EMULADOR(n, a0, a1, a2) do { } while (0)
+#endif
+
+int main() {
+  stdio_init_all();
+  bench_preparar_perifericos();
+
+  for (size_t c = 0; c < total_casos_bench; c++) {
+    const CasoBench *caso = &casos_bench[c];
+    if (caso->somente_hardware) continue;
+    if (caso->preparar) caso->preparar();
+
+    MARCADOR_EMULADOR(1, c, caso->iteracoes, caso->nome);
+    for (uint32_t i = 0; i < caso->iteracoes; i++) {
+      caso->executar();
+    }
+    MARCADOR_EMULADOR(2, c, 0, 0);
+  }
+
+  MARCADOR_EMULADOR(3, 0, 0, 0);
+  while (true) {
+    tight_loop_contents();
+  }
+  return 0;
+}
+
+#endif // COFFEETIME_BENCH_EMULADOR
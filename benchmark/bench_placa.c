@@ -0,0 +1,105 @@
+// bench_placa.c
+// Firmware de microbenchmark para a Pico real, com contagem de ciclos pelo SysTick
+// Compilado no lugar de main.c com COFFEETIME_BENCH_PLACA definido. Cada repetição de um caso é
+// medida isoladamente e o resultado (mín/mediana/máx em ciclos) é enviado pela USB em linhas
+// "BENCH;nome;n;min;mediana;max;mediana_us", comparáveis com ferramentas/comparar_bench.py.
+
+#if defined(COFFEETIME_BENCH_PLACA)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "pico/stdlib.h"
+#include "pico/stdio_usb.h"
+#include "hardware/clocks.h"
+#include "hardware/structs/systick.h"
+#include "bench_casos.h"
+
+#define MAX_AMOSTRAS 1000     // limite de repetições por caso
+#define AQUECIMENTO 3         // repetições descartadas antes da medição (cache XIP, primeira transação)
+#define SYSTICK_MASCARA 0x00FFFFFF
+
+static uint32_t amostras[MAX_AMOSTRAS];
+static uint32_t custo_medicao = 0; // ciclos gastos pela própria leitura do SysTick
+
+// SysTick decrescente de 24 bits no clock do processador, sem interrupção
+static void systick_iniciar() {
+  systick_hw->csr = 0;
+  systick_hw->rvr = SYSTICK_MASCARA;
+  systick_hw->cvr = 0;
+  systick_hw->csr = 0x5; // CLKSOURCE = processador, ENABLE
+}
+
+// Diferença entre duas leituras do contador decrescente (válida para operações de até 2^24 ciclos,
+// cerca de 134 ms a 125 MHz)
+static inline uint32_t ciclos_entre(uint32_t inicio, uint32_t fim) {
+  return (inicio - fim) & SYSTICK_MASCARA;
+}
+
+static int comparar_u32(const void *a, const void *b) {
+  uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+  return (x > y) - (x < y);
+}
+
+// Menor custo de duas leituras consecutivas, descontado de todas as amostras
+static void calibrar() {
+  custo_medicao = SYSTICK_MASCARA;
+  for (int i = 0; i < 100; i++) {
+    uint32_t inicio = systick_hw->cvr;
+    uint32_t fim = systick_hw->cvr;
+    uint32_t ciclos = ciclos_entre(inicio, fim);
+    if (ciclos < custo_medicao) custo_medicao = ciclos;
+  }
+}
+
+static void medir_caso(const CasoBench *caso) {
+  uint32_t n = caso->iteracoes < MAX_AMOSTRAS ? caso->iteracoes : MAX_AMOSTRAS;
+  if (caso->preparar) caso->preparar();
+
+  for (int i = 0; i < AQUECIMENTO; i++) {
+    if (caso->cache_frio) bench_esvaziar_cache_xip();
+    caso->executar();
+    if (caso->pausa_ms) sleep_ms(caso->pausa_ms);
+  }
+
+  for (uint32_t i = 0; i < n; i++) {
+    if (caso->cache_frio) bench_esvaziar_cache_xip();
+    uint32_t inicio = systick_hw->cvr;
+    caso->executar();
+    uint32_t fim = systick_hw->cvr;
+    uint32_t ciclos = ciclos_entre(inicio, fim);
+    amostras[i] = ciclos > custo_medicao ? ciclos - custo_medicao : 0;
+    if (caso->pausa_ms) sleep_ms(caso->pausa_ms);
+  }
+
+  qsort(amostras, n, sizeof(amostras[0]), comparar_u32);
+  uint32_t mediana = amostras[n / 2];
+  uint32_t ciclos_por_us = clock_get_hz(clk_sys) / 1000000;
+  printf("BENCH;%s;%lu;%lu;%lu;%lu;%.2f\n", caso->nome, (unsigned long)n,
+         (unsigned long)amostras[0], (unsigned long)mediana, (unsigned long)amostras[n - 1],
+         (double)mediana / ciclos_por_us);
+  if (caso->relatar) caso->relatar();
+}
+
+int main() {
+  stdio_init_all();
+  while (!stdio_usb_connected()) {
+    sleep_ms(100); // aguarda o terminal serial para não perder o relatório
+  }
+  bench_preparar_perifericos();
+  systick_iniciar();
+  calibrar();
+
+  for (uint32_t rodada = 0; true; rodada++) {
+    printf("BENCH_INICIO;clk_sys_hz=%lu;custo_medicao=%lu\n",
+           (unsigned long)clock_get_hz(clk_sys), (unsigned long)custo_medicao);
+    for (size_t c = 0; c < total_casos_bench; c++) {
+      if (casos_bench[c].uma_vez && rodada > 0) continue; // casos que gravam a flash: só na primeira
+      medir_caso(&casos_bench[c]);
+    }
+    printf("BENCH_FIM\n");
+    sleep_ms(10000);
+  }
+  return 0;
+}
+
+#endif // COFFEETIME_BENCH_PLACA
@@ -2,9 +2,17 @@
 
 #include "pico/stdlib.h"
 #include "hardware/gpio.h"
+#include "hardware/irq.h"
+#include "hardware/structs/timer.h"
+#include "hardware/regs/addressmap.h"
+#include "hardware/regs/m0plus.h"
 #include <string.h>
 #include <stdint.h>
 #include "controle_ir.h"
+#include "gravador.h"
+#include "rastreio.h"
+#include "latencia.h"
+#include "na_ram.h"
 
 struct _ir_data ir_data;
 
@@ -13,7 +21,24 @@ uint16_t __last_command = 0x0;
 
 void (*user_function_callback) (uint16_t address, uint16_t command, int type) = NULL;
 
-void reset_ir_data() {
+// Quadros validados à espera da entrega. A IRQ do GPIO só mede as bordas e decodifica, da SRAM; o
+// gravador, a latência e o callback do usuário ficam na flash e rodam depois, em uma IRQ de software de
+// prioridade mínima que as bordas do quadro seguinte podem interromper. Um produtor (IRQ do GPIO) e um
+// consumidor (IRQ de entrega) no mesmo núcleo: os índices bastam, sem travas
+#define QUADROS_PENDENTES 4 // potência de 2
+
+typedef struct {
+    uint16_t address, command;
+    int type;
+    uint64_t borda_us; // primeira borda do quadro, para a medição de latência
+} QuadroIr;
+
+static QuadroIr quadros[QUADROS_PENDENTES];
+static volatile uint32_t quadros_escritos = 0;
+static volatile uint32_t quadros_entregues = 0;
+static int irq_entrega = -1;
+
+void NA_RAM(reset_ir_data)() {
     ir_data.cnt = 0;
 
     size_t i = 0;
@@ -22,26 +47,72 @@ void reset_ir_data() {
     }
 }
 
-void process_ir_data(int type) {
+// Espaço dentro da tolerância de 15% do protocolo, em aritmética inteira (sem ponto flutuante da flash)
+#define DENTRO_DA_TOLERANCIA(us, espaco) ((us) * 100 > (espaco) * 85 && (us) * 100 < (espaco) * 115)
+
+// Espaço entre bordas em 32 bits, saturado logo acima de MAXIMUM_SPACE (fora de todas as tolerâncias)
+static inline uint32_t espaco_us(uint64_t diff) {
+    return diff > MAXIMUM_SPACE ? MAXIMUM_SPACE + 1 : (uint32_t)diff;
+}
+
+// time_us_64 lido direto do temporizador: a função do SDK fica na flash e uma falta no cache XIP
+// atrasaria a marca de tempo da borda
+static inline uint64_t instante_us(void) {
+    uint32_t alto = timer_hw->timerawh;
+    while (true) {
+        uint32_t baixo = timer_hw->timerawl;
+        uint32_t alto_depois = timer_hw->timerawh;
+        if (alto_depois == alto) return ((uint64_t)alto << 32) | baixo;
+        alto = alto_depois; // a parte baixa deu a volta entre as leituras
+    }
+}
+
+// Fila cheia: o quadro é descartado, como um quadro com erro de transmissão
+static void NA_RAM(enfileirar_quadro)(uint16_t address, uint16_t command, int type, uint64_t borda_us) {
+    rastreio_evento(RASTREIO_IR_QUADRO, command, type);
+    uint32_t escritos = quadros_escritos;
+    if (escritos - quadros_entregues >= QUADROS_PENDENTES) return;
+    QuadroIr *q = &quadros[escritos & (QUADROS_PENDENTES - 1)];
+    q->address = address;
+    q->command = command;
+    q->type = type;
+    q->borda_us = borda_us;
+    quadros_escritos = escritos + 1;
+    // irq_set_pending fica na flash: a mesma escrita no NVIC, direto
+    if (irq_entrega >= 0) *(io_rw_32 *)(PPB_BASE + M0PLUS_NVIC_ISPR_OFFSET) = 1u << irq_entrega;
+}
+
+// IRQ de entrega: roda da flash, depois que a IRQ do GPIO retorna
+static void entregar_quadros(void) {
+    while (quadros_entregues != quadros_escritos) {
+        QuadroIr q = quadros[quadros_entregues & (QUADROS_PENDENTES - 1)];
+        quadros_entregues++;
+        gravador_ir(q.address, q.command, q.type);
+        if (q.type == NORMAL) latencia_quadro_ir(q.borda_us, q.command);
+        user_function_callback(q.address, q.command, q.type);
+    }
+}
+
+void NA_RAM(process_ir_data)(int type) {
     // If it's a repeat code, just send the previous command.
     if (type == REPEAT) {
-        user_function_callback(__last_address, __last_command, type);
+        enfileirar_quadro(__last_address, __last_command, type, ir_data.rises[0]);
         return;
     }
 
-    uint64_t diff;
+    uint32_t diff;
     uint32_t raw = 0x0;
 
     size_t i = 2;
     for (; i < 34; ++i) {
         // Compute differences between pulses
-        diff = ir_data.rises[i] - ir_data.rises[i - 1];
+        diff = espaco_us(ir_data.rises[i] - ir_data.rises[i - 1]);
 
         // Should be a zero
-        if (diff > 0.85 * ZERO_SPACE && diff < 1.15 * ZERO_SPACE)
+        if (DENTRO_DA_TOLERANCIA(diff, ZERO_SPACE))
             raw >>= 1;
         // Should be a one
-        else if (diff > 0.85 * ONE_SPACE && diff < 1.15 * ONE_SPACE) {
+        else if (DENTRO_DA_TOLERANCIA(diff, ONE_SPACE)) {
             raw >>= 1;
             raw |= 0x80000000;
         }
@@ -68,15 +139,15 @@ void process_ir_data(int type) {
 
     __last_address = data.adr;
     __last_command = data.cmd;
-    user_function_callback(data.adr, data.cmd, NORMAL);
+    enfileirar_quadro(data.adr, data.cmd, NORMAL, ir_data.rises[0]); // rises[0]: primeira borda de descida
 }
 
-void irq_callback(uint32_t gpio, uint32_t events) {
-    uint64_t current_time = time_us_64();
+void NA_RAM(irq_callback)(uint32_t gpio, uint32_t events) {
+    uint64_t current_time = instante_us();
 
     // The space between the pulses is too big
     if (ir_data.cnt > 0) {
-        uint64_t diff = current_time - ir_data.rises[ir_data.cnt - 1];
+        uint32_t diff = espaco_us(current_time - ir_data.rises[ir_data.cnt - 1]);
 
         // Check if this is a bad message
         if (diff > MAXIMUM_SPACE) {
@@ -84,7 +155,7 @@ void irq_callback(uint32_t gpio, uint32_t events) {
             ir_data.rises[0] = current_time;
         }
         // Check if it is a repeat message
-        else if (ir_data.cnt == 1 && diff > 0.85 * REPEAT_SPACE && diff < 1.15 * REPEAT_SPACE) {
+        else if (ir_data.cnt == 1 && DENTRO_DA_TOLERANCIA(diff, REPEAT_SPACE)) {
             process_ir_data(REPEAT);
             reset_ir_data();
         }
@@ -106,6 +177,14 @@ void init_ir_irq_receiver(uint32_t gpio, void (*callback) (uint16_t address, uin
     // Set the user callback function
     user_function_callback = callback;
 
+    // IRQ de software que entrega os quadros ao callback
+    if (irq_entrega < 0) {
+        irq_entrega = user_irq_claim_unused(true);
+        irq_set_exclusive_handler(irq_entrega, entregar_quadros);
+        irq_set_priority(irq_entrega, PICO_LOWEST_IRQ_PRIORITY);
+        irq_set_enabled(irq_entrega, true);
+    }
+
     // Init the sdk
     gpio_set_irq_enabled_with_callback(gpio, GPIO_IRQ_EDGE_FALL, true, &irq_callback);
 }
@@ -0,0 +1,305 @@
+// gravador.c
+// Gravação e reprodução das entradas da máquina (IR, ADC, DHT22, RTC) e das transições de estado
+
+#include "gravador.h"
+#include <stdio.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "pico/time.h"
+#include "hardware/sync.h"
+#include "controle_ir.h"
+
+// Uma gravação gerada pelo host (ferramentas/gravacao.py gerar-c) pode ser ligada ao firmware;
+// se estiver presente, a máquina reproduz a gravação em vez de gravar uma nova sessão.
+extern const uint8_t gravacao_reproducao[] __attribute__((weak));
+extern const uint32_t gravacao_reproducao_tamanho __attribute__((weak));
+
+static const uint8_t cabecalho[4] = {'C', 'T', 'G', 1}; // assinatura + versão do formato
+
+static uint8_t buffer[GRAVADOR_TAMANHO_BUFFER];
+static size_t usado = 0;
+static bool truncado = false;        // buffer encheu e parte da sessão foi descartada
+static volatile ModoGravador modo = GRAVADOR_DESLIGADO;
+static volatile bool descarga_pendente = false;
+static uint32_t inicio_ms = 0;       // instante de início da gravação/reprodução
+static uint32_t ultimo_ms = 0;       // instante relativo do último registro gravado
+
+// Últimos valores gravados, para registrar os sensores apenas quando mudam
+static int32_t ultimo_adc[3] = {-1, -1, -1};
+static int16_t ultimo_dht[2];
+static bool dht_gravado = false;
+static uint8_t ultimo_rtc[7];
+static bool rtc_gravado = false;
+
+// Estado da reprodução: cursor na gravação e valores vigentes de cada sensor
+static const uint8_t *repr_dados = NULL;
+static size_t repr_tamanho = 0;
+static size_t repr_pos = 0;
+static uint32_t repr_ms = 0;
+static int32_t repr_adc[3] = {-1, -1, -1};
+static int16_t repr_dht[2];
+static bool repr_dht_valido = false;
+static uint8_t repr_rtc[7];
+static bool repr_rtc_valido = false;
+static alarm_id_t repr_alarme = 0;
+static volatile bool repr_concluida = false;
+
+// Tamanho da carga útil de cada tipo de registro (-1 para tipos desconhecidos)
+static int tamanho_carga(uint8_t tipo) {
+  switch (tipo) {
+    case GRAV_TEMPO: return 4;
+    case GRAV_IR: return 3;
+    case GRAV_ADC: return 3;
+    case GRAV_DHT: return 4;
+    case GRAV_RTC: return 7;
+    case GRAV_ESTADO: return 2;
+    case GRAV_TELA: return 0;
+    default: return -1;
+  }
+}
+
+static uint32_t agora_ms() {
+  return to_ms_since_boot(get_absolute_time()) - inicio_ms;
+}
+
+// Acrescenta um registro ao buffer. Pode ser chamada tanto do loop principal quanto de IRQ.
+// Durante a reprodução o buffer também é usado, guardando a linha do tempo produzida pelo firmware
+// (IR injetado, estados e telas) para ser comparada com a da gravação original.
+static void escrever_registro(uint8_t tipo, const uint8_t *carga, size_t tamanho) {
+  if (modo == GRAVADOR_DESLIGADO) return;
+
+  uint32_t irq = save_and_disable_interrupts();
+  uint32_t t = agora_ms();
+  uint32_t delta = t - ultimo_ms;
+  size_t necessario = 3 + tamanho + (delta > 0xFFFF ? 7 : 0);
+
+  if (usado + necessario > sizeof(buffer)) {
+    truncado = true;
+  } else {
+    if (delta > 0xFFFF) { // delta não cabe em 16 bits: grava o tempo absoluto antes
+      uint8_t *p = &buffer[usado];
+      p[0] = GRAV_TEMPO; p[1] = 0; p[2] = 0;
+      p[3] = t; p[4] = t >> 8; p[5] = t >> 16; p[6] = t >> 24;
+      usado += 7;
+      delta = 0;
+    }
+    buffer[usado++] = tipo;
+    buffer[usado++] = delta & 0xFF;
+    buffer[usado++] = delta >> 8;
+    if (tamanho > 0) memcpy(&buffer[usado], carga, tamanho);
+    usado += tamanho;
+    ultimo_ms = t;
+  }
+  restore_interrupts(irq);
+}
+
+// -------------------------------------------------------------------------------------------------- //
+// Controle da gravação
+
+// Zera o buffer e o relógio relativo, comum à gravação e à reprodução
+static void reiniciar_buffer(ModoGravador novo_modo) {
+  uint32_t irq = save_and_disable_interrupts();
+  memcpy(buffer, cabecalho, sizeof(cabecalho));
+  usado = sizeof(cabecalho);
+  truncado = false;
+  inicio_ms = to_ms_since_boot(get_absolute_time());
+  ultimo_ms = 0;
+  for (int i = 0; i < 3; i++) ultimo_adc[i] = -1;
+  dht_gravado = false;
+  rtc_gravado = false;
+  modo = novo_modo;
+  restore_interrupts(irq);
+}
+
+void gravador_iniciar_gravacao(void) {
+  gravador_parar();
+  reiniciar_buffer(GRAVADOR_GRAVANDO);
+}
+
+void gravador_parar(void) {
+  if (repr_alarme > 0) {
+    cancel_alarm(repr_alarme);
+    repr_alarme = 0;
+  }
+  modo = GRAVADOR_DESLIGADO;
+}
+
+ModoGravador gravador_modo(void) {
+  return modo;
+}
+
+// Inicia a reprodução da gravação ligada ao firmware ou, se não houver, uma nova gravação
+void gravador_iniciar(void) {
+  if (&gravacao_reproducao_tamanho != NULL && gravacao_reproducao != NULL) {
+    gravador_iniciar_reproducao(gravacao_reproducao, gravacao_reproducao_tamanho);
+  } else {
+    gravador_iniciar_gravacao();
+  }
+}
+
+// Envia o buffer pela USB em linhas "GRAV <hex>", capturadas pelo host com ferramentas/gravacao.py
+void gravador_descarregar_usb(void) {
+  printf("GRAV INICIO %u%s\n", (unsigned)usado, truncado ? " TRUNCADO" : "");
+  for (size_t i = 0; i < usado; i += 32) {
+    printf("GRAV ");
+    for (size_t j = i; j < i + 32 && j < usado; j++) {
+      printf("%02x", buffer[j]);
+    }
+    printf("\n");
+  }
+  printf("GRAV FIM\n");
+}
+
+// Pedido de descarga vindo do callback do IR; a descarga em si roda no loop principal
+void gravador_solicitar_descarga(void) {
+  descarga_pendente = true;
+}
+
+void gravador_servico(void) {
+  if (repr_concluida) {
+    repr_concluida = false;
+    printf("Reprodução da gravação concluída em %lu ms\n", (unsigned long)agora_ms());
+  }
+  if (descarga_pendente) {
+    descarga_pendente = false;
+    gravador_descarregar_usb();
+  }
+}
+
+// -------------------------------------------------------------------------------------------------- //
+// Reprodução
+
+// Aplica os registros cujo instante já chegou. Roda no contexto do alarme, como a IRQ do IR real.
+static int64_t reproduzir_alarme(alarm_id_t id, void *user_data) {
+  uint32_t t = agora_ms();
+
+  while (repr_pos + 3 <= repr_tamanho) {
+    const uint8_t *p = &repr_dados[repr_pos];
+    int carga = tamanho_carga(p[0]);
+    if (carga < 0 || repr_pos + 3 + carga > repr_tamanho) { // gravação corrompida: encerra
+      repr_pos = repr_tamanho;
+      break;
+    }
+
+    uint32_t instante = (p[0] == GRAV_TEMPO)
+                        ? (uint32_t)(p[3] | (p[4] << 8) | (p[5] << 16) | ((uint32_t)p[6] << 24))
+                        : repr_ms + (p[1] | (p[2] << 8));
+    if (instante > t) {
+      return (int64_t)(instante - t) * 1000; // reagenda para o próximo registro
+    }
+    repr_ms = instante;
+
+    const uint8_t *c = p + 3;
+    switch (p[0]) {
+      case GRAV_IR:
+        gravador_ir(c[0], c[1], c[2]);
+        if (user_function_callback) user_function_callback(c[0], c[1], c[2]);
+        break;
+      case GRAV_ADC:
+        if (c[0] < 3) repr_adc[c[0]] = c[1] | (c[2] << 8);
+        break;
+      case GRAV_DHT:
+        repr_dht[0] = (int16_t)(c[0] | (c[1] << 8));
+        repr_dht[1] = (int16_t)(c[2] | (c[3] << 8));
+        repr_dht_valido = true;
+        break;
+      case GRAV_RTC:
+        memcpy(repr_rtc, c, 7);
+        repr_rtc_valido = true;
+        break;
+      default: // tempo, estado e tela são apenas informativos na reprodução
+        break;
+    }
+    repr_pos += 3 + carga;
+  }
+
+  repr_concluida = true; // avisado pelo loop principal, fora da IRQ
+  repr_alarme = 0;
+  return 0;
+}
+
+void gravador_iniciar_reproducao(const uint8_t *dados, size_t tamanho) {
+  gravador_parar();
+  if (tamanho < sizeof(cabecalho) || memcmp(dados, cabecalho, sizeof(cabecalho)) != 0) {
+    printf("Gravação inválida para reprodução\n");
+    return;
+  }
+
+  repr_dados = dados;
+  repr_tamanho = tamanho;
+  repr_pos = sizeof(cabecalho);
+  repr_ms = 0;
+  for (int i = 0; i < 3; i++) repr_adc[i] = -1;
+  repr_dht_valido = false;
+  repr_rtc_valido = false;
+  reiniciar_buffer(GRAVADOR_REPRODUZINDO);
+  repr_alarme = add_alarm_in_ms(0, reproduzir_alarme, NULL, true);
+}
+
+// -------------------------------------------------------------------------------------------------- //
+// Pontos de gravação
+
+void gravador_ir(uint16_t address, uint16_t command, int type) {
+  uint8_t carga[3] = {address, command, type};
+  escrever_registro(GRAV_IR, carga, sizeof(carga));
+}
+
+uint16_t gravador_adc(uint8_t canal, uint16_t valor_lido) {
+  if (canal >= 3) return valor_lido;
+
+  if (modo == GRAVADOR_REPRODUZINDO) {
+    return repr_adc[canal] >= 0 ? (uint16_t)repr_adc[canal] : valor_lido;
+  }
+  if (ultimo_adc[canal] != valor_lido) {
+    uint8_t carga[3] = {canal, valor_lido & 0xFF, valor_lido >> 8};
+    escrever_registro(GRAV_ADC, carga, sizeof(carga));
+    ultimo_adc[canal] = valor_lido;
+  }
+  return valor_lido;
+}
+
+// Converte para décimos, a mesma resolução entregue pelo DHT22
+static int16_t para_decimos(float valor) {
+  return (int16_t)(valor * 10 + (valor >= 0 ? 0.5f : -0.5f));
+}
+
+void gravador_dht(dht_reading *leitura) {
+  if (modo == GRAVADOR_REPRODUZINDO) {
+    if (repr_dht_valido) {
+      leitura->humidity = (float)repr_dht[0] / 10;
+      leitura->temp_celsius = (float)repr_dht[1] / 10;
+    }
+    return;
+  }
+
+  int16_t valores[2] = {para_decimos(leitura->humidity), para_decimos(leitura->temp_celsius)};
+  if (!dht_gravado || valores[0] != ultimo_dht[0] || valores[1] != ultimo_dht[1]) {
+    uint8_t carga[4] = {valores[0] & 0xFF, (uint16_t)valores[0] >> 8, valores[1] & 0xFF, (uint16_t)valores[1] >> 8};
+    escrever_registro(GRAV_DHT, carga, sizeof(carga));
+    ultimo_dht[0] = valores[0];
+    ultimo_dht[1] = valores[1];
+    dht_gravado = true;
+  }
+}
+
+void gravador_rtc(uint8_t *rtc_data) {
+  if (modo == GRAVADOR_REPRODUZINDO) {
+    if (repr_rtc_valido) memcpy(rtc_data, repr_rtc, 7);
+    return;
+  }
+
+  if (!rtc_gravado || memcmp(rtc_data, ultimo_rtc, 7) != 0) {
+    escrever_registro(GRAV_RTC, rtc_data, 7);
+    memcpy(ultimo_rtc, rtc_data, 7);
+    rtc_gravado = true;
+  }
+}
+
+void gravador_estado(uint8_t anterior, uint8_t novo) {
+  uint8_t carga[2] = {anterior, novo};
+  escrever_registro(GRAV_ESTADO, carga, sizeof(carga));
+}
+
+void gravador_tela(void) {
+  escrever_registro(GRAV_TELA, NULL, 0);
+}
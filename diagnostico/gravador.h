@@ -0,0 +1,54 @@
+// gravador.h
+// Gravação e reprodução das entradas da máquina (IR, ADC, DHT22, RTC) e das transições de estado
+// A gravação é um buffer binário compacto na RAM, descarregado pela USB e convertido no host
+// com ferramentas/gravacao.py. A reprodução injeta os mesmos eventos no mesmo instante relativo,
+// o que permite comparar duas versões do firmware com a mesma sessão de uso.
+
+#ifndef GRAVADOR_H
+#define GRAVADOR_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "sensores.h"
+
+#ifndef GRAVADOR_TAMANHO_BUFFER
+#define GRAVADOR_TAMANHO_BUFFER 8192 // bytes de RAM reservados para a gravação
+#endif
+
+// Tipos de registro (1 byte de tipo + 2 bytes de delta em ms + carga útil fixa)
+typedef enum {
+  GRAV_TEMPO = 0x01,   // u32: tempo absoluto em ms (emitido quando o delta não cabe em 16 bits)
+  GRAV_IR = 0x02,      // u8 endereço, u8 comando, u8 tipo (NORMAL/REPEAT)
+  GRAV_ADC = 0x03,     // u8 canal, u16 valor bruto
+  GRAV_DHT = 0x04,     // i16 umidade x10, i16 temperatura x10
+  GRAV_RTC = 0x05,     // 7 bytes BCD lidos do DS1307
+  GRAV_ESTADO = 0x06,  // u8 estado anterior, u8 estado novo
+  GRAV_TELA = 0x07,    // sem carga: o display foi limpo para desenhar uma nova tela
+} TipoGravacao;
+
+typedef enum {
+  GRAVADOR_DESLIGADO,
+  GRAVADOR_GRAVANDO,
+  GRAVADOR_REPRODUZINDO,
+} ModoGravador;
+
+void gravador_iniciar(void);                                        // Reproduz a gravação ligada ao firmware ou grava
+void gravador_iniciar_gravacao(void);                               // Zera o buffer e começa a gravar
+void gravador_iniciar_reproducao(const uint8_t *dados, size_t tamanho); // Reproduz uma gravação
+void gravador_parar(void);
+ModoGravador gravador_modo(void);
+void gravador_descarregar_usb(void);                                // Envia o buffer pela USB em hexadecimal
+void gravador_solicitar_descarga(void);                             // Pede a descarga (seguro em IRQ)
+void gravador_servico(void);                                        // Executa a descarga pendente no loop principal
+
+// Pontos de gravação. Em modo reprodução, as funções de sensores substituem o valor lido
+// pelo valor gravado mais recente, no mesmo instante relativo da gravação.
+void gravador_ir(uint16_t address, uint16_t command, int type);
+uint16_t gravador_adc(uint8_t canal, uint16_t valor_lido);
+void gravador_dht(dht_reading *leitura);
+void gravador_rtc(uint8_t *rtc_data);
+void gravador_estado(uint8_t anterior, uint8_t novo);
+void gravador_tela(void);
+
+#endif // GRAVADOR_H
@@ -0,0 +1,220 @@
+// latencia.c
+// Medição de latência de ponta a ponta do controle IR até a atualização do LCD
+
+#include "latencia.h"
+#include <stdio.h>
+#include "pico/stdlib.h"
+#include "hardware/sync.h"
+#include "controle_ir.h"
+#include "lcd_i2c.h"
+#include "estado.h"
+
+#define TOTAL_TECLAS 20
+#define LINHA_TODAS TOTAL_TECLAS   // linha extra do histograma com todas as teclas
+#define TOTAL_FAIXAS 104           // 4 sub-faixas por oitava, até 2^26 µs (~67 s)
+#define TEMPO_LIMITE_US 10000000   // sem reação em 10 s: a tecla não mudou o display
+#define TEMPO_TELA_US 3000000      // a tela de diagnóstico fica 3 s no display
+
+// Comandos NEC do controle, na mesma ordem de get_key_name
+static const uint8_t comandos[TOTAL_TECLAS] = {
+  0xA2, 0xE2, 0x22, 0x02, 0xC2, 0xE0, 0xA8, 0x90, 0x68, 0x98,
+  0xB0, 0x30, 0x18, 0x7A, 0x10, 0x38, 0x5A, 0x42, 0x4A, 0x52
+};
+
+static uint16_t histograma[TOTAL_TECLAS + 1][TOTAL_FAIXAS];
+static uint32_t amostras[TOTAL_TECLAS + 1];
+static uint32_t sem_resposta = 0;
+static uint64_t soma_trechos_us[TOTAL_MARCOS + 1]; // borda->decodificado->callback->reação->LCD
+static uint32_t max_trechos_us[TOTAL_MARCOS + 1];
+
+// Medição em andamento (escrita pela IRQ do IR e concluída no loop principal)
+static volatile bool pendente = false;
+static volatile bool reagiu = false;
+static int tecla_pendente;
+static uint64_t borda_pendente_us;
+static uint64_t marcos_us[TOTAL_MARCOS];
+
+static volatile bool relatorio_pendente = false;
+static volatile bool tela_pendente = false;
+
+// Tela de diagnóstico no display: até quando, e em que estado foi aberta
+static uint64_t tela_ate_us = 0;
+static Estado estado_da_tela;
+
+static int indice_tecla(uint16_t command) {
+  for (int i = 0; i < TOTAL_TECLAS; i++) {
+    if (comandos[i] == command) return i;
+  }
+  return -1;
+}
+
+// Faixa logarítmica do valor: 4 sub-faixas por potência de 2 (erro máximo de ~19% no percentil)
+static int faixa(uint32_t us) {
+  if (us < 4) return us;
+  int e = 31 - __builtin_clz(us);
+  int b = 4 * (e - 1) + ((us >> (e - 2)) & 3);
+  return b < TOTAL_FAIXAS ? b : TOTAL_FAIXAS - 1;
+}
+
+// Maior valor em µs que cai na faixa
+static uint32_t limite_faixa(int b) {
+  if (b < 4) return b;
+  int e = b / 4 + 1;
+  return ((uint32_t)(4 + b % 4 + 1) << (e - 2)) - 1;
+}
+
+// -------------------------------------------------------------------------------------------------- //
+// Pontos de medição
+
+void latencia_quadro_ir(uint64_t borda_us, uint16_t command) {
+  int tecla = indice_tecla(command);
+  if (tecla < 0) return;
+
+  if (pendente) sem_resposta++; // a tecla anterior não chegou a mudar o display
+  tecla_pendente = tecla;
+  borda_pendente_us = borda_us;
+  marcos_us[MARCO_DECODIFICADO] = time_us_64();
+  marcos_us[MARCO_CALLBACK] = 0;
+  marcos_us[MARCO_REACAO] = 0;
+  reagiu = false;
+  pendente = true;
+}
+
+void latencia_marco(MarcoLatencia marco) {
+  if (!pendente || marcos_us[marco] != 0) return;
+  marcos_us[marco] = time_us_64();
+  if (marco == MARCO_REACAO) reagiu = true;
+}
+
+void latencia_escrita_lcd(void) {
+  if (!reagiu) return; // caminho rápido: nenhuma tecla aguardando a atualização do display
+
+  uint32_t irq = save_and_disable_interrupts();
+  if (pendente && reagiu) {
+    uint64_t agora = time_us_64();
+    uint32_t total = (uint32_t)(agora - borda_pendente_us);
+
+    // Trechos entre marcos consecutivos (um marco ausente é somado ao trecho seguinte)
+    uint64_t anterior = borda_pendente_us;
+    for (int m = 0; m <= TOTAL_MARCOS; m++) {
+      uint64_t instante = (m < TOTAL_MARCOS) ? marcos_us[m] : agora;
+      if (instante == 0) continue;
+      uint32_t trecho = (uint32_t)(instante - anterior);
+      soma_trechos_us[m] += trecho;
+      if (trecho > max_trechos_us[m]) max_trechos_us[m] = trecho;
+      anterior = instante;
+    }
+
+    int b = faixa(total);
+    if (histograma[tecla_pendente][b] < UINT16_MAX) histograma[tecla_pendente][b]++;
+    if (histograma[LINHA_TODAS][b] < UINT16_MAX) histograma[LINHA_TODAS][b]++;
+    amostras[tecla_pendente]++;
+    amostras[LINHA_TODAS]++;
+    pendente = false;
+  }
+  reagiu = false;
+  restore_interrupts(irq);
+}
+
+// -------------------------------------------------------------------------------------------------- //
+// Consulta e relatórios
+
+static uint32_t percentil_linha(int linha, uint8_t percentil) {
+  uint32_t n = amostras[linha];
+  if (n == 0) return 0;
+  uint32_t alvo = (n * percentil + 99) / 100; // posição (1..n) da amostra do percentil
+  uint32_t acumulado = 0;
+  for (int b = 0; b < TOTAL_FAIXAS; b++) {
+    acumulado += histograma[linha][b];
+    if (acumulado >= alvo) return limite_faixa(b);
+  }
+  return limite_faixa(TOTAL_FAIXAS - 1);
+}
+
+uint32_t latencia_percentil(uint16_t command, uint8_t percentil) {
+  int linha = (command == 0xFFFF) ? LINHA_TODAS : indice_tecla(command);
+  return linha < 0 ? 0 : percentil_linha(linha, percentil);
+}
+
+void latencia_solicitar_relatorio(void) {
+  relatorio_pendente = true;
+}
+
+void latencia_solicitar_tela(void) {
+  tela_pendente = true;
+}
+
+static void imprimir_relatorio() {
+  static const char *trechos[TOTAL_MARCOS + 1] = {"borda->decodificado", "->callback", "->reacao", "->LCD"};
+
+  printf("LAT INICIO sem_resposta=%lu\n", (unsigned long)sem_resposta);
+  for (int linha = 0; linha <= TOTAL_TECLAS; linha++) {
+    if (amostras[linha] == 0) continue;
+    printf("LAT %-8s n=%lu p50=%lu p90=%lu p99=%lu max=%lu us\n",
+           linha == LINHA_TODAS ? "TODAS" : get_key_name(comandos[linha]),
+           (unsigned long)amostras[linha],
+           (unsigned long)percentil_linha(linha, 50), (unsigned long)percentil_linha(linha, 90),
+           (unsigned long)percentil_linha(linha, 99), (unsigned long)percentil_linha(linha, 100));
+  }
+  if (amostras[LINHA_TODAS] > 0) {
+    for (int m = 0; m <= TOTAL_MARCOS; m++) {
+      printf("LAT trecho %-20s media=%lu max=%lu us\n", trechos[m],
+             (unsigned long)(soma_trechos_us[m] / amostras[LINHA_TODAS]), (unsigned long)max_trechos_us[m]);
+    }
+  }
+  printf("LAT FIM\n");
+}
+
+// Tela de diagnóstico com os percentis de todas as teclas, em ms
+static void exibir_tela() {
+  char linha[LCD_COLS + 1];
+  lcd_clear();
+  lcd_set_cursor(0, 0);
+  lcd_print("IR->LCD LATENCY ms");
+  snprintf(linha, sizeof(linha), "N:%lu P50:%lu", (unsigned long)amostras[LINHA_TODAS],
+           (unsigned long)(percentil_linha(LINHA_TODAS, 50) / 1000));
+  lcd_set_cursor(1, 0);
+  lcd_print(linha);
+  snprintf(linha, sizeof(linha), "P95:%lu P99:%lu", (unsigned long)(percentil_linha(LINHA_TODAS, 95) / 1000),
+           (unsigned long)(percentil_linha(LINHA_TODAS, 99) / 1000));
+  lcd_set_cursor(2, 0);
+  lcd_print(linha);
+  snprintf(linha, sizeof(linha), "MAX:%lu LOST:%lu", (unsigned long)(percentil_linha(LINHA_TODAS, 100) / 1000),
+           (unsigned long)sem_resposta);
+  lcd_set_cursor(3, 0);
+  lcd_print(linha);
+  // O loop segue rodando; latencia_servico devolve o display ao estado quando o prazo vence
+  tela_ate_us = time_us_64() + TEMPO_TELA_US;
+  estado_da_tela = estado_corrente();
+}
+
+bool latencia_tela_visivel(void) {
+  return tela_ate_us != 0;
+}
+
+void latencia_servico(void) {
+  if (pendente && time_us_64() - borda_pendente_us > TEMPO_LIMITE_US) {
+    uint32_t irq = save_and_disable_interrupts();
+    if (pendente && time_us_64() - borda_pendente_us > TEMPO_LIMITE_US) {
+      pendente = false;
+      reagiu = false;
+      sem_resposta++;
+    }
+    restore_interrupts(irq);
+  }
+  if (relatorio_pendente) {
+    relatorio_pendente = false;
+    imprimir_relatorio();
+  }
+  if (tela_pendente) {
+    tela_pendente = false;
+    exibir_tela();
+  } else if (tela_ate_us != 0) {
+    // Uma tecla que mudou o estado já desenhou a própria tela; senão, volta à tela do estado atual
+    if (estado_corrente() != estado_da_tela) tela_ate_us = 0;
+    else if (time_us_64() >= tela_ate_us) {
+      tela_ate_us = 0;
+      estado_redesenhar();
+    }
+  }
+}
@@ -0,0 +1,33 @@
+// latencia.h
+// Medição de latência de ponta a ponta do controle IR: da primeira borda de descida do quadro NEC
+// até a escrita I2C que muda o display em resposta à tecla.
+// Marcos intermediários: quadro decodificado, callback_ir, mudança de estado em gerenciar_estado.
+// Os resultados ficam em histogramas por tecla, com percentis, exibidos no LCD (tecla MENU na tela
+// inicial) ou enviados pela USB (tecla TEST). Funciona igual na placa e na simulação do Wokwi.
+
+#ifndef LATENCIA_H
+#define LATENCIA_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef enum {
+  MARCO_DECODIFICADO, // o quadro validado saiu da fila do IR (controle_ir.c)
+  MARCO_CALLBACK,     // callback_ir tratou a tecla
+  MARCO_REACAO,       // o firmware reagiu: mudou de estado ou começou uma nova tela
+  TOTAL_MARCOS,
+} MarcoLatencia;
+
+void latencia_quadro_ir(uint64_t borda_us, uint16_t command); // início: quadro NEC válido recebido
+void latencia_marco(MarcoLatencia marco);                     // marcos intermediários
+void latencia_escrita_lcd(void);                              // fim: escrita I2C no LCD após a reação
+
+// Percentil (0-100) da latência total de uma tecla em µs; command 0xFFFF agrega todas as teclas
+uint32_t latencia_percentil(uint16_t command, uint8_t percentil);
+
+void latencia_solicitar_relatorio(void);  // relatório pela USB (seguro em IRQ)
+void latencia_solicitar_tela(void);       // tela de diagnóstico no LCD (seguro em IRQ)
+bool latencia_tela_visivel(void);         // a tela de diagnóstico ainda ocupa o display
+void latencia_servico(void);              // executa os pedidos pendentes no loop principal
+
+#endif // LATENCIA_H
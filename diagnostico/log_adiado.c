@@ -0,0 +1,75 @@
+// log_adiado.c
+// Buffer circular de registros do log adiado e envio pelo stdio (USB ou UART)
+
+#include "log_adiado.h"
+#include <stdio.h>
+#include <stdbool.h>
+#include "pico/stdlib.h"
+#if LIB_PICO_STDIO_USB
+#include "pico/stdio_usb.h"
+#endif
+#include "hardware/sync.h"
+
+#define MASCARA (LOG_TAMANHO_BUFFER - 1)
+#define BASE_FLASH 0x10000000u
+#define REGISTROS_POR_SERVICO 16 // limita o tempo gasto a cada volta do loop principal
+
+// Registro: [total << 24 | endereço do formato - BASE_FLASH][time_us_32()][argumentos...]
+static uint32_t buffer[LOG_TAMANHO_BUFFER];
+static uint32_t cabeca = 0;
+static uint32_t cauda = 0;
+static uint32_t perdidos = 0; // registros descartados com o buffer cheio
+
+// Com o buffer cheio o registro novo é descartado, para que o fluxo continue decodificável
+void log_adiado_gravar(const char *formato, uint32_t total, uint32_t a0, uint32_t a1, uint32_t a2, uint32_t a3) {
+  uint32_t irq = save_and_disable_interrupts();
+  if (LOG_TAMANHO_BUFFER - (cabeca - cauda) < total + 2) {
+    perdidos++;
+    restore_interrupts(irq);
+    return;
+  }
+  buffer[cabeca++ & MASCARA] = (total << 24) | (((uint32_t)(uintptr_t)formato - BASE_FLASH) & 0xFFFFFF);
+  buffer[cabeca++ & MASCARA] = time_us_32();
+  if (total > 0) buffer[cabeca++ & MASCARA] = a0;
+  if (total > 1) buffer[cabeca++ & MASCARA] = a1;
+  if (total > 2) buffer[cabeca++ & MASCARA] = a2;
+  if (total > 3) buffer[cabeca++ & MASCARA] = a3;
+  restore_interrupts(irq);
+}
+
+void log_adiado_limpar(void) {
+  uint32_t irq = save_and_disable_interrupts();
+  cauda = cabeca;
+  perdidos = 0;
+  restore_interrupts(irq);
+}
+
+// Envia até REGISTROS_POR_SERVICO registros em linhas "LOG <palavras hex>". Com stdio na USB e sem
+// terminal conectado os registros ficam no buffer (inclusive os do boot); na UART (Wokwi) não há como
+// saber se alguém escuta, e o envio é sempre feito
+void log_adiado_servico(void) {
+#if LIB_PICO_STDIO_USB
+  if (!stdio_usb_connected()) return;
+#endif
+
+  if (perdidos > 0) {
+    uint32_t irq = save_and_disable_interrupts();
+    uint32_t n = perdidos;
+    perdidos = 0;
+    restore_interrupts(irq);
+    printf("LOG PERDIDOS %lu\n", (unsigned long)n);
+  }
+
+  for (int r = 0; r < REGISTROS_POR_SERVICO && cauda != cabeca; r++) {
+    uint32_t palavras[6];
+    uint32_t irq = save_and_disable_interrupts();
+    uint32_t total = (buffer[cauda & MASCARA] >> 24) + 2;
+    for (uint32_t i = 0; i < total; i++) palavras[i] = buffer[(cauda + i) & MASCARA];
+    cauda += total;
+    restore_interrupts(irq);
+
+    printf("LOG");
+    for (uint32_t i = 0; i < total; i++) printf(" %08lx", (unsigned long)palavras[i]);
+    printf("\n");
+  }
+}
@@ -0,0 +1,50 @@
+// log_adiado.h
+// Log adiado (formatação no host): cada chamada LOG guarda apenas o endereço da string de formato, que
+// fica na flash, a marca de tempo e os argumentos brutos de 32 bits em um buffer na RAM. Nada é
+// formatado no firmware; o loop principal envia os registros pelo stdio em hexadecimal e
+// ferramentas/log_adiado.py reconstrói o texto lendo as strings de formato do ELF.
+// Custo por chamada: algumas dezenas de ciclos, seguro em IRQ.
+//
+// Restrições: até 4 argumentos; o formato deve ser um literal; inteiros de até 32 bits; float e double
+// são guardados como float; %s só é decodificado para strings constantes (na flash).
+
+#ifndef LOG_ADIADO_H
+#define LOG_ADIADO_H
+
+#include <stdint.h>
+#include <string.h>
+
+#ifndef LOG_TAMANHO_BUFFER
+#define LOG_TAMANHO_BUFFER 512 // palavras de 32 bits (potência de 2)
+#endif
+
+void log_adiado_gravar(const char *formato, uint32_t total, uint32_t a0, uint32_t a1, uint32_t a2, uint32_t a3);
+void log_adiado_servico(void); // envia os registros pendentes, no loop principal
+void log_adiado_limpar(void);  // descarta os registros pendentes
+
+// Conversão de cada argumento para 32 bits conforme o tipo
+static inline uint32_t log_inteiro(uint32_t v) { return v; }
+static inline uint32_t log_real(double v) {
+  float f = (float)v;
+  uint32_t u;
+  memcpy(&u, &f, sizeof(u));
+  return u;
+}
+static inline uint32_t log_ponteiro(const void *p) { return (uint32_t)(uintptr_t)p; }
+
+#define LOG_BRUTO(x) _Generic((x),                 \
+    float: log_real, double: log_real,               \
+    char *: log_ponteiro, const char *: log_ponteiro, \
+    default: log_inteiro)(x)
+
+#define LOG_0(f)             log_adiado_gravar(f, 0, 0, 0, 0, 0)
+#define LOG_1(f, a)          log_adiado_gravar(f, 1, LOG_BRUTO(a), 0, 0, 0)
+#define LOG_2(f, a, b)       log_adiado_gravar(f, 2, LOG_BRUTO(a), LOG_BRUTO(b), 0, 0)
+#define LOG_3(f, a, b, c)    log_adiado_gravar(f, 3, LOG_BRUTO(a), LOG_BRUTO(b), LOG_BRUTO(c), 0)
+#define LOG_4(f, a, b, c, d) log_adiado_gravar(f, 4, LOG_BRUTO(a), LOG_BRUTO(b), LOG_BRUTO(c), LOG_BRUTO(d))
+#define LOG_SELECIONAR(_0, _1, _2, _3, _4, nome, ...) nome
+
+// LOG("formato", args...) com a mesma sintaxe do printf
+#define LOG(...) LOG_SELECIONAR(__VA_ARGS__, LOG_4, LOG_3, LOG_2, LOG_1, LOG_0, _)(__VA_ARGS__)
+
+#endif // LOG_ADIADO_H
@@ -0,0 +1,189 @@
+// monitor.c
+// Monitor de prazos por estado e por rotina, com estouros, pior caso e alimentação do watchdog
+
+#include "monitor.h"
+#include <stdio.h>
+#include "pico/stdlib.h"
+#include "hardware/sync.h"
+#include "hardware/watchdog.h"
+#include "rastreio.h"
+
+#define PROFUNDIDADE_MAXIMA 6     // trechos aninhados (estado -> rotina -> leitura -> IRQ)
+#define LIMITE_CICLO_MS 2000      // loop principal parado por mais que isso sem trecho que o justifique
+#define SEM_LIMITE 0              // espera pelo usuário: nunca reinicia pelo watchdog
+#define MARCA_SCRATCH 0xD1A60000u // scratch[3]: trecho que segurou o watchdog antes do reinício
+
+typedef struct {
+  const char *nome;
+  uint32_t orcamento_ms; // meta de resposta; acima disso conta como estouro
+  uint32_t limite_ms;    // acima disso o monitor deixa o watchdog reiniciar a placa
+} PrazoTrecho;
+
+// Orçamentos: telas interativas devem responder em 100 ms; as rotinas que esperam o usuário têm o
+// orçamento do próprio tempo limite. O preparo completo leva cerca de 20 s.
+static const PrazoTrecho prazos[TOTAL_TRECHOS] = {
+  [TRECHO_TELA_INICIAL]       = {"TELA_INICIAL",       100,  10000},
+  [TRECHO_QUANTIDADE_XICARAS] = {"QUANTIDADE_XICARAS", 100,  10000},
+  [TRECHO_QUANDO_PREPARAR]    = {"QUANDO_PREPARAR",    100,  10000},
+  [TRECHO_PREPARANDO]         = {"PREPARANDO",       30000, SEM_LIMITE}, // verificação espera o PLAY
+  [TRECHO_PROGRAMANDO]        = {"PROGRAMANDO",     120000, SEM_LIMITE}, // data inválida espera o PLAY
+  [TRECHO_AGUARDANDO]         = {"AGUARDANDO",         100,  10000},
+  [TRECHO_CALLBACK_IR]        = {"CALLBACK_IR",          1,   5000},
+  [TRECHO_LER_DIGITO]         = {"LER_DIGITO",       30100,  35000},
+  [TRECHO_CONFIGURAR_HORARIO] = {"CONFIGURAR_HORARIO", 120000, SEM_LIMITE},
+  [TRECHO_VERIFICAR_RECURSOS] = {"VERIFICAR_RECURSOS",  5000, SEM_LIMITE},
+  [TRECHO_LEITURA_RTC]        = {"LEITURA_RTC",          5,   1000},
+  [TRECHO_LEITURA_DHT]        = {"LEITURA_DHT",         10,   1000},
+};
+
+static EstatisticaTrecho estatisticas[TOTAL_TRECHOS];
+
+// Pilha de trechos ativos; uma IRQ empilha e desempilha antes de retornar, então a ordem se mantém
+static struct {
+  uint8_t trecho;
+  bool estouro_avisado; // estouro já registrado pela verificação periódica
+  uint64_t inicio_us;
+} ativos[PROFUNDIDADE_MAXIMA];
+static volatile int profundidade = 0;
+static volatile uint64_t ultimo_ciclo_us = 0;
+
+static repeating_timer_t temporizador;
+static bool verificando = false; // temporizador da verificação ligado
+static volatile bool relatorio_pendente = false;
+static bool iniciado = false;
+
+void monitor_entrar(TrechoMonitor trecho) {
+  uint32_t irq = save_and_disable_interrupts();
+  if (profundidade < PROFUNDIDADE_MAXIMA) {
+    ativos[profundidade].trecho = trecho;
+    ativos[profundidade].estouro_avisado = false;
+    ativos[profundidade].inicio_us = time_us_64();
+  }
+  profundidade++; // conta mesmo além do limite para manter o pareamento com monitor_sair
+  restore_interrupts(irq);
+}
+
+void monitor_sair(TrechoMonitor trecho) {
+  uint32_t irq = save_and_disable_interrupts();
+  if (profundidade > 0) profundidade--;
+  if (profundidade < PROFUNDIDADE_MAXIMA && ativos[profundidade].trecho == trecho) {
+    uint64_t duracao = time_us_64() - ativos[profundidade].inicio_us;
+    uint32_t us = duracao > UINT32_MAX ? UINT32_MAX : (uint32_t)duracao;
+    EstatisticaTrecho *e = &estatisticas[trecho];
+    e->entradas++;
+    e->soma_us += us;
+    if (us > e->pior_us) e->pior_us = us;
+    if (us > prazos[trecho].orcamento_ms * 1000) {
+      e->estouros++;
+      if (!ativos[profundidade].estouro_avisado) rastreio_evento(RASTREIO_PRAZO_ESTOURADO, trecho, us);
+    }
+  }
+  restore_interrupts(irq);
+}
+
+void monitor_ciclo(void) {
+  ultimo_ciclo_us = time_us_64();
+}
+
+// Verificação periódica (IRQ do alarme): registra estouros em andamento e decide se alimenta o watchdog
+static bool verificar(repeating_timer_t *t) {
+  uint64_t agora = time_us_64();
+  bool saudavel = agora - ultimo_ciclo_us < LIMITE_CICLO_MS * 1000ull;
+  int topo = profundidade < PROFUNDIDADE_MAXIMA ? profundidade : PROFUNDIDADE_MAXIMA;
+
+  for (int i = 0; i < topo; i++) {
+    const PrazoTrecho *p = &prazos[ativos[i].trecho];
+    uint64_t decorrido = agora - ativos[i].inicio_us;
+    if (!ativos[i].estouro_avisado && decorrido > p->orcamento_ms * 1000ull) {
+      ativos[i].estouro_avisado = true;
+      rastreio_evento(RASTREIO_PRAZO_ESTOURADO, ativos[i].trecho, (uint32_t)decorrido);
+    }
+  }
+  if (!saudavel && topo > 0) { // loop parado: vale o limite do trecho mais interno em andamento
+    const PrazoTrecho *p = &prazos[ativos[topo - 1].trecho];
+    saudavel = p->limite_ms == SEM_LIMITE || agora - ativos[topo - 1].inicio_us < p->limite_ms * 1000ull;
+  }
+
+#if MONITOR_WATCHDOG_MS > 0
+  if (saudavel) {
+    watchdog_update();
+  } else if (topo > 0) {
+    watchdog_hw->scratch[3] = MARCA_SCRATCH | ativos[topo - 1].trecho;
+  }
+#else
+  (void)saudavel;
+#endif
+  return true;
+}
+
+void monitor_iniciar(void) {
+  if (iniciado) return;
+  iniciado = true;
+  for (int i = 0; i < TOTAL_TRECHOS; i++) estatisticas[i].orcamento_us = prazos[i].orcamento_ms * 1000;
+  ultimo_ciclo_us = time_us_64();
+
+  if (watchdog_caused_reboot() && (watchdog_hw->scratch[3] & 0xFFFF0000u) == MARCA_SCRATCH) {
+    uint32_t trecho = watchdog_hw->scratch[3] & 0xFFFF;
+    printf("MON reinicio pelo watchdog em %s\n", trecho < TOTAL_TRECHOS ? prazos[trecho].nome : "?");
+  }
+  watchdog_hw->scratch[3] = 0;
+
+  verificando = add_repeating_timer_ms(-MONITOR_VERIFICACAO_MS, verificar, NULL, &temporizador);
+#if MONITOR_WATCHDOG_MS > 0
+  watchdog_enable(MONITOR_WATCHDOG_MS, true); // pausa durante a depuração
+#endif
+}
+
+// Durante o sono o núcleo só acorda pelos alarmes do próprio sono: a última verificação alimenta o
+// watchdog, e o loop volta a monitor_retomar antes de MONITOR_WATCHDOG_MS (passos de sono de 1 s)
+void monitor_pausar(void) {
+  if (!verificando) return;
+  cancel_repeating_timer(&temporizador);
+  verificando = false;
+  verificar(NULL);
+}
+
+void monitor_retomar(void) {
+  if (!iniciado || verificando) return;
+  verificar(NULL);
+  verificando = add_repeating_timer_ms(-MONITOR_VERIFICACAO_MS, verificar, NULL, &temporizador);
+}
+
+void monitor_estatisticas(TrechoMonitor trecho, EstatisticaTrecho *saida) {
+  uint32_t irq = save_and_disable_interrupts();
+  *saida = estatisticas[trecho];
+  restore_interrupts(irq);
+}
+
+void monitor_zerar(void) {
+  uint32_t irq = save_and_disable_interrupts();
+  for (int i = 0; i < TOTAL_TRECHOS; i++) {
+    estatisticas[i].entradas = estatisticas[i].estouros = estatisticas[i].pior_us = 0;
+    estatisticas[i].soma_us = 0;
+  }
+  restore_interrupts(irq);
+}
+
+void monitor_solicitar_relatorio(void) {
+  relatorio_pendente = true;
+}
+
+static void imprimir_relatorio() {
+  printf("MON INICIO\n");
+  for (int i = 0; i < TOTAL_TRECHOS; i++) {
+    EstatisticaTrecho e;
+    monitor_estatisticas(i, &e);
+    if (e.entradas == 0) continue;
+    printf("MON %-18s n=%lu media=%lu pior=%lu orcamento=%lu estouros=%lu us\n", prazos[i].nome,
+           (unsigned long)e.entradas, (unsigned long)(e.soma_us / e.entradas), (unsigned long)e.pior_us,
+           (unsigned long)e.orcamento_us, (unsigned long)e.estouros);
+  }
+  printf("MON FIM\n");
+}
+
+void monitor_servico(void) {
+  if (relatorio_pendente) {
+    relatorio_pendente = false;
+    imprimir_relatorio();
+  }
+}
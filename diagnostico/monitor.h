@@ -0,0 +1,61 @@
+// monitor.h
+// Monitor de prazos: cada estado da máquina e cada rotina longa (callback do IR, leitura de dígito,
+// agendamento, verificação de recursos, leituras do RTC e do DHT22) tem um orçamento de tempo.
+// monitor_entrar/monitor_sair marcam o início e o fim de cada trecho (aninháveis, inclusive em IRQ);
+// a saída conta os estouros e guarda o pior caso. Um temporizador verifica periodicamente o trecho em
+// andamento, para que bloqueios longos apareçam antes de terminarem.
+// Com MONITOR_WATCHDOG_MS > 0, o watchdog de hardware é alimentado apenas pelo monitor, enquanto o loop
+// principal gira ou o trecho em andamento está dentro do seu limite.
+
+#ifndef MONITOR_H
+#define MONITOR_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef MONITOR_WATCHDOG_MS
+#define MONITOR_WATCHDOG_MS 0 // 0: watchdog desligado; até 8300 ms no RP2040
+#endif
+
+#ifndef MONITOR_VERIFICACAO_MS
+#define MONITOR_VERIFICACAO_MS 100 // período da verificação do trecho em andamento
+#endif
+
+// Os primeiros trechos seguem a ordem do enum Estado (estado.h)
+typedef enum {
+  TRECHO_TELA_INICIAL,
+  TRECHO_QUANTIDADE_XICARAS,
+  TRECHO_QUANDO_PREPARAR,
+  TRECHO_PREPARANDO,
+  TRECHO_PROGRAMANDO,
+  TRECHO_AGUARDANDO,
+  TRECHO_CALLBACK_IR,
+  TRECHO_LER_DIGITO,
+  TRECHO_CONFIGURAR_HORARIO,
+  TRECHO_VERIFICAR_RECURSOS,
+  TRECHO_LEITURA_RTC,
+  TRECHO_LEITURA_DHT,
+  TOTAL_TRECHOS,
+} TrechoMonitor;
+
+typedef struct {
+  uint32_t entradas;
+  uint32_t estouros;      // saídas acima do orçamento
+  uint32_t pior_us;       // maior duração observada
+  uint64_t soma_us;
+  uint32_t orcamento_us;
+} EstatisticaTrecho;
+
+void monitor_iniciar(void);
+void monitor_entrar(TrechoMonitor trecho); // seguro em IRQ
+void monitor_sair(TrechoMonitor trecho);   // seguro em IRQ
+void monitor_ciclo(void);                  // uma volta do loop principal
+void monitor_pausar(void);                 // para a verificação periódica (sono; alimenta o watchdog antes)
+void monitor_retomar(void);                // verifica na hora e religa a verificação periódica
+void monitor_estatisticas(TrechoMonitor trecho, EstatisticaTrecho *saida);
+void monitor_zerar(void);
+
+void monitor_solicitar_relatorio(void); // relatório pela USB (seguro em IRQ)
+void monitor_servico(void);             // relatório pendente, no loop principal
+
+#endif // MONITOR_H
@@ -0,0 +1,149 @@
+// perfil.c
+// Perfilador estatístico por amostragem do PC a partir de um alarme de hardware
+
+#include "perfil.h"
+
+#if PERFIL_ATIVO
+
+#include <stdio.h>
+#include "pico/stdlib.h"
+#include "hardware/timer.h"
+#include "hardware/irq.h"
+#include "hardware/sync.h"
+#include "na_ram.h"
+
+#define TOTAL_ENTRADAS 1024   // potência de 2; 8 KB de RAM
+#define MAX_SONDAGENS 8       // colisões toleradas antes de descartar a amostra
+#define OPCODE_WFE 0xBF20
+#define OPCODE_WFI 0xBF30
+
+typedef struct {
+  uint32_t pc;
+  uint32_t amostras;
+} EntradaPerfil;
+
+static EntradaPerfil tabela[TOTAL_ENTRADAS];
+static uint32_t total = 0;
+static uint32_t ociosas = 0;      // PC logo após WFE/WFI: processador dormindo
+static uint32_t descartadas = 0;  // tabela sem espaço para um PC novo
+static volatile bool ativo = false;
+static volatile bool descarga_pendente = false;
+
+// Chamada pelo tratador da IRQ com o quadro de exceção empilhado (r0-r3, r12, lr, pc, xpsr)
+void __attribute__((used)) NA_RAM(perfil_amostrar)(uint32_t *quadro) {
+  timer_hw->intr = 1u << PERFIL_ALARME;
+  timer_hw->alarm[PERFIL_ALARME] = timer_hw->timerawl + PERFIL_PERIODO_US;
+
+  uint32_t pc = quadro[6] & ~1u;
+  total++;
+
+  // O PC empilhado aponta para a instrução seguinte; se a anterior for WFE/WFI o núcleo estava ocioso
+  uint16_t anterior = *(const uint16_t *)(uintptr_t)(pc - 2);
+  if (anterior == OPCODE_WFE || anterior == OPCODE_WFI) {
+    ociosas++;
+    return;
+  }
+
+  uint32_t h = ((pc >> 1) * 2654435761u) >> 22; // hash multiplicativo para 10 bits
+  for (int i = 0; i < MAX_SONDAGENS; i++) {
+    EntradaPerfil *e = &tabela[(h + i) & (TOTAL_ENTRADAS - 1)];
+    if (e->pc == pc) {
+      e->amostras++;
+      return;
+    }
+    if (e->pc == 0) {
+      e->pc = pc;
+      e->amostras = 1;
+      return;
+    }
+  }
+  descartadas++;
+}
+
+// Tratador da IRQ: passa para perfil_amostrar a pilha em que o quadro de exceção foi salvo
+// (bit 2 do EXC_RETURN em lr). O salto com bx mantém lr, então o retorno de perfil_amostrar
+// encerra a exceção. Os dois ficam na RAM: a amostra tem a maior prioridade e uma falta no cache XIP
+// atrasaria as IRQs que ela interrompe (bordas do IR).
+static void __attribute__((naked)) NA_RAM(perfil_irq)(void) {
+  __asm volatile(
+    "movs r0, #4        \n"
+    "mov r1, lr         \n"
+    "tst r0, r1         \n"
+    "beq 1f             \n"
+    "mrs r0, psp        \n"
+    "b 2f               \n"
+    "1: mrs r0, msp     \n"
+    "2: ldr r1, =perfil_amostrar \n"
+    "bx r1              \n"
+    ".ltorg             \n"
+  );
+}
+
+void perfil_iniciar(void) {
+  if (ativo) return;
+  hardware_alarm_claim(PERFIL_ALARME);
+  irq_set_exclusive_handler(TIMER_IRQ_0 + PERFIL_ALARME, perfil_irq);
+  irq_set_priority(TIMER_IRQ_0 + PERFIL_ALARME, PICO_HIGHEST_IRQ_PRIORITY); // amostra também dentro de outras IRQs
+  timer_hw->inte |= 1u << PERFIL_ALARME;
+  irq_set_enabled(TIMER_IRQ_0 + PERFIL_ALARME, true);
+  ativo = true;
+  timer_hw->alarm[PERFIL_ALARME] = timer_hw->timerawl + PERFIL_PERIODO_US;
+}
+
+void perfil_parar(void) {
+  if (!ativo) return;
+  irq_set_enabled(TIMER_IRQ_0 + PERFIL_ALARME, false);
+  timer_hw->inte &= ~(1u << PERFIL_ALARME);
+  timer_hw->armed = 1u << PERFIL_ALARME; // desarma o alarme pendente
+  irq_remove_handler(TIMER_IRQ_0 + PERFIL_ALARME, perfil_irq);
+  hardware_alarm_unclaim(PERFIL_ALARME);
+  ativo = false;
+}
+
+bool perfil_ativo(void) {
+  return ativo;
+}
+
+void perfil_zerar(void) {
+  uint32_t irq = save_and_disable_interrupts();
+  for (int i = 0; i < TOTAL_ENTRADAS; i++) {
+    tabela[i].pc = 0;
+    tabela[i].amostras = 0;
+  }
+  total = ociosas = descartadas = 0;
+  restore_interrupts(irq);
+}
+
+void perfil_solicitar_descarga(void) {
+  descarga_pendente = true;
+}
+
+// Sem amostragem em andamento, começa uma nova. Com ela, envia o histograma em linhas
+// "PERF <pc> <amostras>" e encerra a amostragem antes, para que o próprio printf não apareça no perfil
+static void descarregar_usb() {
+  if (!ativo) {
+    perfil_zerar();
+    perfil_iniciar();
+    printf("PERF amostrando a cada %u us; TEST 4 de novo envia o perfil\n", PERFIL_PERIODO_US);
+    return;
+  }
+  perfil_parar();
+
+  printf("PERF INICIO periodo_us=%u total=%lu ociosas=%lu descartadas=%lu\n", PERFIL_PERIODO_US,
+         (unsigned long)total, (unsigned long)ociosas, (unsigned long)descartadas);
+  for (int i = 0; i < TOTAL_ENTRADAS; i++) {
+    if (tabela[i].pc != 0) {
+      printf("PERF %08lx %lu\n", (unsigned long)tabela[i].pc, (unsigned long)tabela[i].amostras);
+    }
+  }
+  printf("PERF FIM\n");
+}
+
+void perfil_servico(void) {
+  if (descarga_pendente) {
+    descarga_pendente = false;
+    descarregar_usb();
+  }
+}
+
+#endif // PERFIL_ATIVO
@@ -0,0 +1,45 @@
+// perfil.h
+// Perfilador estatístico: um alarme de hardware interrompe o processador periodicamente e registra o
+// endereço (PC) da instrução interrompida em um histograma compacto na RAM.
+// Amostras paradas em WFE/WFI (sleep_ms e demais esperas do SDK) são contadas à parte, como ociosas.
+// A amostragem só roda sob demanda: o relatório 4 da tecla TEST zera o histograma e a liga; o TEST 4
+// seguinte envia o histograma pela USB e a desliga. Fora desses intervalos o alarme de 1 kHz não
+// interrompe o firmware; ligado, energia.c o suspende durante o sono.
+// O histograma é simbolizado no host contra o ELF com ferramentas/perfil_simbolos.py, que gera os
+// relatórios por função e por módulo.
+
+#ifndef PERFIL_H
+#define PERFIL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef PERFIL_ATIVO
+#define PERFIL_ATIVO 1
+#endif
+
+#ifndef PERFIL_PERIODO_US
+#define PERFIL_PERIODO_US 1000     // 1 kHz de amostragem
+#endif
+
+#ifndef PERFIL_ALARME
+#define PERFIL_ALARME 2            // alarme de hardware dedicado (o 3 é usado pelo pool padrão do SDK)
+#endif
+
+#if PERFIL_ATIVO
+void perfil_iniciar(void);
+void perfil_parar(void);
+bool perfil_ativo(void);
+void perfil_zerar(void);
+void perfil_solicitar_descarga(void); // seguro em IRQ
+void perfil_servico(void);            // descarga pendente, no loop principal
+#else
+#define perfil_iniciar() ((void)0)
+#define perfil_parar() ((void)0)
+#define perfil_ativo() false
+#define perfil_zerar() ((void)0)
+#define perfil_solicitar_descarga() ((void)0)
+#define perfil_servico() ((void)0)
+#endif
+
+#endif // PERFIL_H
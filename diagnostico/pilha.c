@@ -0,0 +1,98 @@
+// pilha.c
+// Pintura das pilhas no boot e consulta das marcas d'água
+
+#include "pilha.h"
+#include <stdio.h>
+#include "pico/stdlib.h"
+#include "pico/platform.h"
+
+#define PADRAO 0xC0FFEEEEu
+#define FOLGA_PINTURA 32 // bytes abaixo do SP atual que não são pintados (quadro de pilha_pintar)
+#define INTERVALO_VERIFICACAO_MS 5000
+
+// Símbolos do script de ligação do SDK (memmap_default.ld): núcleo 0 em SCRATCH_Y, núcleo 1 em SCRATCH_X
+extern uint32_t __StackBottom[], __StackTop[];
+extern uint32_t __StackOneBottom[], __StackOneTop[];
+
+static uint32_t *const base[TOTAL_PILHAS] = {__StackBottom, __StackOneBottom};
+static uint32_t *const topo[TOTAL_PILHAS] = {__StackTop, __StackOneTop};
+
+static uint32_t sp_minimo[TOTAL_CONTEXTOS];
+static volatile bool relatorio_pendente = false;
+static bool aviso_emitido = false;
+static uint32_t proxima_verificacao_ms = 0;
+
+static inline uint32_t sp_atual(void) {
+  uint32_t sp;
+  __asm volatile("mov %0, sp" : "=r"(sp));
+  return sp;
+}
+
+// Pinta da base da pilha até logo abaixo do quadro atual; o núcleo 1 ainda não rodou e é pintado inteiro
+void pilha_pintar(void) {
+  uint32_t *limite = (uint32_t *)(uintptr_t)((sp_atual() - FOLGA_PINTURA) & ~3u);
+  for (uint32_t *p = __StackBottom; p < limite; p++) *p = PADRAO;
+  for (uint32_t *p = __StackOneBottom; p < __StackOneTop; p++) *p = PADRAO;
+
+  for (int c = 0; c < TOTAL_CONTEXTOS; c++) sp_minimo[c] = (uint32_t)(uintptr_t)__StackTop;
+}
+
+uint32_t pilha_tamanho(PilhaId pilha) {
+  return (uint32_t)((topo[pilha] - base[pilha]) * sizeof(uint32_t));
+}
+
+uint32_t pilha_maximo_usado(PilhaId pilha) {
+  const uint32_t *p = base[pilha];
+  while (p < topo[pilha] && *p == PADRAO) p++;
+  return (uint32_t)((topo[pilha] - p) * sizeof(uint32_t));
+}
+
+// Chamada em pontos profundos do código (escrita no LCD, callback do IR). O contexto vem do IPSR:
+// diferente de zero dentro de uma exceção.
+void pilha_marcar(void) {
+  uint32_t sp = sp_atual();
+  ContextoPilha contexto = __get_current_exception() ? CONTEXTO_IRQ : CONTEXTO_LOOP;
+  if (sp < sp_minimo[contexto]) sp_minimo[contexto] = sp;
+}
+
+uint32_t pilha_maximo_contexto(ContextoPilha contexto) {
+  return (uint32_t)(uintptr_t)__StackTop - sp_minimo[contexto];
+}
+
+void pilha_solicitar_relatorio(void) {
+  relatorio_pendente = true;
+}
+
+static void imprimir_relatorio() {
+  static const char *nomes[TOTAL_PILHAS] = {"nucleo0", "nucleo1"};
+  static const char *contextos[TOTAL_CONTEXTOS] = {"loop", "irq"};
+
+  printf("PILHA INICIO\n");
+  for (int i = 0; i < TOTAL_PILHAS; i++) {
+    uint32_t tamanho = pilha_tamanho(i), usado = pilha_maximo_usado(i);
+    printf("PILHA %s tamanho=%lu usado=%lu livre=%ld%s\n", nomes[i], (unsigned long)tamanho,
+           (unsigned long)usado, (long)tamanho - (long)usado, usado >= tamanho ? " ESTOURO" : "");
+  }
+  for (int c = 0; c < TOTAL_CONTEXTOS; c++) {
+    printf("PILHA contexto %s maximo_marcado=%lu\n", contextos[c], (unsigned long)pilha_maximo_contexto(c));
+  }
+  printf("PILHA FIM\n");
+}
+
+void pilha_servico(void) {
+  if (relatorio_pendente) {
+    relatorio_pendente = false;
+    imprimir_relatorio();
+  }
+
+  // Verificação periódica da margem do núcleo 0 (a varredura percorre a região pintada)
+  uint32_t agora = to_ms_since_boot(get_absolute_time());
+  if (!aviso_emitido && agora >= proxima_verificacao_ms) {
+    proxima_verificacao_ms = agora + INTERVALO_VERIFICACAO_MS;
+    uint32_t tamanho = pilha_tamanho(PILHA_NUCLEO0), usado = pilha_maximo_usado(PILHA_NUCLEO0);
+    if (usado + PILHA_MARGEM_MINIMA > tamanho) {
+      printf("PILHA AVISO nucleo0 usado=%lu de %lu bytes\n", (unsigned long)usado, (unsigned long)tamanho);
+      aviso_emitido = true;
+    }
+  }
+}
@@ -0,0 +1,41 @@
+// pilha.h
+// Marca d'água das pilhas e uso de RAM em execução.
+// No boot, a região livre de cada pilha é pintada com um padrão; o ponto mais fundo já alcançado é o
+// primeiro endereço (de baixo para cima) em que o padrão foi sobrescrito.
+// No RP2040 as IRQs (controle IR, alarmes, perfilador) usam a mesma pilha do loop principal (MSP do
+// núcleo 0); pilha_marcar registra a profundidade vista em pontos de IRQ e de loop separadamente, para
+// saber qual contexto chega ao pico. O uso estático por módulo vem do mapa do ligador, com
+// ferramentas/uso_memoria.py.
+
+#ifndef PILHA_H
+#define PILHA_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef PILHA_MARGEM_MINIMA
+#define PILHA_MARGEM_MINIMA 256 // bytes livres abaixo dos quais o aviso é emitido pela USB
+#endif
+
+typedef enum {
+  PILHA_NUCLEO0, // loop principal e todas as IRQs
+  PILHA_NUCLEO1, // reservada pelo SDK; sem uso enquanto o núcleo 1 não for iniciado
+  TOTAL_PILHAS,
+} PilhaId;
+
+typedef enum {
+  CONTEXTO_LOOP, // pontos marcados fora de interrupção
+  CONTEXTO_IRQ,  // pontos marcados dentro de uma IRQ (sobre a pilha do loop interrompido)
+  TOTAL_CONTEXTOS,
+} ContextoPilha;
+
+void pilha_pintar(void);                    // no início do boot, antes de pilha_* serem consultadas
+uint32_t pilha_tamanho(PilhaId pilha);      // bytes reservados pelo ligador
+uint32_t pilha_maximo_usado(PilhaId pilha); // marca d'água em bytes (>= tamanho: estourou)
+void pilha_marcar(void);                    // registra a profundidade atual no contexto em execução
+uint32_t pilha_maximo_contexto(ContextoPilha contexto); // maior profundidade marcada, em bytes
+
+void pilha_solicitar_relatorio(void); // relatório pela USB (seguro em IRQ)
+void pilha_servico(void);             // relatório pendente e aviso de margem, no loop principal
+
+#endif // PILHA_H
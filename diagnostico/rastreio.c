@@ -0,0 +1,81 @@
+// rastreio.c
+// Rastreamento de eventos com marca de tempo em um buffer circular na RAM
+
+#include "rastreio.h"
+
+#if RASTREIO_ATIVO
+
+#include <stdio.h>
+#include "pico/stdlib.h"
+#include "hardware/sync.h"
+#include "na_ram.h"
+
+#define MASCARA (RASTREIO_TAMANHO_BUFFER - 1)
+
+static RegistroRastreio buffer[RASTREIO_TAMANHO_BUFFER];
+static uint32_t cabeca = 0;   // próximo registro a escrever
+static uint32_t cauda = 0;    // próximo registro a descarregar
+static uint32_t perdidos = 0; // registros sobrescritos antes de serem descarregados
+static volatile bool descarga_pendente = false;
+
+// Reserva e preenche um registro com as interrupções desligadas por poucas instruções
+// (o Cortex-M0+ não tem instruções exclusivas para uma fila sem bloqueio)
+void NA_RAM(rastreio_evento)(uint16_t evento, uint16_t arg0, uint32_t arg1) {
+  uint32_t irq = save_and_disable_interrupts();
+  RegistroRastreio *r = &buffer[cabeca & MASCARA];
+  r->tempo_us = time_us_32();
+  r->evento = evento;
+  r->arg0 = arg0;
+  r->arg1 = arg1;
+  cabeca++;
+  if (cabeca - cauda > RASTREIO_TAMANHO_BUFFER) { // buffer cheio: descarta o mais antigo
+    cauda++;
+    perdidos++;
+  }
+  restore_interrupts(irq);
+}
+
+void rastreio_solicitar_descarga(void) {
+  descarga_pendente = true;
+}
+
+void rastreio_servico(void) {
+  if (descarga_pendente) {
+    descarga_pendente = false;
+    rastreio_descarregar_usb();
+  }
+}
+
+// Envia os registros pendentes em linhas "RAST <hex>" (um registro por linha, little-endian)
+void rastreio_descarregar_usb(void) {
+  uint32_t irq = save_and_disable_interrupts();
+  uint32_t inicio = cauda, fim = cabeca, perdidos_agora = perdidos;
+  perdidos = 0;
+  restore_interrupts(irq);
+
+  printf("RAST INICIO %lu %lu\n", (unsigned long)(fim - inicio), (unsigned long)perdidos_agora);
+  for (uint32_t i = inicio; i != fim; i++) {
+    RegistroRastreio r;
+    irq = save_and_disable_interrupts();
+    if (i - cauda >= RASTREIO_TAMANHO_BUFFER) { // sobrescrito durante a descarga
+      restore_interrupts(irq);
+      continue;
+    }
+    r = buffer[i & MASCARA];
+    restore_interrupts(irq);
+
+    const uint8_t *b = (const uint8_t *)&r;
+    printf("RAST ");
+    for (size_t j = 0; j < sizeof(r); j++) {
+      printf("%02x", b[j]);
+    }
+    printf("\n");
+  }
+
+  irq = save_and_disable_interrupts();
+  if ((int32_t)(fim - cauda) > 0) cauda = fim;
+  restore_interrupts(irq);
+  printf("RAST FIM\n");
+}
+
+#endif // RASTREIO_ATIVO
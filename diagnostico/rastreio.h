@@ -0,0 +1,63 @@
+// rastreio.h
+// Rastreamento de eventos com marca de tempo em um buffer circular na RAM
+// Cada registro tem tamanho fixo (tempo, evento e dois argumentos) e pode ser escrito tanto do loop
+// principal quanto de IRQ. O buffer é descarregado pela USB e convertido no host para o formato JSON
+// do Chrome/Perfetto com ferramentas/rastreio_perfetto.py.
+
+#ifndef RASTREIO_H
+#define RASTREIO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef RASTREIO_ATIVO
+#define RASTREIO_ATIVO 1           // 0 remove toda a instrumentação do firmware
+#endif
+
+#ifndef RASTREIO_TAMANHO_BUFFER
+#define RASTREIO_TAMANHO_BUFFER 2048 // registros (potência de 2), 12 bytes cada
+#endif
+
+typedef struct {
+  uint32_t tempo_us; // time_us_32() no momento do evento
+  uint16_t evento;   // EventoRastreio
+  uint16_t arg0;
+  uint32_t arg1;
+} RegistroRastreio;
+
+typedef enum {
+  RASTREIO_ESTADO = 1,         // arg0 = estado anterior, arg1 = estado novo
+  RASTREIO_I2C_INICIO,         // arg0 = endereço, arg1 = bytes
+  RASTREIO_I2C_FIM,            // arg0 = endereço, arg1 = resultado da transação
+  RASTREIO_IR_QUADRO,          // arg0 = comando, arg1 = tipo (NORMAL/REPEAT)
+  RASTREIO_ATUADOR_INICIO,     // arg0 = AtuadorRastreio, arg1 = parâmetro (ângulo, frequência...)
+  RASTREIO_ATUADOR_FIM,        // arg0 = AtuadorRastreio
+  RASTREIO_ETAPA_INICIO,       // arg0 = EtapaPreparo
+  RASTREIO_ETAPA_FIM,          // arg0 = EtapaPreparo
+  RASTREIO_PRAZO_ESTOURADO,    // arg0 = TrechoMonitor, arg1 = duração em µs ao detectar o estouro
+  RASTREIO_TRANSICAO,          // arg0 = Evento, arg1 = duração em µs de saída + ação + entrada
+  RASTREIO_ANIMACAO_INICIO,    // arg0 = TipoAnimacao, arg1 = id
+  RASTREIO_ANIMACAO_FIM,       // arg0 = TipoAnimacao, arg1 = id | 0x10000 se concluída (sem o bit: cancelada)
+} EventoRastreio;
+
+typedef enum {
+  ATUADOR_SERVO_GRAOS,
+  ATUADOR_SERVO_CAFE_MOIDO,
+  ATUADOR_MOTOR_PASSO,
+  ATUADOR_BUZZER,
+  ATUADOR_BARRA_LEDS,
+} AtuadorRastreio;
+
+#if RASTREIO_ATIVO
+void rastreio_evento(uint16_t evento, uint16_t arg0, uint32_t arg1); // seguro em IRQ
+void rastreio_solicitar_descarga(void);                              // seguro em IRQ
+void rastreio_servico(void);                                         // descarga pendente, no loop principal
+void rastreio_descarregar_usb(void);
+#else
+#define rastreio_evento(evento, arg0, arg1) ((void)0)
+#define rastreio_solicitar_descarga() ((void)0)
+#define rastreio_servico() ((void)0)
+#define rastreio_descarregar_usb() ((void)0)
+#endif
+
+#endif // RASTREIO_H
@@ -0,0 +1,312 @@
+// animacao.c
+// Motor de animações do LCD em tiques de temporizador
+
+#include "animacao.h"
+#include <stdio.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hardware/sync.h"
+#include "hardware/irq.h"
+#include "lcd_i2c.h"
+#include "rastreio.h"
+
+#define PASSO_APAGAR_MS 50 // intervalo entre caracteres apagados em APAGAR_ESCREVER
+
+typedef struct {
+  bool ativa;
+  TipoAnimacao tipo;
+  AnimacaoId id;
+  uint8_t linha;
+  uint8_t coluna;
+  uint8_t largura;          // região ocupada no display
+  uint16_t vezes;
+  uint32_t periodo_ms;
+  uint64_t inicio_us;
+  AvisoAnimacao aviso;
+  char texto[ANIMACAO_TEXTO_MAX + 1];
+  char texto2[LCD_COLS + 1];
+  char quadro[LCD_COLS + 1];  // último quadro calculado pelo tique
+  uint8_t largura_quadro;
+  volatile bool sujo;         // quadro ainda não enviado ao display
+} Animacao;
+
+static Animacao slots[ANIMACAO_TOTAL_SLOTS];
+static AnimacaoId proximo_id = 1;
+static repeating_timer_t temporizador;
+static volatile bool temporizador_ativo = false; // o próprio tique desliga o temporizador sem animações
+static int irq_escrita = -1;                     // IRQ de software que leva os quadros ao display
+
+// Encerra o slot; chamada com as interrupções desligadas ou na própria IRQ do tique. Um cancelamento
+// descarta o quadro pendente; no fim natural, o último quadro ainda é escrito
+static void encerrar(Animacao *a, bool concluida) {
+  a->ativa = false;
+  if (!concluida) a->sujo = false;
+  rastreio_evento(RASTREIO_ANIMACAO_FIM, a->tipo, a->id | (concluida ? 0x10000u : 0));
+  if (a->aviso) a->aviso(a->id, concluida);
+}
+
+// -------------------------------------------------------------------------------------------------- //
+// Quadros: cada tipo calcula, pelo tempo decorrido, o texto visível na sua região
+
+// Retorna true quando a animação terminou (o texto final já está em quadro)
+static bool calcular_quadro(const Animacao *a, uint32_t decorrido_ms, char *quadro, int *largura) {
+  int n = strlen(a->texto);
+  switch (a->tipo) {
+    case ANIMACAO_DIGITAR: {
+      uint32_t k = decorrido_ms / a->periodo_ms + 1;
+      if (k > (uint32_t)n) k = n;
+      memcpy(quadro, a->texto, k);
+      quadro[k] = '\0';
+      *largura = k;
+      return decorrido_ms >= n * a->periodo_ms;
+    }
+    case ANIMACAO_PISCAR: {
+      uint32_t fase = decorrido_ms / a->periodo_ms;
+      bool fim = fase >= 2u * a->vezes;
+      if (fim || fase % 2 == 0) {
+        strcpy(quadro, a->texto);
+      } else {
+        quadro[0] = '\0';
+      }
+      *largura = n;
+      return fim;
+    }
+    case ANIMACAO_APAGAR_ESCREVER: {
+      if (decorrido_ms < a->periodo_ms) {
+        strcpy(quadro, a->texto);
+        *largura = n;
+        return false;
+      }
+      uint32_t apagados = (decorrido_ms - a->periodo_ms) / PASSO_APAGAR_MS;
+      if (apagados <= (uint32_t)n) { // apaga da direita para a esquerda
+        memcpy(quadro, a->texto, n - apagados);
+        quadro[n - apagados] = '\0';
+        *largura = n;
+        return false;
+      }
+      strcpy(quadro, a->texto2);
+      *largura = a->largura;
+      return true;
+    }
+    case ANIMACAO_ROLAR: {
+      int ciclo = (n > LCD_COLS) ? n - LCD_COLS + 1 : 1;
+      int inicio = (decorrido_ms / a->periodo_ms) % ciclo;
+      int k = (n - inicio < LCD_COLS) ? n - inicio : LCD_COLS;
+      memcpy(quadro, a->texto + inicio, k);
+      quadro[k] = '\0';
+      *largura = k;
+      return false;
+    }
+    case ANIMACAO_CONTADOR: {
+      uint32_t s = decorrido_ms / 1000;
+      snprintf(quadro, LCD_COLS + 1, "Tempo: %03lu seg", (unsigned long)(s < 1000 ? s : 999));
+      *largura = a->largura;
+      return s >= 999;
+    }
+  }
+  return true;
+}
+
+// Escrita dos quadros pendentes, na IRQ de software de menor prioridade: a transação I2C (até ~2 ms)
+// não atrasa as IRQs do IR, dos alarmes e da barra de LEDs, que a interrompem. Devolve o cursor onde
+// o loop principal o deixou
+static void escrever_quadros(void) {
+  if (!lcd_disponivel_para_irq()) return; // loop principal no barramento (ou lendo o DHT22): próximo tique
+
+  uint8_t cursor = lcd_endereco_cursor();
+  for (int i = 0; i < ANIMACAO_TOTAL_SLOTS; i++) {
+    Animacao *a = &slots[i];
+    char quadro[LCD_COLS + 1];
+    uint8_t linha = 0, coluna = 0, largura = 0;
+    uint32_t irq = save_and_disable_interrupts(); // o tique pode trocar o quadro durante a escrita
+    bool sujo = a->sujo;
+    if (sujo) {
+      memcpy(quadro, a->quadro, sizeof(quadro));
+      linha = a->linha;
+      coluna = a->coluna;
+      largura = a->largura_quadro;
+      a->sujo = false;
+    }
+    restore_interrupts(irq);
+    if (sujo) lcd_compor_quadro(linha, coluna, quadro, largura); // não conta como reação a uma tecla
+  }
+  lcd_restaurar_cursor(cursor);
+}
+
+// Tique do temporizador: só calcula os quadros e marca os que mudaram; a escrita fica com a IRQ de
+// software. Sem animações nem quadros pendentes, o temporizador é desligado
+static bool tique(repeating_timer_t *t) {
+  (void)t;
+  uint64_t agora = time_us_64();
+  bool ativas = false, pendentes = false;
+  for (int i = 0; i < ANIMACAO_TOTAL_SLOTS; i++) {
+    Animacao *a = &slots[i];
+    if (a->ativa) {
+      char quadro[ANIMACAO_TEXTO_MAX + 1];
+      int largura;
+      bool fim = calcular_quadro(a, (uint32_t)((agora - a->inicio_us) / 1000), quadro, &largura);
+      if (largura != a->largura_quadro || strcmp(quadro, a->quadro) != 0) {
+        strncpy(a->quadro, quadro, LCD_COLS);
+        a->largura_quadro = largura;
+        a->sujo = true;
+      }
+      if (fim) {
+        encerrar(a, true);
+      } else {
+        ativas = true;
+      }
+    }
+    pendentes |= a->sujo;
+  }
+  if (pendentes) irq_set_pending(irq_escrita);
+  if (ativas || pendentes) return true;
+  temporizador_ativo = false;
+  return false;
+}
+
+// -------------------------------------------------------------------------------------------------- //
+// Início e controle
+
+static bool sobrepoe(const Animacao *a, int linha, int coluna, int largura) {
+  return a->linha == linha && a->coluna < coluna + largura && coluna < a->coluna + a->largura;
+}
+
+// Reserva um slot para a região, cancelando as animações que a ocupam
+static Animacao *reservar(TipoAnimacao tipo, int linha, int coluna, int largura, uint32_t periodo_ms) {
+  if (linha < 0 || linha >= LCD_ROWS || periodo_ms == 0) return NULL;
+
+  Animacao *livre = NULL;
+  uint32_t irq = save_and_disable_interrupts();
+  for (int i = 0; i < ANIMACAO_TOTAL_SLOTS; i++) {
+    Animacao *a = &slots[i];
+    if ((a->ativa || a->sujo) && sobrepoe(a, linha, coluna, largura)) encerrar(a, false);
+  }
+  for (int i = 0; i < ANIMACAO_TOTAL_SLOTS && !livre; i++) { // de preferência sem quadro final pendente
+    if (!slots[i].ativa && !slots[i].sujo) livre = &slots[i];
+  }
+  for (int i = 0; i < ANIMACAO_TOTAL_SLOTS && !livre; i++) {
+    if (!slots[i].ativa) livre = &slots[i];
+  }
+  if (livre) {
+    memset(livre, 0, sizeof(*livre));
+    livre->tipo = tipo;
+    livre->id = proximo_id++;
+    if (proximo_id == ANIMACAO_NENHUMA) proximo_id = 1;
+    livre->linha = linha;
+    livre->coluna = coluna;
+    livre->largura = (coluna + largura > LCD_COLS) ? LCD_COLS - coluna : largura;
+    livre->periodo_ms = periodo_ms;
+  }
+  restore_interrupts(irq);
+  return livre;
+}
+
+// Ativa o slot já preenchido; o primeiro quadro sai no próximo tique. O slot fica ativo antes do teste
+// do temporizador: um tique que o desligue entre os dois passos já viu a animação ou é religado aqui
+static AnimacaoId ativar(Animacao *a) {
+  if (irq_escrita < 0) {
+    irq_escrita = user_irq_claim_unused(true);
+    irq_set_exclusive_handler(irq_escrita, escrever_quadros);
+    irq_set_priority(irq_escrita, PICO_LOWEST_IRQ_PRIORITY);
+    irq_set_enabled(irq_escrita, true);
+  }
+  rastreio_evento(RASTREIO_ANIMACAO_INICIO, a->tipo, a->id);
+  a->inicio_us = time_us_64();
+  a->ativa = true;
+  if (!temporizador_ativo) {
+    temporizador_ativo = add_repeating_timer_ms(-ANIMACAO_TIQUE_MS, tique, NULL, &temporizador);
+  }
+  return a->id;
+}
+
+AnimacaoId animacao_digitar(const char *texto, int linha, int periodo_ms) {
+  int n = strnlen(texto, LCD_COLS);
+  Animacao *a = reservar(ANIMACAO_DIGITAR, linha, 0, n, periodo_ms);
+  if (!a) return ANIMACAO_NENHUMA;
+  memcpy(a->texto, texto, n);
+  return ativar(a);
+}
+
+AnimacaoId animacao_piscar(const char *texto, int linha, int coluna, int vezes, int periodo_ms) {
+  if (coluna < 0 || coluna >= LCD_COLS) return ANIMACAO_NENHUMA;
+  int n = strnlen(texto, LCD_COLS - coluna);
+  Animacao *a = reservar(ANIMACAO_PISCAR, linha, coluna, n, periodo_ms);
+  if (!a) return ANIMACAO_NENHUMA;
+  memcpy(a->texto, texto, n);
+  a->vezes = vezes;
+  return ativar(a);
+}
+
+AnimacaoId animacao_apagar_escrever(const char *texto1, const char *texto2, int linha, int espera_ms) {
+  int n1 = strnlen(texto1, LCD_COLS), n2 = strnlen(texto2, LCD_COLS);
+  Animacao *a = reservar(ANIMACAO_APAGAR_ESCREVER, linha, 0, n1 > n2 ? n1 : n2, espera_ms);
+  if (!a) return ANIMACAO_NENHUMA;
+  memcpy(a->texto, texto1, n1);
+  memcpy(a->texto2, texto2, n2);
+  return ativar(a);
+}
+
+AnimacaoId animacao_rolar(const char *texto, int linha, int periodo_ms) {
+  int n = strnlen(texto, ANIMACAO_TEXTO_MAX);
+  Animacao *a = reservar(ANIMACAO_ROLAR, linha, 0, n < LCD_COLS ? n : LCD_COLS, periodo_ms);
+  if (!a) return ANIMACAO_NENHUMA;
+  memcpy(a->texto, texto, n);
+  return ativar(a);
+}
+
+AnimacaoId animacao_contador(int linha) {
+  Animacao *a = reservar(ANIMACAO_CONTADOR, linha, 0, 15, 1000);
+  if (!a) return ANIMACAO_NENHUMA;
+  return ativar(a);
+}
+
+void animacao_ao_concluir(AnimacaoId id, AvisoAnimacao aviso) {
+  uint32_t irq = save_and_disable_interrupts();
+  for (int i = 0; i < ANIMACAO_TOTAL_SLOTS; i++) {
+    if (slots[i].ativa && slots[i].id == id) slots[i].aviso = aviso;
+  }
+  restore_interrupts(irq);
+}
+
+bool animacao_ativa(AnimacaoId id) {
+  for (int i = 0; i < ANIMACAO_TOTAL_SLOTS; i++) {
+    if (slots[i].ativa && slots[i].id == id) return true;
+  }
+  return false;
+}
+
+void animacao_cancelar(AnimacaoId id) {
+  uint32_t irq = save_and_disable_interrupts();
+  for (int i = 0; i < ANIMACAO_TOTAL_SLOTS; i++) {
+    if (slots[i].ativa && slots[i].id == id) encerrar(&slots[i], false);
+  }
+  restore_interrupts(irq);
+}
+
+void animacao_cancelar_todas(void) {
+  uint32_t irq = save_and_disable_interrupts();
+  for (int i = 0; i < ANIMACAO_TOTAL_SLOTS; i++) {
+    if (slots[i].ativa) encerrar(&slots[i], false);
+  }
+  restore_interrupts(irq);
+}
+
+// Até o último quadro estar no display, não só até a animação terminar
+static bool em_andamento(AnimacaoId id) {
+  for (int i = 0; i < ANIMACAO_TOTAL_SLOTS; i++) {
+    if ((slots[i].ativa || slots[i].sujo) && slots[i].id == id) return true;
+  }
+  return false;
+}
+
+void animacao_aguardar(AnimacaoId id) {
+  while (em_andamento(id)) {
+    sleep_ms(ANIMACAO_TIQUE_MS);
+  }
+}
+
+void animacao_aguardar_todas(void) {
+  for (int i = 0; i < ANIMACAO_TOTAL_SLOTS; i++) {
+    if (slots[i].tipo != ANIMACAO_ROLAR) animacao_aguardar(slots[i].id);
+  }
+}
@@ -0,0 +1,51 @@
+// animacao.h
+// Motor de animações do LCD: os efeitos (digitar, piscar, apagar e escrever, rolar, contador) avançam
+// em tiques de um temporizador repetitivo, sem bloquear o loop principal nem os processos de preparo.
+// Cada quadro é calculado pelo tempo decorrido desde o início (um atraso pula quadros em vez de
+// alongar o efeito) e escrito com lcd_compor_quadro, que só envia os caracteres que mudaram.
+// Várias animações podem rodar ao mesmo tempo em regiões diferentes; iniciar uma animação sobre uma
+// região ocupada cancela a anterior, e lcd_clear cancela todas.
+// O tique (IRQ do temporizador) só calcula os quadros; a escrita I2C fica com uma IRQ de software de
+// menor prioridade, adiada enquanto o loop principal usa o barramento. O temporizador só roda enquanto
+// há animações.
+
+#ifndef ANIMACAO_H
+#define ANIMACAO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define ANIMACAO_TOTAL_SLOTS 4
+#define ANIMACAO_TEXTO_MAX 64     // texto copiado para o slot (mensagens de rolagem podem passar de 20)
+#define ANIMACAO_TIQUE_MS 10      // resolução dos quadros
+#define ANIMACAO_NENHUMA 0
+
+typedef enum {
+  ANIMACAO_DIGITAR,
+  ANIMACAO_PISCAR,
+  ANIMACAO_APAGAR_ESCREVER,
+  ANIMACAO_ROLAR,
+  ANIMACAO_CONTADOR,
+} TipoAnimacao;
+
+typedef uint16_t AnimacaoId;
+
+// Chamado na IRQ do tique ao fim da animação (concluida = false se foi cancelada); deve ser curto e
+// seguro em IRQ, por exemplo estado_postar_evento
+typedef void (*AvisoAnimacao)(AnimacaoId id, bool concluida);
+
+// Início das animações, no loop principal (retornam ANIMACAO_NENHUMA se não houver slot livre)
+AnimacaoId animacao_digitar(const char *texto, int linha, int periodo_ms);
+AnimacaoId animacao_piscar(const char *texto, int linha, int coluna, int vezes, int periodo_ms);
+AnimacaoId animacao_apagar_escrever(const char *texto1, const char *texto2, int linha, int espera_ms);
+AnimacaoId animacao_rolar(const char *texto, int linha, int periodo_ms); // contínua
+AnimacaoId animacao_contador(int linha);                                 // "Tempo: NNN seg"
+
+void animacao_ao_concluir(AnimacaoId id, AvisoAnimacao aviso);
+bool animacao_ativa(AnimacaoId id);
+void animacao_cancelar(AnimacaoId id);
+void animacao_cancelar_todas(void);          // seguro em IRQ
+void animacao_aguardar(AnimacaoId id);       // espera o fim (não usar com animações contínuas)
+void animacao_aguardar_todas(void);          // espera o fim das animações finitas
+
+#endif // ANIMACAO_H
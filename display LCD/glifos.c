@@ -0,0 +1,120 @@
+// glifos.c
+// Cache LRU dos caracteres personalizados na CGRAM
+
+#include "glifos.h"
+#include <string.h>
+#include "lcd_i2c.h"
+
+#define TOTAL_SLOTS 8
+#define SEM_GLIFO 0xFF
+#define SEM_SLOT -1
+
+static const uint8_t desenhos[TOTAL_GLIFOS][8] = {
+  [GLIFO_BARRA_1]    = {0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10},
+  [GLIFO_BARRA_2]    = {0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18},
+  [GLIFO_BARRA_3]    = {0x1C, 0x1C, 0x1C, 0x1C, 0x1C, 0x1C, 0x1C, 0x1C},
+  [GLIFO_BARRA_4]    = {0x1E, 0x1E, 0x1E, 0x1E, 0x1E, 0x1E, 0x1E, 0x1E},
+  [GLIFO_XICARA]     = {0x09, 0x12, 0x00, 0x1E, 0x13, 0x12, 0x0C, 0x00},
+  [GLIFO_TERMOMETRO] = {0x04, 0x0A, 0x0A, 0x0A, 0x0E, 0x1F, 0x1F, 0x0E},
+  [GLIFO_GOTA]       = {0x04, 0x04, 0x0A, 0x0A, 0x11, 0x11, 0x0E, 0x00},
+};
+
+// Usados quando todos os slots estão visíveis no display
+static const char substitutos[TOTAL_GLIFOS] = {' ', ' ', ' ', ' ', 'U', 'T', 'W'};
+
+static uint8_t glifo_no_slot[TOTAL_SLOTS] = {SEM_GLIFO, SEM_GLIFO, SEM_GLIFO, SEM_GLIFO,
+                                             SEM_GLIFO, SEM_GLIFO, SEM_GLIFO, SEM_GLIFO};
+static int8_t slot_do_glifo[TOTAL_GLIFOS] = {SEM_SLOT, SEM_SLOT, SEM_SLOT, SEM_SLOT, SEM_SLOT, SEM_SLOT, SEM_SLOT};
+static uint32_t ultimo_uso[TOTAL_SLOTS];
+static uint32_t relogio_uso = 0;
+static uint32_t acertos = 0, faltas = 0, transacoes = 0;
+
+// Slot para um glifo novo: vazio ou o menos usado recentemente, fora do pedido atual e do display
+static int escolher_vitima(void) {
+  int vitima = SEM_SLOT;
+  for (int s = 0; s < TOTAL_SLOTS; s++) {
+    if (ultimo_uso[s] == relogio_uso && glifo_no_slot[s] != SEM_GLIFO) continue; // usado neste pedido
+    if (lcd_cgram_visivel(s)) continue;
+    if (glifo_no_slot[s] == SEM_GLIFO) return s;
+    if (vitima == SEM_SLOT || ultimo_uso[s] < ultimo_uso[vitima]) vitima = s;
+  }
+  return vitima;
+}
+
+void glifos_preparar(const GlifoId *ids, int total) {
+  uint8_t slots[TOTAL_SLOTS];
+  uint8_t carga[TOTAL_SLOTS][8];
+  int n = 0;
+
+  relogio_uso++;
+  for (int i = 0; i < total; i++) { // marca os acertos antes, para não serem escolhidos como vítima
+    int s = slot_do_glifo[ids[i]];
+    if (s != SEM_SLOT) ultimo_uso[s] = relogio_uso;
+  }
+  for (int i = 0; i < total; i++) {
+    GlifoId id = ids[i];
+    if (slot_do_glifo[id] != SEM_SLOT) {
+      acertos++;
+      continue;
+    }
+    int s = escolher_vitima();
+    if (s == SEM_SLOT) continue; // sem espaço: glifo_caractere devolve o substituto
+    faltas++;
+    if (glifo_no_slot[s] != SEM_GLIFO) slot_do_glifo[glifo_no_slot[s]] = SEM_SLOT;
+    glifo_no_slot[s] = id;
+    slot_do_glifo[id] = s;
+    ultimo_uso[s] = relogio_uso;
+
+    // Mantém a carga ordenada por slot para aproveitar o avanço automático do endereço da CGRAM
+    int j = n++;
+    while (j > 0 && slots[j - 1] > s) {
+      slots[j] = slots[j - 1];
+      memcpy(carga[j], carga[j - 1], 8);
+      j--;
+    }
+    slots[j] = s;
+    memcpy(carga[j], desenhos[id], 8);
+  }
+  if (n > 0) {
+    lcd_carregar_cgram(slots, (const uint8_t (*)[8])carga, n);
+    transacoes++;
+  }
+}
+
+char glifo_caractere(GlifoId id) {
+  glifos_preparar(&id, 1);
+  int s = slot_do_glifo[id];
+  return (s != SEM_SLOT) ? (char)(8 + s) : substitutos[id];
+}
+
+void glifo_desenhar(GlifoId id, int linha, int coluna) {
+  char texto[2] = {glifo_caractere(id), '\0'};
+  lcd_compor(linha, coluna, texto, 1);
+}
+
+void glifos_barra(int linha, int coluna, int largura, int porcentagem) {
+  char barra[LCD_COLS + 1];
+  if (largura > LCD_COLS) largura = LCD_COLS;
+  if (porcentagem < 0) porcentagem = 0;
+  if (porcentagem > 100) porcentagem = 100;
+
+  int pixels = porcentagem * largura * 5 / 100;
+  int cheios = pixels / 5, resto = pixels % 5;
+  memset(barra, ' ', largura);
+  memset(barra, GLIFO_CHEIO, cheios);
+  if (resto > 0) barra[cheios] = glifo_caractere(GLIFO_BARRA_1 + resto - 1);
+  barra[largura] = '\0';
+  lcd_compor(linha, coluna, barra, largura);
+}
+
+void glifos_invalidar(int slot) {
+  slot &= 0x7;
+  if (glifo_no_slot[slot] != SEM_GLIFO) slot_do_glifo[glifo_no_slot[slot]] = SEM_SLOT;
+  glifo_no_slot[slot] = SEM_GLIFO;
+}
+
+void glifos_estatisticas(uint32_t *a, uint32_t *f, uint32_t *t) {
+  *a = acertos;
+  *f = faltas;
+  *t = transacoes;
+}
@@ -0,0 +1,42 @@
+// glifos.h
+// Cache dos caracteres personalizados na CGRAM do HD44780 (8 slots de 5x8 pixels).
+// Cada glifo tem um id fixo; o cache lembra qual slot guarda cada glifo e só envia o desenho numa
+// falta, escolhendo o slot usado há mais tempo (LRU) entre os que não aparecem no display.
+// As cargas de um mesmo pedido vão em uma única transação I2C. Os glifos são escritos com os códigos
+// 8-15 (espelhos de 0-7), que podem aparecer dentro de strings comuns.
+
+#ifndef GLIFOS_H
+#define GLIFOS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef enum {
+  GLIFO_BARRA_1,   // 1 a 4 colunas preenchidas: fração do caractere na barra de progresso
+  GLIFO_BARRA_2,
+  GLIFO_BARRA_3,
+  GLIFO_BARRA_4,
+  GLIFO_XICARA,
+  GLIFO_TERMOMETRO,
+  GLIFO_GOTA,
+  TOTAL_GLIFOS,
+} GlifoId;
+
+#define GLIFO_CHEIO '\xFF' // bloco cheio da ROM do display (não ocupa a CGRAM)
+
+// Garante os glifos na CGRAM, com as faltas enviadas juntas
+void glifos_preparar(const GlifoId *ids, int total);
+
+// Código do glifo para escrever no display (carrega se preciso); sem slot livre, um caractere comum
+char glifo_caractere(GlifoId id);
+
+void glifo_desenhar(GlifoId id, int linha, int coluna);
+
+// Barra de progresso (0-100%) com resolução de uma coluna de pixel
+void glifos_barra(int linha, int coluna, int largura, int porcentagem);
+
+void glifos_invalidar(int slot); // o slot foi regravado por fora do cache (create_custom_char)
+
+void glifos_estatisticas(uint32_t *acertos, uint32_t *faltas, uint32_t *transacoes);
+
+#endif // GLIFOS_H
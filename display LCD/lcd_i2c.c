@@ -5,48 +5,123 @@
 #include <stdio.h>
 #include "pico/stdlib.h"
 #include <string.h>
-
-// comunicação i2c para o display LCD e o RTC
-#define I2C_PORT i2c0
-#define SDA_PIN 4
-#define SCL_PIN 5
+#include "gravador.h"
+#include "rastreio.h"
+#include "latencia.h"
+#include "pilha.h"
+#include "animacao.h"
+#include "glifos.h"
+#include "barramento.h"
+#include "na_ram.h"
+
+// comunicação i2c para o display LCD e o RTC (pinos em placa.h, perfis de frequência em barramento.c)
 static i2c_inst_t *i2c_instance;
 
-static void lcd_send_command(uint8_t cmd) {
-  uint8_t upper = cmd & 0xF0;
-  uint8_t lower = (cmd << 4) & 0xF0;
+// Espelho do conteúdo do display e posição do cursor (endereço da DDRAM), para escrever só o que mudou
+// e para que as animações (IRQ de software, ver animacao.c) devolvam o cursor onde o loop principal o deixou
+static char espelho[LCD_ROWS][LCD_COLS];
+static volatile uint8_t endereco = 0;
+static const uint8_t row_offsets[] = {0x00, 0x40, 0x14, 0x54};
+
+#define LCD_ESPERA_LIGAR_US 50000 // 40 ms da folha de dados do HD44780, com margem
 
-  uint8_t data[4] = {
-    upper | 0x0C, // Envia habilitação
-    upper,        // Desativa habilitação
-    lower | 0x0C, // Envia habilitação
-    lower         // Desativa habilitação
-  };
+// Bit 3 do PCF8574: luz de fundo, mantida em todos os bytes enviados (ver lcd_luz_fundo)
+#define LUZ_FUNDO 0x08
+#define HABILITACAO 0x04
+static volatile uint8_t luz_fundo = LUZ_FUNDO;
 
-  i2c_write_blocking(i2c_instance, LCD_ADDR, data, sizeof(data), false);
+bool lcd_disponivel_para_irq(void) {
+  return barramento_livre();
 }
 
-// escrita de caractere no LCD
-void lcd_send_char(char c) {
-  uint8_t upper = c & 0xF0;
-  uint8_t lower = (c << 4) & 0xF0;
+// Posição no espelho de um endereço da DDRAM (linhas 0 e 2 em 0x00-0x27, linhas 1 e 3 em 0x40-0x67)
+static char *celula(uint8_t addr) {
+  int linha = (addr >= 0x40) ? 1 : 0;
+  int coluna = addr - (linha ? 0x40 : 0x00);
+  if (coluna >= LCD_COLS) {
+    linha += 2;
+    coluna -= LCD_COLS;
+  }
+  return (coluna < LCD_COLS) ? &espelho[linha][coluna] : NULL;
+}
+
+// Endereço seguinte após uma escrita (o HD44780 pula de 0x27 para 0x40 e de 0x67 para 0x00)
+static uint8_t proximo_endereco(uint8_t addr) {
+  addr++;
+  if (addr == 0x28) return 0x40;
+  if (addr == 0x68) return 0x00;
+  return addr;
+}
+
+// Toda escrita no PCF8574 passa por aqui, para aparecer no rastreamento de eventos.
+// Uma escrita pode levar vários caracteres: em 400 kHz cada um ocupa 4 bytes (90 µs) no fio, acima dos
+// 37 µs de execução do HD44780, então não é preciso esperar entre eles
+static void transmitir(const uint8_t *data, size_t len) {
+  rastreio_evento(RASTREIO_I2C_INICIO, LCD_ADDR, len);
+  barramento_reservar();
+  barramento_selecionar(LCD_ADDR);
+  int ret = i2c_write_blocking(i2c_instance, LCD_ADDR, data, len, false);
+  barramento_liberar();
+  rastreio_evento(RASTREIO_I2C_FIM, LCD_ADDR, ret);
+  pilha_marcar(); // folha mais profunda das telas, no loop, no callback do IR e nas animações
+}
+
+// Escrita do loop principal: é a resposta do firmware a uma tecla, e fecha a medição de latência se
+// uma tecla aguardava esta atualização. Os quadros das animações usam transmitir direto: um quadro
+// qualquer no meio da espera não é a reação à tecla
+static void lcd_i2c_escrever(const uint8_t *data, size_t len) {
+  transmitir(data, len);
+  latencia_escrita_lcd();
+}
+
+// Codifica um byte nos 4 bytes do PCF8574 (dois nibbles com pulso de habilitação); dado = RS ligado
+static size_t NA_RAM(codificar)(uint8_t *destino, uint8_t valor, bool dado) {
+  uint8_t upper = valor & 0xF0;
+  uint8_t lower = (valor << 4) & 0xF0;
+  uint8_t rs = dado ? 0x01 : 0x00;
+  uint8_t luz = luz_fundo;
+  destino[0] = upper | HABILITACAO | luz | rs; // Envia habilitação
+  destino[1] = upper | luz | rs;               // Desativa habilitação
+  destino[2] = lower | HABILITACAO | luz | rs; // Envia habilitação
+  destino[3] = lower | luz | rs;               // Desativa habilitação
+  return 4;
+}
+
+static void lcd_send_command(uint8_t cmd) {
+  uint8_t data[4];
+  lcd_i2c_escrever(data, codificar(data, cmd, false));
+}
 
-  uint8_t data[4] = {
-    upper | 0x0D, // Envia habilitação
-    upper,        // Desativa habilitação
-    lower | 0x0D, // Envia habilitação
-    lower         // Desativa habilitação
-  };
+// Acrescenta um caractere à escrita em montagem e atualiza o espelho e o endereço do cursor
+// (com o barramento reservado, para a escrita e o espelho não se separarem)
+static size_t NA_RAM(enfileirar_caractere)(uint8_t *destino, char ch) {
+  char *c = celula(endereco);
+  if (c) *c = ch;
+  endereco = proximo_endereco(endereco);
+  return codificar(destino, ch, true);
+}
 
-  i2c_write_blocking(i2c_instance, LCD_ADDR, data, sizeof(data), false);
+static size_t enfileirar_posicao(uint8_t *destino, uint8_t addr) {
+  endereco = addr;
+  return codificar(destino, 0x80 | addr, false);
+}
+
+// escrita de caractere no LCD
+void NA_RAM(lcd_send_char)(char ch) {
+  uint8_t data[4];
+  barramento_reservar(); // escrita e espelho atualizados sem uma escrita de animação no meio
+  lcd_i2c_escrever(data, enfileirar_caractere(data, ch));
+  barramento_liberar();
 }
 
 void lcd_init(i2c_inst_t *i2c) {
   i2c_instance = i2c;
 
-  sleep_ms(50); // Aguarda inicialização do LCD
+  // O HD44780 precisa de 40 ms depois que a alimentação sobe: a espera conta desde o reset, e o que o boot
+  // já fez antes (IR, LEDs, PWM) sai desse tempo
+  sleep_until(from_us_since_boot(LCD_ESPERA_LIGAR_US));
   lcd_send_command(0x03);
-  sleep_ms(5);
+  sleep_us(4100);     // mínimo da folha de dados após o primeiro 0x03
   lcd_send_command(0x03);
   sleep_us(150);
   lcd_send_command(0x03);
@@ -59,23 +134,41 @@ void lcd_init(i2c_inst_t *i2c) {
   sleep_ms(2);
   lcd_send_command(0x06); // Incrementa cursor
   lcd_send_command(0x0C); // Liga display e cursor
+  memset(espelho, ' ', sizeof(espelho));
+  endereco = 0;
+}
+
+// Liga ou desliga a luz de fundo sem mexer no conteúdo: um byte com o novo bit 3 e a habilitação
+// desligada (o HD44780 ignora o byte)
+void lcd_luz_fundo(bool ligada) {
+  uint8_t byte = ligada ? LUZ_FUNDO : 0x00;
+  barramento_reservar(); // a próxima escrita de animação já codifica com o novo valor
+  luz_fundo = byte;
+  lcd_i2c_escrever(&byte, 1);
+  barramento_liberar();
+}
+
+bool lcd_luz_fundo_ligada(void) {
+  return luz_fundo != 0;
 }
 
 // Limpa o display
+// As animações em andamento são canceladas: pertencem à tela anterior
 void lcd_clear() {
+  animacao_cancelar_todas();
+  gravador_tela();        // marca o início de uma nova tela na gravação
+  latencia_marco(MARCO_REACAO);
+  barramento_reservar(); // nenhuma escrita de animação durante a execução do comando (1,5 ms)
   lcd_send_command(0x01); // Comando para limpar
   sleep_ms(2);
+  memset(espelho, ' ', sizeof(espelho));
+  endereco = 0;
+  barramento_liberar();
 }
 
 
 void init_i2c_lcd() {
-  i2c_init(I2C_PORT, 100 * 1000); // configura o barramento I2C para 100 kHz
-  // Define os pinos SDA e SCL
-  gpio_set_function(SDA_PIN, GPIO_FUNC_I2C);
-  gpio_set_function(SCL_PIN, GPIO_FUNC_I2C);
-  // habilita resistores de pull up para comunicação estável
-  gpio_pull_up(SDA_PIN);
-  gpio_pull_up(SCL_PIN);
+  barramento_iniciar(); // configura o barramento I2C e os pinos SDA e SCL
 
   lcd_init(I2C_PORT); // inicializa o LCD
   lcd_clear();       // limpa a tela
@@ -83,23 +176,114 @@ void init_i2c_lcd() {
 
 // Configura a linha e a coluna do começo da escrita do buffer
 void lcd_set_cursor(int row, int col) {
-  const uint8_t row_offsets[] = {0x00, 0x40, 0x14, 0x54};
-  lcd_send_command(0x80 | (col + row_offsets[row]));
+  uint8_t data[4];
+  barramento_reservar();
+  lcd_i2c_escrever(data, enfileirar_posicao(data, col + row_offsets[row]));
+  barramento_liberar();
 }
 
+// Escreve o texto na posição, completando a largura com espaços, e envia apenas os caracteres que
+// diferem do espelho; o cursor só é reposicionado quando necessário. Tudo vai em uma única escrita I2C.
+static void compor(int row, int col, const char *text, int width, bool quadro_animacao) {
+  if (row < 0 || row >= LCD_ROWS || col < 0) return;
+  uint8_t buffer[LCD_COLS * 8]; // pior caso: reposicionamento antes de cada caractere
+  size_t n = 0;
+  bool fim_texto = false;
+  barramento_reservar();
+  for (int i = 0; i < width && col + i < LCD_COLS; i++) {
+    char ch = ' ';
+    if (!fim_texto && text[i] != '\0') {
+      ch = text[i];
+    } else {
+      fim_texto = true;
+    }
+    if (espelho[row][col + i] == ch) continue;
+    uint8_t addr = row_offsets[row] + col + i;
+    if (endereco != addr) n += enfileirar_posicao(buffer + n, addr);
+    n += enfileirar_caractere(buffer + n, ch);
+  }
+  if (n > 0) {
+    if (quadro_animacao) transmitir(buffer, n);
+    else lcd_i2c_escrever(buffer, n);
+  }
+  barramento_liberar();
+}
+
+void lcd_compor(int row, int col, const char *text, int width) {
+  compor(row, col, text, width, false);
+}
+
+void lcd_compor_quadro(int row, int col, const char *text, int width) {
+  compor(row, col, text, width, true);
+}
 
+// Endereço atual do cursor, para as animações o devolverem após escrever
+uint8_t lcd_endereco_cursor(void) {
+  return endereco;
+}
+
+void lcd_restaurar_cursor(uint8_t addr) {
+  if (endereco != addr) {
+    uint8_t data[4];
+    transmitir(data, codificar(data, 0x80 | addr, false)); // só as animações: não fecha a latência
+    endereco = addr;
+  }
+}
+
+
+// Os caracteres vão em blocos de uma linha por escrita I2C, em vez de uma transação por caractere
 void lcd_print(const char *str) {
+  uint8_t buffer[LCD_COLS * 4];
+  barramento_reservar();
   while (*str) {
-    lcd_send_char(*str++);
+    size_t n = 0;
+    while (*str && n < sizeof(buffer)) {
+      n += enfileirar_caractere(buffer + n, *str++);
+    }
+    lcd_i2c_escrever(buffer, n);
   }
+  barramento_liberar();
 }
 
 void create_custom_char(int location, uint8_t charmap[]) {
   location &= 0x7; // O LCD suporta 8 caracteres (0-7)
-  lcd_send_command(0x40 | (location << 3));
-  for (int i = 0; i < 8; i++) {
-    lcd_send_char(charmap[i]);
+  glifos_invalidar(location); // o slot deixa de conter o glifo que o cache registrava
+  uint8_t slot = location;
+  lcd_carregar_cgram(&slot, (const uint8_t (*)[8])charmap, 1);
+}
+
+// Grava vários slots da CGRAM em uma única transação I2C; slots consecutivos dispensam o comando de
+// endereço (a CGRAM avança sozinha) e o cursor volta à posição da DDRAM no fim
+void lcd_carregar_cgram(const uint8_t *slots, const uint8_t (*desenhos)[8], int total) {
+  uint8_t buffer[8 * (4 + 8 * 4) + 4];
+  size_t n = 0;
+  if (total <= 0) return;
+  if (total > 8) total = 8;
+
+  for (int g = 0; g < total; g++) {
+    if (g == 0 || slots[g] != slots[g - 1] + 1) {
+      n += codificar(buffer + n, 0x40 | ((slots[g] & 0x7) << 3), false);
+    }
+    for (int i = 0; i < 8; i++) {
+      n += codificar(buffer + n, desenhos[g][i], true);
+    }
+  }
+
+  barramento_reservar();
+  n += codificar(buffer + n, 0x80 | endereco, false);
+  lcd_i2c_escrever(buffer, n);
+  barramento_liberar();
+}
+
+// Slot da CGRAM (0-7) visível em alguma célula do display (códigos 0-7 e seus espelhos 8-15)
+bool lcd_cgram_visivel(int slot) {
+  for (int l = 0; l < LCD_ROWS; l++) {
+    for (int c = 0; c < LCD_COLS; c++) {
+      uint8_t ch = espelho[l][c];
+      if (ch < 16 && (ch & 0x7) == slot) return true;
+    }
   }
+  return false;
 }
 
 void display_custom_char(int location, int row, int col) {
@@ -108,52 +292,26 @@ void display_custom_char(int location, int row, int col) {
 }
 
 // Funções de animação
+// Os efeitos rodam no motor de animações (animacao.c), a cada tique do temporizador, e retornam
+// imediatamente; o texto é copiado, então o chamador pode reutilizar o buffer.
 
-//animação de texto deslizando
+//animação de texto deslizando (contínua até lcd_clear ou animacao_cancelar)
 void scroll_text(const char *message, int row, int delay_ms) {
-  int len = strlen(message);
-  char buffer[LCD_COLS + 1] = {0};
-
-  for (int start = 0; start < len; start++) {
-    strncpy(buffer, message + start, LCD_COLS);
-    buffer[LCD_COLS] = '\0';
-
-    lcd_set_cursor(row, 0);
-    lcd_print(buffer);
-    sleep_ms(delay_ms);
-
-    if (start + LCD_COLS >= len) {
-      start = -1; // Reinicia o ciclo
-    }
-  }
+  animacao_rolar(message, row, delay_ms);
 }
 //exemplo de uso na main:
 //scroll_text("Bem-vindo ao Raspberry Pi Pico! ", 0, 200);
 
 //animação de texto digitando
 void type_effect(const char *message, int row, int delay_ms) {
-  lcd_set_cursor(row, 0);
-  for (int i = 0; i < strlen(message); i++) {
-    lcd_print((char[]) {
-      message[i], '\0'
-    }); // Envia um caractere por vez
-    sleep_ms(delay_ms);
-  }
+  animacao_digitar(message, row, delay_ms);
 }
 //exemplo de uso na main:
 //type_effect("Hello, World!", 0, 100);
 
-//animação de barra de progresso
+//barra de progresso com resolução de uma coluna de pixel (5 por caractere, glifos parciais na CGRAM)
 void progress_bar(int percentage, int row) {
-  int filled = (percentage * LCD_COLS) / 100;
-  lcd_set_cursor(row, 0);
-  for (int i = 0; i < LCD_COLS; i++) {
-    if (i < filled) {
-      lcd_print("_");
-    } else {
-      lcd_print(" ");
-    }
-  }
+  glifos_barra(row, 0, LCD_COLS, percentage);
 }
 //exemplo de uso na main:
 //for (int i = 0; i <= 100; i += 10) {
@@ -163,53 +321,21 @@ void progress_bar(int percentage, int row) {
 
 //animação de texto piscando/alerta
 void blink_text(const char *message, int row, int col, int times, int delay_ms) {
-  for (int i = 0; i < times; i++) {
-    lcd_set_cursor(row, col);
-    lcd_print(message);
-    sleep_ms(delay_ms);
-
-    lcd_set_cursor(row, col);
-    for (int j = 0; j < strlen(message); j++) {
-      lcd_print(" "); // Apaga o texto
-    }
-    sleep_ms(delay_ms);
-  }
-
-  // Restaura o texto
-  lcd_set_cursor(row, col);
-  lcd_print(message);
+  animacao_piscar(message, row, col, times, delay_ms);
 }
 //exemplo de uso na main:
 //blink_text("ALERTA!", 0, 5, 5, 500);
 
 //animação Efeito de Apagar e Escrever
 void fade_text(const char *message1, const char *message2, int row, int delay_ms) {
-  lcd_set_cursor(row, 0);
-  lcd_print(message1);
-  sleep_ms(delay_ms);
-
-  for (int i = strlen(message1); i >= 0; i--) {
-    lcd_set_cursor(row, i);
-    lcd_print(" ");
-    sleep_ms(50);
-  }
-
-  lcd_set_cursor(row, 0);
-  lcd_print(message2);
+  animacao_apagar_escrever(message1, message2, row, delay_ms);
 }
 //exemplo de uso na main:
 //fade_text("Bem-vindo!", "Aprendendo C!", 0, 1000);
 
 //animação relógio simples
 void simple_clock() {
-  for (int seconds = 0; seconds < 1000; seconds++) {
-    char time[20];
-    snprintf(time, sizeof(time), "Tempo: %03d seg", seconds);
-    lcd_set_cursor(0, 0);
-    lcd_print(time);
-    sleep_ms(1000);
-  }
+  animacao_contador(0);
 }
 //exemplo de uso na main:
 //simple_clock();
-
@@ -5,7 +5,7 @@
 
 #include "hardware/i2c.h"
 
-#define LCD_ADDR 0x27 // Endereço padrão do PCF8574
+#include "placa.h" // endereço do PCF8574
 #define LCD_ROWS 4
 #define LCD_COLS 20
 
@@ -17,10 +17,19 @@ void lcd_print(const char *str);
 void lcd_send_char(char c);
 void create_custom_char(int location, uint8_t charmap[]);
 void display_custom_char(int location, int row, int col);
+void lcd_compor(int row, int col, const char *text, int width); // escreve só os caracteres alterados
+void lcd_compor_quadro(int row, int col, const char *text, int width); // idem, quadro de animação
+void lcd_carregar_cgram(const uint8_t *slots, const uint8_t (*desenhos)[8], int total); // uma transação I2C
+bool lcd_cgram_visivel(int slot);
+uint8_t lcd_endereco_cursor(void);
+void lcd_restaurar_cursor(uint8_t addr);
+void lcd_luz_fundo(bool ligada);   // luz de fundo do PCF8574 (modo ocioso, ver energia.h)
+bool lcd_luz_fundo_ligada(void);
+bool lcd_disponivel_para_irq(void); // nenhuma sequência do loop principal no barramento (ver barramento.h)
 
 
 
-// Funções de animação
+// Funções de animação (não bloqueantes, ver animacao.h)
 void scroll_text(const char *message, int row, int delay_ms);
 void type_effect(const char *message, int row, int delay_ms);
 void progress_bar(int percentage, int row);
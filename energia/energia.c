@@ -0,0 +1,251 @@
+// energia.c
+// Modo ocioso entre os eventos: luz de fundo apagada e sono profundo do núcleo
+
+#include "energia.h"
+#include <stdio.h>
+#include "pico/stdlib.h"
+#include "hardware/sync.h"
+#include "hardware/gpio.h"
+#include "hardware/structs/scb.h"
+#include "hardware/structs/clocks.h"
+#include "lcd_i2c.h"
+#include "estado.h"
+#include "monitor.h"
+#include "perfil.h"
+#include "frequencia.h"
+#include "servidor_status.h"
+#include "placa.h"
+
+// Clocks que continuam ligados no sono profundo: temporizador e GPIO (acordam o núcleo), USB, watchdog,
+// memórias, PLLs e o PWM dos servos (mantém as comportas na posição). I2C, ADC, PIO, SPI, UART, DMA e
+// o RTC interno param até a próxima IRQ; o hardware religa todos ao acordar. O barramento do CYW43 é
+// um PIO: o rádio só é lido depois que o host-wake (GPIO) acorda o núcleo.
+#define SONO_EN0 (CLOCKS_SLEEP_EN0_CLK_SYS_CLOCKS_BITS | CLOCKS_SLEEP_EN0_CLK_SYS_BUSCTRL_BITS | \
+                  CLOCKS_SLEEP_EN0_CLK_SYS_BUSFABRIC_BITS | CLOCKS_SLEEP_EN0_CLK_SYS_IO_BITS | \
+                  CLOCKS_SLEEP_EN0_CLK_SYS_PADS_BITS | CLOCKS_SLEEP_EN0_CLK_SYS_VREG_AND_CHIP_RESET_BITS | \
+                  CLOCKS_SLEEP_EN0_CLK_SYS_PLL_SYS_BITS | CLOCKS_SLEEP_EN0_CLK_SYS_PLL_USB_BITS | \
+                  CLOCKS_SLEEP_EN0_CLK_SYS_PWM_BITS | CLOCKS_SLEEP_EN0_CLK_SYS_SIO_BITS | \
+                  CLOCKS_SLEEP_EN0_CLK_SYS_SRAM0_BITS | CLOCKS_SLEEP_EN0_CLK_SYS_SRAM1_BITS | \
+                  CLOCKS_SLEEP_EN0_CLK_SYS_SRAM2_BITS | CLOCKS_SLEEP_EN0_CLK_SYS_SRAM3_BITS)
+#define SONO_EN1 (CLOCKS_SLEEP_EN1_CLK_SYS_SRAM4_BITS | CLOCKS_SLEEP_EN1_CLK_SYS_SRAM5_BITS | \
+                  CLOCKS_SLEEP_EN1_CLK_SYS_SYSCFG_BITS | CLOCKS_SLEEP_EN1_CLK_SYS_TIMER_BITS | \
+                  CLOCKS_SLEEP_EN1_CLK_SYS_USBCTRL_BITS | CLOCKS_SLEEP_EN1_CLK_USB_USBCTRL_BITS | \
+                  CLOCKS_SLEEP_EN1_CLK_SYS_WATCHDOG_BITS | CLOCKS_SLEEP_EN1_CLK_SYS_XIP_BITS | \
+                  CLOCKS_SLEEP_EN1_CLK_SYS_XOSC_BITS)
+
+#define PASSO_SONO_US 1000000 // o loop volta ao monitor ao menos uma vez por segundo (watchdog)
+
+static const char *nomes[TOTAL_ESTADOS_ENERGIA] = {"ATIVO", "OCIOSO", "SONO"};
+
+// O que tirou o núcleo do WFI, visto antes de a IRQ ser tratada
+typedef enum {
+  ACORDOU_IR,     // borda do receptor IR
+  ACORDOU_PASSO,  // alarme do passo de sono
+  ACORDOU_RADIO,  // host-wake do CYW43 (pacote ou evento do rádio)
+  ACORDOU_OUTRO,  // temporizadores do lwIP, USB e demais IRQs
+  TOTAL_ORIGENS,
+} OrigemDespertar;
+
+static const char *nomes_origens[TOTAL_ORIGENS] = {"ir", "passo", "radio", "outros"};
+
+static EstadoEnergia estado_energia = ENERGIA_ATIVO;
+static uint64_t tempo_us[TOTAL_ESTADOS_ENERGIA];
+static uint64_t marca_us = 0;          // início do trecho ainda não contabilizado
+static uint64_t proximo_tique_us = 0;  // próxima volta da máquina de estados no modo ocioso
+static uint32_t entradas_ocioso = 0;
+static uint32_t despertares = 0;
+static uint32_t estouros = 0;          // despertares acima de ENERGIA_LATENCIA_MAX_US
+static uint32_t latencia_max_us = 0;
+static uint64_t latencia_soma_us = 0;
+static uint32_t acordou_por[TOTAL_ORIGENS];
+
+static volatile bool tecla_pendente = false;
+static volatile uint64_t tecla_us = 0;
+static volatile bool relatorio_pendente = false;
+
+// Soma ao estado informado o tempo desde a última marca
+static void contabilizar(EstadoEnergia estado) {
+  uint64_t agora = time_us_64();
+  tempo_us[estado] += agora - marca_us;
+  marca_us = agora;
+}
+
+void energia_tecla(void) {
+  tecla_us = time_us_64();
+  tecla_pendente = true;
+  __sev();
+}
+
+EstadoEnergia energia_estado(void) {
+  return estado_energia;
+}
+
+uint64_t energia_tempo_us(EstadoEnergia estado) {
+  return tempo_us[estado];
+}
+
+void energia_iniciar(void) {
+  marca_us = time_us_64();
+}
+
+// -------------------------------------------------------------------------------------------------- //
+// Sono profundo
+
+static int64_t alarme_acordar(alarm_id_t id, void *dados) {
+  return 0; // basta a IRQ do alarme para sair do WFI
+}
+
+static bool deve_acordar(void) {
+  return tecla_pendente || estado_evento_pendente();
+}
+
+// Com as interrupções mascaradas, a IRQ que acordou o núcleo ainda está pendente no registrador dela
+static OrigemDespertar origem_despertar(uint64_t limite_us) {
+  if (gpio_get_irq_event_mask(IR_SENSOR_GPIO_PIN)) return ACORDOU_IR;
+  if (servidor_status_irq_radio()) return ACORDOU_RADIO;
+  if (time_us_64() >= limite_us) return ACORDOU_PASSO;
+  return ACORDOU_OUTRO;
+}
+
+// Dorme até uma tecla, um evento ou o limite. As interrupções ficam mascaradas entre o teste e o WFI:
+// uma IRQ pendente ainda acorda o núcleo, e só é tratada depois, ao religá-las. A verificação do
+// monitor (10 Hz) e o perfilador (1 kHz) param durante o sono; senão acordariam o núcleo a cada tique.
+// O rádio, se ligado, continua acordando o núcleo (ver energia.h); cada despertar é contado pela origem
+static void dormir_ate(uint64_t limite_us) {
+  bool perfilando = perfil_ativo();
+  perfil_parar();
+  monitor_pausar();
+  alarm_id_t alarme = add_alarm_at(from_us_since_boot(limite_us), alarme_acordar, NULL, true);
+
+  clocks_hw->sleep_en0 = SONO_EN0;
+  clocks_hw->sleep_en1 = SONO_EN1;
+  scb_hw->scr |= M0PLUS_SCR_SLEEPDEEP_BITS;
+
+  uint32_t irq = save_and_disable_interrupts();
+  while (!deve_acordar() && time_us_64() < limite_us) {
+    contabilizar(ENERGIA_OCIOSO);
+    __wfi();
+    acordou_por[origem_despertar(limite_us)]++;
+    frequencia_registrar_espera((uint32_t)(time_us_64() - marca_us));
+    contabilizar(ENERGIA_SONO);
+    restore_interrupts(irq); // trata a IRQ que acordou o núcleo
+    irq = save_and_disable_interrupts();
+  }
+  restore_interrupts(irq);
+
+  scb_hw->scr &= ~M0PLUS_SCR_SLEEPDEEP_BITS;
+  clocks_hw->sleep_en0 = ~0u;
+  clocks_hw->sleep_en1 = ~0u;
+  if (alarme > 0) cancel_alarm(alarme);
+  monitor_retomar();
+  if (perfilando) perfil_iniciar();
+}
+
+// -------------------------------------------------------------------------------------------------- //
+// Transições
+
+// Só nas telas que esperam pelo usuário ou pelo relógio; as demais rotinas têm seus próprios prazos
+bool energia_tela_de_espera(void) {
+  Estado e = estado_corrente();
+  return e == ESTADO_TELA_INICIAL || e == ESTADO_AGUARDANDO;
+}
+
+static uint64_t ultima_atividade_us(void) {
+  uint32_t irq = save_and_disable_interrupts(); // tecla_us é escrito na IRQ do IR
+  uint64_t tecla = tecla_us;
+  restore_interrupts(irq);
+  uint64_t evento = estado_ultimo_evento_us();
+  return evento > tecla ? evento : tecla;
+}
+
+static void entrar_ocioso(void) {
+  contabilizar(ENERGIA_ATIVO);
+  lcd_luz_fundo(false);
+  servidor_status_modo_ocioso(true);
+  estado_energia = ENERGIA_OCIOSO;
+  proximo_tique_us = time_us_64() + ENERGIA_PERIODO_OCIOSO_MS * 1000ull;
+  entradas_ocioso++;
+}
+
+// Acende o display e mede o tempo desde a tecla (ou o evento) que acordou a máquina
+static void sair_ocioso(void) {
+  lcd_luz_fundo(true);
+  servidor_status_modo_ocioso(false);
+  contabilizar(ENERGIA_OCIOSO);
+  estado_energia = ENERGIA_ATIVO;
+
+  uint32_t latencia = (uint32_t)(time_us_64() - ultima_atividade_us());
+  latencia_soma_us += latencia;
+  if (latencia > latencia_max_us) latencia_max_us = latencia;
+  if (latencia > ENERGIA_LATENCIA_MAX_US) estouros++;
+  despertares++;
+}
+
+void energia_aguardar_evento(uint32_t tempo_limite_ms) {
+  if (estado_energia == ENERGIA_ATIVO) {
+    if (!energia_tela_de_espera() || time_us_64() - ultima_atividade_us() < ENERGIA_INATIVIDADE_MS * 1000ull) {
+      uint64_t inicio = time_us_64();
+      estado_aguardar_evento(tempo_limite_ms);
+      frequencia_registrar_espera((uint32_t)(time_us_64() - inicio)); // inclui as IRQs tratadas na espera
+      contabilizar(ENERGIA_ATIVO);
+      tecla_pendente = false;
+      return;
+    }
+    entrar_ocioso();
+  }
+
+  // Ocioso: o loop principal só volta para o próximo tique ou para uma tecla; entre os passos de sono o
+  // monitor continua vendo o loop girar
+  while (!deve_acordar() && time_us_64() < proximo_tique_us) {
+    uint64_t passo = time_us_64() + PASSO_SONO_US;
+    dormir_ate(passo < proximo_tique_us ? passo : proximo_tique_us);
+    monitor_ciclo();
+  }
+  contabilizar(ENERGIA_OCIOSO);
+
+  if (deve_acordar()) {
+    tecla_pendente = false;
+    sair_ocioso();
+  } else {
+    proximo_tique_us += ENERGIA_PERIODO_OCIOSO_MS * 1000ull;
+  }
+}
+
+// -------------------------------------------------------------------------------------------------- //
+// Relatório
+
+void energia_solicitar_relatorio(void) {
+  relatorio_pendente = true;
+}
+
+static void imprimir_relatorio() {
+  contabilizar(estado_energia);
+  uint64_t total = 0;
+  for (int e = 0; e < TOTAL_ESTADOS_ENERGIA; e++) {
+    total += tempo_us[e];
+  }
+
+  printf("ENER INICIO estado=%s\n", nomes[estado_energia]);
+  for (int e = 0; e < TOTAL_ESTADOS_ENERGIA; e++) {
+    printf("ENER %-6s %lu ms %lu.%lu%%\n", nomes[e], (unsigned long)(tempo_us[e] / 1000),
+           (unsigned long)(total ? tempo_us[e] * 100 / total : 0),
+           (unsigned long)(total ? tempo_us[e] * 1000 / total % 10 : 0));
+  }
+  printf("ENER entradas=%lu despertares=%lu latencia media=%lu max=%lu us estouros=%lu (limite %u us)\n",
+         (unsigned long)entradas_ocioso, (unsigned long)despertares,
+         (unsigned long)(despertares ? latencia_soma_us / despertares : 0), (unsigned long)latencia_max_us,
+         (unsigned long)estouros, ENERGIA_LATENCIA_MAX_US);
+  printf("ENER sono acordado por");
+  for (int o = 0; o < TOTAL_ORIGENS; o++) {
+    printf(" %s=%lu", nomes_origens[o], (unsigned long)acordou_por[o]);
+  }
+  printf("\n");
+  printf("ENER FIM\n");
+}
+
+void energia_servico(void) {
+  if (relatorio_pendente) {
+    relatorio_pendente = false;
+    imprimir_relatorio();
+  }
+}
@@ -0,0 +1,51 @@
+// energia.h
+// Modo ocioso: sem teclas por ENERGIA_INATIVIDADE_MS na tela inicial (ou aguardando um preparo
+// agendado), a luz de fundo do LCD apaga e o loop principal passa a dormir entre os eventos, com o
+// núcleo em sono profundo (WFI com SLEEPDEEP) e os clocks dos periféricos parados. Não é o modo
+// DORMANT: os osciladores e os PLLs continuam ligados, e o temporizador continua contando.
+// Antes de dormir param os temporizadores periódicos (verificação do monitor e perfilador, se ligado;
+// animações e barra de LEDs já param sozinhas quando estáticas). Acordam o núcleo a borda do receptor
+// IR (a tecla é decodificada normalmente e acende o display) e o alarme do passo de sono: o próximo
+// tique do estado (relógio, ambiente e horário agendado), no máximo a cada 1 s para o loop voltar ao
+// monitor (e ao watchdog, se habilitado). Com o servidor de status (SERVIDOR_STATUS=1) o rádio continua
+// associado para responder no modo ocioso, em economia agressiva (servidor_status.h), e também acorda o
+// núcleo: o host-wake do CYW43 e os temporizadores do lwIP (ARP e DHCP, da ordem de 1 por segundo).
+// O tempo em cada estado de energia, a latência entre a tecla e a luz de fundo acesa e os despertares
+// do sono por origem vão pela USB com a tecla TEST.
+
+#ifndef ENERGIA_H
+#define ENERGIA_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef ENERGIA_INATIVIDADE_MS
+#define ENERGIA_INATIVIDADE_MS 30000   // sem teclas nem eventos por esse tempo: modo ocioso
+#endif
+
+#ifndef ENERGIA_PERIODO_OCIOSO_MS
+#define ENERGIA_PERIODO_OCIOSO_MS 20000 // tique do estado no modo ocioso (o agendamento compara minutos)
+#endif
+
+#ifndef ENERGIA_LATENCIA_MAX_US
+#define ENERGIA_LATENCIA_MAX_US 50000   // orçamento entre a tecla e o display aceso
+#endif
+
+typedef enum {
+  ENERGIA_ATIVO,  // display aceso, tique a cada 200 ms
+  ENERGIA_OCIOSO, // display apagado, núcleo acordado (tiques, IRQs)
+  ENERGIA_SONO,   // display apagado, núcleo em sono profundo
+  TOTAL_ESTADOS_ENERGIA,
+} EstadoEnergia;
+
+void energia_iniciar(void);
+void energia_tecla(void);                              // tecla recebida (seguro em IRQ): acorda o modo ocioso
+void energia_aguardar_evento(uint32_t tempo_limite_ms); // substitui estado_aguardar_evento no loop principal
+EstadoEnergia energia_estado(void);
+bool energia_tela_de_espera(void);  // tela inicial ou preparo agendado: modo ocioso e clock baixo
+uint64_t energia_tempo_us(EstadoEnergia estado);
+
+void energia_solicitar_relatorio(void); // relatório pela USB (seguro em IRQ)
+void energia_servico(void);             // relatório pendente, no loop principal
+
+#endif // ENERGIA_H
@@ -0,0 +1,138 @@
+// frequencia.c
+// Perfis de clock do sistema e recálculo dos periféricos que dependem de clk_sys/clk_peri
+
+#include "frequencia.h"
+#include <stdio.h>
+#include "pico/stdlib.h"
+#include "hardware/clocks.h"
+#if LIB_PICO_STDIO_UART
+#include "hardware/uart.h"
+#endif
+#include "alocador_pwm.h"
+#include "barramento.h"
+#include "energia.h"
+#include "estado.h"
+
+static const struct {
+  const char *nome;
+  uint32_t khz;
+} perfis[TOTAL_PERFIS_FREQ] = {
+  [FREQ_BAIXA]  = {"BAIXA", 48000},   // VCO 1440 MHz / 6 / 5
+  [FREQ_NORMAL] = {"NORMAL", 125000}, // VCO 1500 MHz / 6 / 2
+  [FREQ_ALTA]   = {"ALTA", 133000},   // VCO 1596 MHz / 6 / 2
+};
+
+static PerfilFrequencia atual = FREQ_NORMAL;
+static uint64_t tempo_us[TOTAL_PERFIS_FREQ];
+static uint64_t espera_us[TOTAL_PERFIS_FREQ];
+static uint64_t marca_us = 0;
+static uint32_t trocas = 0;
+static uint32_t falhas = 0;
+static uint32_t custo_max_us = 0; // troca do PLL mais o recálculo dos periféricos
+static uint64_t custo_soma_us = 0;
+static uint64_t ultimo_evento_us = 0; // início da retenção do perfil ALTA
+static volatile bool relatorio_pendente = false;
+
+static void contabilizar(void) {
+  uint64_t agora = time_us_64();
+  tempo_us[atual] += agora - marca_us;
+  marca_us = agora;
+}
+
+void frequencia_iniciar(void) {
+  marca_us = time_us_64();
+}
+
+PerfilFrequencia frequencia_perfil_atual(void) {
+  return atual;
+}
+
+void frequencia_registrar_espera(uint32_t us) {
+  espera_us[atual] += us;
+}
+
+// A troca acontece no loop principal, entre transações: a reserva do barramento segura a escrita das
+// animações até o I2C ter os divisores do novo clk_peri
+bool frequencia_aplicar(PerfilFrequencia perfil) {
+  if (perfil == atual) return true;
+  uint32_t inicio = time_us_32();
+
+  barramento_reservar();
+  contabilizar();
+  bool ok = set_sys_clock_khz(perfis[perfil].khz, false);
+  if (ok) {
+    atual = perfil;
+    pwm_alocador_recalcular();
+    barramento_recalcular();
+#if LIB_PICO_STDIO_UART
+    uart_set_baudrate(uart_default, PICO_DEFAULT_UART_BAUD_RATE);
+#endif
+  }
+  barramento_liberar();
+
+  if (!ok) {
+    falhas++;
+    return false;
+  }
+  uint32_t custo = time_us_32() - inicio;
+  custo_soma_us += custo;
+  if (custo > custo_max_us) custo_max_us = custo;
+  trocas++;
+  return true;
+}
+
+void frequencia_ajustar(void) {
+#if FREQUENCIA_DINAMICA
+  PerfilFrequencia perfil = FREQ_NORMAL;
+  uint64_t agora = time_us_64();
+  if (estado_evento_pendente()) {
+    perfil = FREQ_ALTA;  // o evento troca ou redesenha a tela
+    ultimo_evento_us = agora;
+  } else if (atual == FREQ_ALTA && agora - ultimo_evento_us < FREQUENCIA_RETENCAO_MS * 1000ull) {
+    perfil = FREQ_ALTA;  // histerese: a próxima tecla costuma vir logo em seguida
+  } else if (energia_estado() != ENERGIA_ATIVO || energia_tela_de_espera()) {
+    perfil = FREQ_BAIXA; // só tiques de relógio e ambiente até a próxima tecla
+  }
+  frequencia_aplicar(perfil);
+#endif
+}
+
+// O passo que inicia o preparo ou o agendamento só volta ao loop no fim da rotina: sem isso, o preparo
+// imediato rodaria inteiro em ALTA (o evento da tecla ainda pendente) e o agendado em BAIXA (tique da
+// espera)
+void frequencia_rotina_longa(void) {
+#if FREQUENCIA_DINAMICA
+  frequencia_aplicar(FREQ_NORMAL);
+#endif
+}
+
+// -------------------------------------------------------------------------------------------------- //
+// Relatório
+
+void frequencia_solicitar_relatorio(void) {
+  relatorio_pendente = true;
+}
+
+// Ocupação = tempo fora de WFE/WFI; ciclos do núcleo = tempo ocupado x frequência
+static void imprimir_relatorio() {
+  contabilizar();
+  printf("FREQ INICIO atual=%s clk_sys=%lu trocas=%lu falhas=%lu custo media=%lu max=%lu us\n",
+         perfis[atual].nome, (unsigned long)clock_get_hz(clk_sys), (unsigned long)trocas,
+         (unsigned long)falhas, (unsigned long)(trocas ? custo_soma_us / trocas : 0),
+         (unsigned long)custo_max_us);
+  for (int p = 0; p < TOTAL_PERFIS_FREQ; p++) {
+    uint64_t ocupado = tempo_us[p] > espera_us[p] ? tempo_us[p] - espera_us[p] : 0;
+    printf("FREQ %-6s %lu MHz tempo=%lu ms ocupacao=%lu%% ciclos=%lu M\n", perfis[p].nome,
+           (unsigned long)(perfis[p].khz / 1000), (unsigned long)(tempo_us[p] / 1000),
+           (unsigned long)(tempo_us[p] ? ocupado * 100 / tempo_us[p] : 0),
+           (unsigned long)(ocupado * perfis[p].khz / 1000000000ull));
+  }
+  printf("FREQ FIM\n");
+}
+
+void frequencia_servico(void) {
+  if (relatorio_pendente) {
+    relatorio_pendente = false;
+    imprimir_relatorio();
+  }
+}
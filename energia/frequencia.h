@@ -0,0 +1,45 @@
+// frequencia.h
+// Perfis de clock do sistema, trocados pelo loop principal conforme o trabalho à frente:
+// BAIXA (48 MHz) na tela inicial, aguardando um preparo agendado e no modo ocioso; ALTA (133 MHz)
+// enquanto a máquina de estados trata um evento (troca e redesenho de tela, início do preparo) e por
+// FREQUENCIA_RETENCAO_MS depois do último, para que teclas seguidas não troquem o PLL a cada passo;
+// NORMAL (125 MHz) nas demais rotinas. O preparo e o agendamento bloqueiam o loop dentro do passo que
+// os inicia, depois da escolha do perfil: a ação de estado pede NORMAL com frequencia_rotina_longa.
+// set_sys_clock_khz muda clk_sys e clk_peri; em seguida os divisores derivados deles são recalculados
+// a partir de clock_get_hz: PWM dos servos e do buzzer, I2C e a UART do stdio, quando usada. O
+// temporizador (e com ele sleep_us, os alarmes e a leitura do DHT22), o ADC e a USB têm clocks próprios.
+// Por perfil são contados o tempo, a ocupação da CPU (tempo fora de WFE/WFI) e os ciclos executados pelo
+// núcleo, aproximação do consumo dinâmico; o relatório vai pela USB com a tecla TEST.
+
+#ifndef FREQUENCIA_H
+#define FREQUENCIA_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef FREQUENCIA_DINAMICA
+#define FREQUENCIA_DINAMICA 1 // 0: fica em 125 MHz (só a contabilidade)
+#endif
+
+#ifndef FREQUENCIA_RETENCAO_MS
+#define FREQUENCIA_RETENCAO_MS 300 // ALTA continua por este tempo depois do último evento
+#endif
+
+typedef enum {
+  FREQ_BAIXA,  // 48 MHz
+  FREQ_NORMAL, // 125 MHz, o clock padrão do SDK
+  FREQ_ALTA,   // 133 MHz, o máximo especificado sem mudar a tensão do núcleo
+  TOTAL_PERFIS_FREQ,
+} PerfilFrequencia;
+
+void frequencia_iniciar(void);
+bool frequencia_aplicar(PerfilFrequencia perfil); // false se o clock não puder ser gerado
+void frequencia_ajustar(void);                    // perfil do próximo passo do loop principal
+void frequencia_rotina_longa(void);               // NORMAL já, antes de uma rotina que bloqueia o loop
+PerfilFrequencia frequencia_perfil_atual(void);
+void frequencia_registrar_espera(uint32_t us);    // tempo dormindo em WFE/WFI (energia.c)
+
+void frequencia_solicitar_relatorio(void); // relatório pela USB (seguro em IRQ)
+void frequencia_servico(void);             // relatório pendente, no loop principal
+
+#endif // FREQUENCIA_H
@@ -4,14 +4,18 @@
 #include "controle_ir.h"
 #include "sensores.h"
 #include "lcd_i2c.h"
+#include "gravador.h"
+#include "rastreio.h"
+#include "latencia.h"
+#include "monitor.h"
+#include "frequencia.h"
+#include "placa.h"
+#include "pico/stdlib.h"
+#include "hardware/sync.h"
 #include <stdio.h>
 #include <stdint.h>
 
-// Definição dos pinos
-// pinos compartilhados pelo LCD e RTC (seus endereços estão definidos em suas bibliotecas)
-#define I2C_PORT i2c0        // comunicação i2c para o display LCD e o RTC
-#define SDA_PIN 4
-#define SCL_PIN 5
+#define TAMANHO_FILA 16      // eventos pendentes (potência de 2)
 
 // Variáveis globais
 float agua_ml = 1000.0;         // Reservatório inicial de 1 litro
@@ -19,98 +23,270 @@ float graos_g = 250.0;          // Reservatório inicial de 250g de grãos de ca
 int xicaras = 0;                // Quantidade de xícaras de café
 //buffer que armazena o horário de preparo desejado
 uint8_t dia_config, mes_config, hora_config, minutos_config;
-bool play_apertado = false;     // Indica se o botão PLAY foi pressionado
-bool saudacao_exibida = false;  // flag para exibir apenas uma vez "it's coffee time"
+bool play_apertado = false;     // Indica se o botão PLAY foi pressionado (lido pelas rotinas bloqueantes)
 bool preparo_agora = false;     // flag para início de preparo da bebida
 bool tecla_pressionada = false;
 char tecla[16] = "";
 HorarioConfigurado horario_configurado = {0, 0, 0, 0, false};
-Estado estado_atual = ESTADO_TELA_INICIAL;
-// garante que não haja flicker nos estados de quantidade de xícaras e quando preparar
-Estado ultimo_estado_exibido = ESTADO_TELA_INICIAL;
 
-// Monitora o estado da máquina e chama a função correspondente baseado no estado atual
+static Estado estado_atual = ESTADO_TELA_INICIAL; // escrito apenas pelo motor (executar_transicao)
+static volatile bool redesenho_pendente = false;
+
+// Fila de eventos: escrita pelo callback do IR (IRQ) e pelas ações, lida pelo loop principal
+static volatile uint8_t fila[TAMANHO_FILA];
+static volatile uint32_t fila_cabeca = 0;
+static volatile uint32_t fila_cauda = 0;
+static volatile uint64_t ultimo_evento_us = 0; // inatividade e latência de despertar (energia.c)
+
+// -------------------------------------------------------------------------------------------------- //
+// Guardas e ações das transições
+
+// Compara o horário atual do RTC com o agendado
+static bool horario_atingido(Evento evento) {
+  uint8_t rtc_data[7];
+  rtc_read(I2C_PORT, SDA_PIN, SCL_PIN, rtc_data); // lê o tempo atual
+
+  uint8_t current_day = (rtc_data[4] & 0x0F) + ((rtc_data[4] >> 4) * 10);
+  uint8_t current_month = (rtc_data[5] & 0x0F) + ((rtc_data[5] >> 4) * 10);
+  uint8_t current_hour = (rtc_data[2] & 0x0F) + ((rtc_data[2] >> 4) * 10);
+  uint8_t current_minute = (rtc_data[1] & 0x0F) + ((rtc_data[1] >> 4) * 10);
+
+  return current_day == horario_configurado.dia &&
+         current_month == horario_configurado.mes &&
+         current_hour == horario_configurado.hora &&
+         current_minute == horario_configurado.minutos;
+}
+
+static void atualizar_monitoramento(Evento evento) {
+  if (latencia_tela_visivel()) return; // os campos voltam todos no redesenho, quando a tela fechar
+  atualizar_tela_inicial(); // relógio, estoque e condições do ambiente
+}
+
+static void iniciar_pedido(Evento evento) {
+  play_apertado = false; // o PLAY que iniciou o pedido não conta para a verificação de recursos
+}
+
+static void mostrar_latencia(Evento evento) {
+  latencia_solicitar_tela(); // tela de diagnóstico de latência
+}
+
+static void definir_xicaras(Evento evento) {
+  xicaras = evento - EVENTO_TECLA_0; // Converte a tecla para número de xícaras desejadas
+}
+
+static void tecla_invalida(Evento evento) {
+  lcd_clear();
+  lcd_set_cursor(0, 0);
+  lcd_print("INVALID KEY"); // caso o usuário aperte uma tecla diferente
+  lcd_set_cursor(2, 0);
+  lcd_print("PLEASE SELECT 1 TO 5");
+  sleep_ms(1000);
+  perguntar_quantidade_xicaras();
+}
+
+static void escolher_agora(Evento evento) {
+  preparo_agora = true;
+}
+
+static void escolher_agendamento(Evento evento) {
+  preparo_agora = false;
+}
+
+// O preparo e o agendamento leem as teclas diretamente enquanto bloqueiam; as teclas enfileiradas nesse
+// intervalo já foram consumidas e são descartadas antes do evento de conclusão
+static void executar_preparo(Evento evento) {
+  frequencia_rotina_longa();
+  preparar_cafe(xicaras);
+  estado_descartar_teclas();
+  estado_postar_evento(EVENTO_PREPARO_CONCLUIDO);
+}
+
+static void executar_agendamento(Evento evento) {
+  frequencia_rotina_longa();
+  horario_configurado = configurar_horario(I2C_PORT, SDA_PIN, SCL_PIN, tecla);
+  estado_descartar_teclas();
+  estado_postar_evento(horario_configurado.horario_valido ? EVENTO_AGENDAMENTO_VALIDO : EVENTO_AGENDAMENTO_CANCELADO);
+}
+
+// -------------------------------------------------------------------------------------------------- //
+// Ações de entrada e saída
+
+static void entrar_tela_inicial(void) {
+  exibir_tela_inicial();
+}
+
+// -------------------------------------------------------------------------------------------------- //
+// Tabelas
+
+typedef struct {
+  bool (*guarda)(Evento evento);  // NULL: sempre permitida
+  void (*acao)(Evento evento);    // executada entre a saída do estado atual e a entrada do próximo
+  Estado proximo;
+  bool muda_estado;               // false: transição interna (só a ação, sem saída/entrada)
+} Transicao;
+
+typedef struct {
+  void (*ao_entrar)(void);
+  void (*ao_sair)(void);
+} DescricaoEstado;
+
+#define PARA(destino, acao_) {NULL, acao_, destino, true}
+#define INTERNA(acao_) {NULL, acao_, 0, false}
+
+static const DescricaoEstado estados[TOTAL_ESTADOS] = {
+  [ESTADO_TELA_INICIAL]       = {entrar_tela_inicial, NULL},
+  [ESTADO_QUANTIDADE_XICARAS] = {perguntar_quantidade_xicaras, NULL},
+  [ESTADO_QUANDO_PREPARAR]    = {perguntar_quando_preparar, NULL},
+  [ESTADO_PREPARANDO]         = {NULL, NULL},
+  [ESTADO_PROGRAMANDO]        = {NULL, NULL},
+  [ESTADO_AGUARDANDO]         = {NULL, NULL},             // mantém a confirmação do agendamento
+};
+
+// Entradas ausentes (zeradas) ignoram o evento
+static const Transicao transicoes[TOTAL_ESTADOS][TOTAL_EVENTOS] = {
+  [ESTADO_TELA_INICIAL] = {
+    [EVENTO_TIQUE] = INTERNA(atualizar_monitoramento),
+    [EVENTO_PLAY]  = PARA(ESTADO_QUANTIDADE_XICARAS, iniciar_pedido),
+    [EVENTO_MENU]  = INTERNA(mostrar_latencia),
+  },
+  [ESTADO_QUANTIDADE_XICARAS] = {
+    [EVENTO_TECLA_0]     = PARA(ESTADO_TELA_INICIAL, NULL), // 0 retorna ao início
+    [EVENTO_TECLA_1]     = PARA(ESTADO_QUANDO_PREPARAR, definir_xicaras),
+    [EVENTO_TECLA_2]     = PARA(ESTADO_QUANDO_PREPARAR, definir_xicaras),
+    [EVENTO_TECLA_3]     = PARA(ESTADO_QUANDO_PREPARAR, definir_xicaras),
+    [EVENTO_TECLA_4]     = PARA(ESTADO_QUANDO_PREPARAR, definir_xicaras),
+    [EVENTO_TECLA_5]     = PARA(ESTADO_QUANDO_PREPARAR, definir_xicaras),
+    [EVENTO_TECLA_6]     = INTERNA(tecla_invalida),
+    [EVENTO_TECLA_7]     = INTERNA(tecla_invalida),
+    [EVENTO_TECLA_8]     = INTERNA(tecla_invalida),
+    [EVENTO_TECLA_9]     = INTERNA(tecla_invalida),
+    [EVENTO_MENU]        = INTERNA(tecla_invalida),
+    [EVENTO_OUTRA_TECLA] = INTERNA(tecla_invalida),
+  },
+  [ESTADO_QUANDO_PREPARAR] = { // escolha do usuário de preparar logo ou agendar
+    [EVENTO_TECLA_1] = PARA(ESTADO_PREPARANDO, escolher_agora),
+    [EVENTO_TECLA_2] = PARA(ESTADO_PROGRAMANDO, escolher_agendamento),
+  },
+  [ESTADO_PREPARANDO] = {
+    [EVENTO_TIQUE]             = INTERNA(executar_preparo),
+    [EVENTO_PREPARO_CONCLUIDO] = PARA(ESTADO_TELA_INICIAL, NULL),
+  },
+  [ESTADO_PROGRAMANDO] = { // estado para agendar o preparo do café
+    [EVENTO_TIQUE]                 = INTERNA(executar_agendamento),
+    [EVENTO_AGENDAMENTO_VALIDO]    = PARA(ESTADO_AGUARDANDO, NULL),
+    [EVENTO_AGENDAMENTO_CANCELADO] = PARA(ESTADO_TELA_INICIAL, NULL),
+  },
+  [ESTADO_AGUARDANDO] = { // compara o tempo atual com o agendado para iniciar o preparo
+    [EVENTO_TIQUE] = {horario_atingido, NULL, ESTADO_PREPARANDO, true},
+  },
+};
+
+// -------------------------------------------------------------------------------------------------- //
+// Fila de eventos
+
+bool estado_postar_evento(Evento evento) {
+  uint32_t irq = save_and_disable_interrupts();
+  bool cabe = fila_cabeca - fila_cauda < TAMANHO_FILA;
+  if (cabe) fila[fila_cabeca++ & (TAMANHO_FILA - 1)] = evento;
+  ultimo_evento_us = time_us_64();
+  restore_interrupts(irq);
+  __sev(); // acorda estado_aguardar_evento
+  return cabe;
+}
+
+static bool retirar_evento(Evento *evento) {
+  uint32_t irq = save_and_disable_interrupts();
+  bool tem = fila_cabeca != fila_cauda;
+  if (tem) *evento = fila[fila_cauda++ & (TAMANHO_FILA - 1)];
+  restore_interrupts(irq);
+  return tem;
+}
+
+void estado_descartar_teclas(void) {
+  uint32_t irq = save_and_disable_interrupts();
+  fila_cauda = fila_cabeca;
+  restore_interrupts(irq);
+}
+
+bool estado_evento_pendente(void) {
+  return fila_cabeca != fila_cauda || redesenho_pendente;
+}
+
+uint64_t estado_ultimo_evento_us(void) {
+  uint32_t irq = save_and_disable_interrupts(); // 64 bits: duas leituras no M0+
+  uint64_t instante = ultimo_evento_us;
+  restore_interrupts(irq);
+  return instante;
+}
+
+void estado_aguardar_evento(uint32_t tempo_limite_ms) {
+  absolute_time_t limite = make_timeout_time_ms(tempo_limite_ms);
+  while (!estado_evento_pendente()) {
+    if (best_effort_wfe_or_timeout(limite)) break;
+  }
+}
+
+// -------------------------------------------------------------------------------------------------- //
+// Motor
+
+// Saída, ação, troca de estado e entrada; a troca é registrada no gravador, no rastreamento e na
+// medição de latência, e a duração da transição completa vai para o rastreamento
+static void executar_transicao(const Transicao *t, Evento evento) {
+  uint32_t inicio = time_us_32();
+  Estado anterior = estado_atual;
+
+  if (estados[anterior].ao_sair) estados[anterior].ao_sair();
+  if (t->acao) t->acao(evento);
+  estado_atual = t->proximo;
+
+  gravador_estado(anterior, estado_atual);
+  rastreio_evento(RASTREIO_ESTADO, anterior, estado_atual);
+  latencia_marco(MARCO_REACAO);
+
+  if (estados[estado_atual].ao_entrar) estados[estado_atual].ao_entrar();
+  rastreio_evento(RASTREIO_TRANSICAO, evento, time_us_32() - inicio);
+}
+
+static void despachar(Evento evento) {
+  const Transicao *t = &transicoes[estado_atual][evento];
+  if (t->guarda && !t->guarda(evento)) return;
+  if (t->muda_estado) {
+    executar_transicao(t, evento);
+  } else if (t->acao) {
+    t->acao(evento);
+  }
+}
+
+void estado_iniciar(Estado inicial) {
+  estado_descartar_teclas();
+  redesenho_pendente = false;
+  estado_atual = inicial;
+  if (estados[estado_atual].ao_entrar) estados[estado_atual].ao_entrar();
+}
+
+void estado_redesenhar(void) {
+  redesenho_pendente = true;
+}
+
+Estado estado_corrente(void) {
+  return estado_atual;
+}
+
+// Um passo do loop principal: eventos pendentes em ordem de chegada e depois o tique do estado atual
 void gerenciar_estado() {
-  switch (estado_atual)
-  {
-    case ESTADO_TELA_INICIAL:
-      if (!saudacao_exibida) {
-        exibir_tela_inicial();
-        saudacao_exibida = true;
-        ultimo_estado_exibido = ESTADO_TELA_INICIAL;  // Garante que este estado foi exibido
-      } else {
-
-        exibir_relogio();                             // Atualiza o relógio continuamente
-        exibir_temperatura_umidade_ambiente();        // Atualiza condições do ambiente
-      }
-
-      if (play_apertado) {
-        estado_atual = ESTADO_QUANTIDADE_XICARAS;
-        play_apertado = false; // Reseta a flag
-        ultimo_estado_exibido = ESTADO_TELA_INICIAL; // Força a atualização no próximo estado
-      }
-      break;
-
-    case ESTADO_QUANTIDADE_XICARAS:
-      if (ultimo_estado_exibido != ESTADO_QUANTIDADE_XICARAS) {
-        lcd_clear();
-        lcd_set_cursor(0, 0);
-        lcd_print("HOW MANY CUPS?");
-        lcd_set_cursor(2, 0);
-        lcd_print("- FROM 1 TO 5");
-        lcd_set_cursor(3, 0);
-        lcd_print("- 0 TO EXIT");
-        ultimo_estado_exibido = ESTADO_QUANTIDADE_XICARAS; // Atualiza o estado exibido
-      }
-      break;
-
-    case ESTADO_QUANDO_PREPARAR:
-      if (ultimo_estado_exibido != ESTADO_QUANDO_PREPARAR) {
-        lcd_clear();
-        lcd_set_cursor(0, 0);
-        lcd_print("START TIME:");
-        lcd_set_cursor(2, 0);
-        lcd_print("1-NOW");
-        lcd_set_cursor(3, 0);
-        lcd_print("2-SCHEDULE");
-        ultimo_estado_exibido = ESTADO_QUANDO_PREPARAR; // Atualiza o estado exibido
-      }
-      break;
-
-    case ESTADO_PREPARANDO:
-      preparar_cafe(xicaras);
-      break;
-
-    case ESTADO_PROGRAMANDO: // estado para agendar o preparo do café
-      horario_configurado = configurar_horario(I2C_PORT, SDA_PIN, SCL_PIN, tecla);
-      if (horario_configurado.horario_valido) {
-        estado_atual = ESTADO_AGUARDANDO;
-      } else {
-        estado_atual = ESTADO_TELA_INICIAL;
-      }
-      break;
-
-    case ESTADO_AGUARDANDO: { // estado que compara o tempo atual com o tempo agendado para iniciar o preparo
-        uint8_t rtc_data[7];
-        rtc_read(I2C_PORT, SDA_PIN, SCL_PIN, rtc_data); // lê o tempo atual
-
-        uint8_t current_day = (rtc_data[4] & 0x0F) + ((rtc_data[4] >> 4) * 10);
-        uint8_t current_month = (rtc_data[5] & 0x0F) + ((rtc_data[5] >> 4) * 10);
-        uint8_t current_hour = (rtc_data[2] & 0x0F) + ((rtc_data[2] >> 4) * 10);
-        uint8_t current_minute = (rtc_data[1] & 0x0F) + ((rtc_data[1] >> 4) * 10);
-
-        //se for igual, vai para o preparo do café
-        if (current_day == horario_configurado.dia &&
-            current_month == horario_configurado.mes &&
-            current_hour == horario_configurado.hora &&
-            current_minute == horario_configurado.minutos) {
-          estado_atual = ESTADO_PREPARANDO;
-        }
-        break;
-      }
-
-    default:
-      estado_atual = ESTADO_TELA_INICIAL;
-      break;
+  Estado estado = estado_atual; // o orçamento de tempo é o do estado em que o passo começou
+  monitor_entrar((TrechoMonitor)estado);
+
+  if (redesenho_pendente) {
+    redesenho_pendente = false;
+    if (estados[estado_atual].ao_entrar) estados[estado_atual].ao_entrar();
+  }
+
+  Evento evento;
+  while (retirar_evento(&evento)) {
+    despachar(evento);
   }
+  despachar(EVENTO_TIQUE);
+
+  monitor_sair((TrechoMonitor)estado);
 }
@@ -1,4 +1,8 @@
 // estado.h
+// Máquina de estados da cafeteira, dirigida por uma tabela de transições [estado][evento].
+// Cada entrada tem guarda, ação e próximo estado; cada estado tem ações de entrada e saída.
+// Os eventos chegam por uma fila segura em IRQ (teclas do controle) ou são gerados pelas próprias
+// ações; somente o motor em estado.c altera o estado atual.
 #ifndef ESTADO_H
 #define ESTADO_H
 
@@ -12,10 +16,40 @@ typedef enum {
   ESTADO_QUANDO_PREPARAR,      // usuário define horário de preparo imediato ou agendado
   ESTADO_PREPARANDO,           // sistema inicia a rotina de preparo verificando recursos e seguindo para extração do café
   ESTADO_PROGRAMANDO,          // usuário define horário agendado para ínicio do preparo
-  ESTADO_AGUARDANDO            // sistema aguarda o horário atual coincidir com o horário agendado de preparo
+  ESTADO_AGUARDANDO,           // sistema aguarda o horário atual coincidir com o horário agendado de preparo
+  TOTAL_ESTADOS
 } Estado;
 
-// Função para gerenciar os estados
-void gerenciar_estado(void);
+// Eventos da máquina de café
+typedef enum {
+  EVENTO_TIQUE,                 // passo periódico do loop principal (atualizações e rotinas longas)
+  EVENTO_PLAY,
+  EVENTO_MENU,
+  EVENTO_TECLA_0,               // teclas numéricas: EVENTO_TECLA_0 + dígito
+  EVENTO_TECLA_1,
+  EVENTO_TECLA_2,
+  EVENTO_TECLA_3,
+  EVENTO_TECLA_4,
+  EVENTO_TECLA_5,
+  EVENTO_TECLA_6,
+  EVENTO_TECLA_7,
+  EVENTO_TECLA_8,
+  EVENTO_TECLA_9,
+  EVENTO_OUTRA_TECLA,           // demais teclas do controle (exceto TEST, reservada ao diagnóstico)
+  EVENTO_PREPARO_CONCLUIDO,
+  EVENTO_AGENDAMENTO_VALIDO,
+  EVENTO_AGENDAMENTO_CANCELADO,
+  TOTAL_EVENTOS
+} Evento;
+
+void estado_iniciar(Estado inicial);       // define o estado inicial e executa sua ação de entrada
+void gerenciar_estado(void);               // despacha os eventos pendentes e o tique do estado atual
+bool estado_postar_evento(Evento evento);  // enfileira um evento (seguro em IRQ); false com a fila cheia
+void estado_descartar_teclas(void);        // descarta teclas já consumidas por uma rotina bloqueante
+void estado_redesenhar(void);              // repete a ação de entrada do estado atual no próximo passo
+void estado_aguardar_evento(uint32_t tempo_limite_ms); // dorme até chegar um evento ou o tempo acabar
+bool estado_evento_pendente(void);         // evento na fila ou redesenho pedido
+uint64_t estado_ultimo_evento_us(void);    // instante do último evento postado (0: nenhum)
+Estado estado_corrente(void);
 
 #endif // ESTADO_H
\ No newline at end of file
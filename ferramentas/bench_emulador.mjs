@@ -0,0 +1,157 @@
+#!/usr/bin/env node
+// bench_emulador.mjs
+// Executa o firmware de benchmark (benchmark/bench_emulador.c) no emulador RP2040 de código aberto
+// rp2040js e grava um relatório JSON com os ciclos por operação de cada caso.
+//
+// Uso:
+//   npm install rp2040js
+//   node bench_emulador.mjs --bootrom b1.bin --uf2 coffeetime_bench_emulador.uf2 \
+//        [--saida relatorio.json] [--referencia anterior.json] [--tolerancia 5]
+//
+// O bootrom B1 oficial está em https://github.com/raspberrypi/pico-bootrom.
+// Com --referencia, o script compara com um relatório anterior e termina com código 1 se algum caso
+// ficou mais lento que a tolerância (em %), para uso em integração contínua.
+//
+// Limitações: o rp2040js conta ciclos por instrução do Cortex-M0+ (incluindo o custo das rotinas de
+// ponto flutuante em software), mas não modela falhas do cache XIP nem esperas do barramento. Esses
+// efeitos só aparecem em medições na placa real.
+
+import { readFileSync, writeFileSync } from 'node:fs';
+import { RP2040 } from 'rp2040js';
+
+// Mesma descrição da placa que o firmware (placa/placa.h)
+function lerPlaca() {
+  const texto = readFileSync(new URL('../placa/placa.h', import.meta.url), 'utf8');
+  const valores = {};
+  for (const [, nome, valor] of texto.matchAll(/^#define\s+(\w+)\s+(0x[0-9A-Fa-f]+|\d+)\b/gm)) {
+    valores[nome] = Number(valor);
+  }
+  return valores;
+}
+
+const PLACA = lerPlaca();
+const FLASH_INICIO = 0x10000000;
+const RTC_ADDR = PLACA.RTC_ADDR;
+const LIMITE_CICLOS = 5_000_000_000; // evita laço infinito se o firmware não chegar ao fim
+
+function argumentos(argv) {
+  const opcoes = { saida: 'relatorio_bench_emulador.json', tolerancia: 5 };
+  for (let i = 0; i < argv.length; i += 2) {
+    opcoes[argv[i].replace(/^--/, '')] = argv[i + 1];
+  }
+  if (!opcoes.bootrom || !opcoes.uf2) {
+    console.error('uso: bench_emulador.mjs --bootrom b1.bin --uf2 firmware.uf2 [--saida x.json] [--referencia y.json]');
+    process.exit(2);
+  }
+  return opcoes;
+}
+
+// Copia os blocos de um arquivo UF2 para a flash emulada
+function carregarUf2(mcu, caminho) {
+  const dados = readFileSync(caminho);
+  for (let pos = 0; pos + 512 <= dados.length; pos += 512) {
+    const endereco = dados.readUInt32LE(pos + 12);
+    const tamanho = dados.readUInt32LE(pos + 16);
+    mcu.flash.set(dados.subarray(pos + 32, pos + 32 + tamanho), endereco - FLASH_INICIO);
+  }
+}
+
+function lerTexto(mcu, endereco) {
+  let texto = '';
+  for (let c = mcu.readUint8(endereco); c !== 0 && texto.length < 64; c = mcu.readUint8(++endereco)) {
+    texto += String.fromCharCode(c);
+  }
+  return texto;
+}
+
+// Periféricos simulados: o barramento I2C confirma todos os bytes (LCD) e o DS1307 devolve um horário fixo
+function simularI2c(mcu) {
+  const rtc = [0x30, 0x45, 0x14, 0x02, 0x19, 0x10, 0x26];
+  let indiceRtc = 0;
+  const i2c = mcu.i2c[0];
+  i2c.onStart = () => i2c.completeStart();
+  i2c.onConnect = (endereco) => {
+    if (endereco === RTC_ADDR) indiceRtc = 0;
+    i2c.completeConnect(true);
+  };
+  i2c.onWriteByte = () => i2c.completeWrite(true);
+  i2c.onReadByte = () => i2c.completeRead(rtc[indiceRtc++ % rtc.length]);
+  i2c.onStop = () => i2c.completeStop();
+}
+
+function executar(opcoes) {
+  const mcu = new RP2040();
+  mcu.loadBootrom(new Uint32Array(readFileSync(opcoes.bootrom).buffer.slice(0)));
+  carregarUf2(mcu, opcoes.uf2);
+  simularI2c(mcu);
+
+  const casos = [];
+  let atual = null;
+  let terminou = false;
+
+  mcu.core.onBreak = (codigo) => {
+    mcu.core.breakRewind = 0; // segue para a instrução seguinte ao BKPT
+    const ciclos = mcu.core.cycles;
+    if (codigo === 1) {
+      atual = {
+        nome: lerTexto(mcu, mcu.core.registers[2]),
+        iteracoes: mcu.core.registers[1],
+        inicio: ciclos,
+      };
+    } else if (codigo === 2 && atual) {
+      const total = ciclos - atual.inicio;
+      casos.push({
+        nome: atual.nome,
+        iteracoes: atual.iteracoes,
+        ciclos_total: total,
+        ciclos_por_op: Math.round((total / atual.iteracoes) * 10) / 10,
+      });
+      atual = null;
+    } else if (codigo === 3) {
+      terminou = true;
+    }
+  };
+
+  mcu.reset();
+  while (!terminou && mcu.core.cycles < LIMITE_CICLOS) {
+    mcu.step();
+  }
+  if (!terminou) {
+    console.error('o firmware de benchmark não terminou dentro do limite de ciclos');
+    process.exit(2);
+  }
+  return casos;
+}
+
+function comparar(casos, referencia, tolerancia) {
+  const anteriores = new Map(referencia.casos.map((c) => [c.nome, c]));
+  let regressoes = 0;
+  for (const caso of casos) {
+    const anterior = anteriores.get(caso.nome);
+    if (!anterior) continue;
+    const variacao = ((caso.ciclos_por_op - anterior.ciclos_por_op) / anterior.ciclos_por_op) * 100;
+    const marca = variacao > tolerancia ? 'REGRESSÃO' : '';
+    if (marca) regressoes++;
+    console.log(`${caso.nome.padEnd(22)} ${String(anterior.ciclos_por_op).padStart(10)} -> ` +
+                `${String(caso.ciclos_por_op).padStart(10)} ciclos/op (${variacao.toFixed(1)}%) ${marca}`);
+  }
+  return regressoes;
+}
+
+const opcoes = argumentos(process.argv.slice(2));
+const casos = executar(opcoes);
+const relatorio = {
+  firmware: opcoes.uf2,
+  emulador: 'rp2040js',
+  clk_sys_hz: 125_000_000,
+  casos,
+};
+writeFileSync(opcoes.saida, JSON.stringify(relatorio, null, 2) + '\n');
+for (const caso of casos) {
+  console.log(`${caso.nome.padEnd(22)} ${String(caso.ciclos_por_op).padStart(10)} ciclos/op`);
+}
+
+if (opcoes.referencia) {
+  const referencia = JSON.parse(readFileSync(opcoes.referencia, 'utf8'));
+  process.exit(comparar(casos, referencia, Number(opcoes.tolerancia)) > 0 ? 1 : 0);
+}
@@ -0,0 +1,121 @@
+#!/usr/bin/env python3
+# carga_http.py
+# Teste de carga do servidor de status (rede/servidor_status.c na placa ou rede/status_host.c no host)
+#
+# Uso:
+#   carga_http.py <host:porta> [--conexoes N] [--duracao S] [--caminho /status]
+#
+# Cada conexão simultânea repete pedido -> resposta completa -> fechamento (o servidor responde com
+# Connection: close) e mede a latência do connect até o último byte. Toda resposta é validada: status
+# 200, Content-Length igual ao corpo, JSON válido e sequência da foto nunca voltando para trás.
+# Imprime pedidos/s, percentis da latência e uma linha "CARGA;..." para comparar execuções.
+
+import argparse
+import json
+import socket
+import statistics
+import sys
+import threading
+import time
+
+# Formas do pedido conferidas antes da carga: com CRLF e só com LF (RFC 9112, seção 2.2), que o servidor
+# também aceita. A carga usa a primeira
+PEDIDOS = [
+    ("CRLF", "GET {caminho} HTTP/1.1\r\nHost: {host}\r\n\r\n"),
+    ("LF", "GET {caminho} HTTP/1.0\n\n"),
+]
+
+
+def pedir(host, porta, caminho, pedido=PEDIDOS[0][1]):
+    """Faz um pedido e devolve (latência em s, código, corpo)."""
+    inicio = time.perf_counter()
+    with socket.create_connection((host, porta), timeout=5) as s:
+        s.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+        s.sendall(pedido.format(caminho=caminho, host=host).encode())
+        partes = []
+        while True:
+            dados = s.recv(4096)
+            if not dados:
+                break
+            partes.append(dados)
+    latencia = time.perf_counter() - inicio
+
+    resposta = b"".join(partes)
+    cabecalho, _, corpo = resposta.partition(b"\r\n\r\n")
+    linhas = cabecalho.decode("latin-1").split("\r\n")
+    codigo = int(linhas[0].split()[1])
+    campos = {k.strip().lower(): v.strip() for k, _, v in (l.partition(":") for l in linhas[1:])}
+    if int(campos.get("content-length", -1)) != len(corpo):
+        raise ValueError(f"Content-Length {campos.get('content-length')} != corpo {len(corpo)}")
+    return latencia, codigo, corpo
+
+
+def trabalhador(host, porta, caminho, fim, latencias, erros, trava):
+    locais, falhas, ultima_sequencia = [], [], -1
+    while time.perf_counter() < fim:
+        try:
+            latencia, codigo, corpo = pedir(host, porta, caminho)
+            if codigo != 200:
+                raise ValueError(f"status {codigo}")
+            sequencia = json.loads(corpo)["sequencia"]
+            if sequencia < ultima_sequencia:
+                raise ValueError(f"sequencia voltou de {ultima_sequencia} para {sequencia}")
+            ultima_sequencia = sequencia
+            locais.append(latencia)
+        except (OSError, ValueError, KeyError, IndexError) as erro:
+            falhas.append(str(erro))
+    with trava:
+        latencias.extend(locais)
+        erros.extend(falhas)
+
+
+def percentil(ordenados, p):
+    return ordenados[min(len(ordenados) - 1, int(len(ordenados) * p / 100))]
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Teste de carga do servidor de status")
+    parser.add_argument("destino", help="host:porta (ex.: 127.0.0.1:8080 ou o IP da placa:80)")
+    parser.add_argument("--conexoes", type=int, default=4, help="conexões simultâneas (padrão: 4)")
+    parser.add_argument("--duracao", type=float, default=10, help="segundos de carga (padrão: 10)")
+    parser.add_argument("--caminho", default="/status")
+    args = parser.parse_args()
+    host, _, porta = args.destino.rpartition(":")
+
+    # Um pedido de cada forma antes da carga: servidor no ar e resposta bem formada
+    for nome, pedido in PEDIDOS:
+        try:
+            _, codigo, corpo = pedir(host, int(porta), args.caminho, pedido)
+            if codigo != 200:
+                raise ValueError(f"status {codigo}")
+        except (OSError, ValueError) as erro:
+            sys.exit(f"{args.destino} (pedido {nome}): {erro}")
+        print(f"{nome}: status {codigo}, {len(corpo)} bytes: {corpo.decode(errors='replace').strip()}")
+
+    latencias, erros, trava = [], [], threading.Lock()
+    fim = time.perf_counter() + args.duracao
+    threads = [threading.Thread(target=trabalhador, args=(host, int(porta), args.caminho, fim, latencias, erros, trava))
+               for _ in range(args.conexoes)]
+    inicio = time.perf_counter()
+    for t in threads:
+        t.start()
+    for t in threads:
+        t.join()
+    decorrido = time.perf_counter() - inicio
+
+    if not latencias:
+        sys.exit(f"nenhuma resposta válida ({len(erros)} erros; primeiro: {erros[0] if erros else '-'})")
+    ordenadas = sorted(latencias)
+    ms = [percentil(ordenadas, p) * 1000 for p in (50, 90, 99)] + [ordenadas[-1] * 1000]
+    taxa = len(latencias) / decorrido
+    print(f"{len(latencias)} pedidos em {decorrido:.1f} s com {args.conexoes} conexões: {taxa:.0f} pedidos/s")
+    print(f"latência ms: média {statistics.mean(ordenadas) * 1000:.2f}  p50 {ms[0]:.2f}  p90 {ms[1]:.2f}  "
+          f"p99 {ms[2]:.2f}  max {ms[3]:.2f}")
+    if erros:
+        print(f"{len(erros)} erros; primeiro: {erros[0]}")
+    print(f"CARGA;{taxa:.0f};{ms[0]:.3f};{ms[1]:.3f};{ms[2]:.3f};{ms[3]:.3f};{len(erros)}")
+    sys.exit(1 if erros else 0)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,93 @@
+#!/usr/bin/env python3
+# codigo_na_ram.py
+# Relatório das funções colocadas na SRAM (placa/na_ram.h), a partir do mapa do ligador
+#
+# Uso: codigo_na_ram.py <firmware.elf.map> [--fontes <pasta do projeto>]
+# Lista cada seção .time_critical.<função> com o módulo, o endereço na RAM e o tamanho (o SDK também
+# coloca algumas funções próprias ali). As funções marcadas com NA_RAM(...) nos fontes que não aparecem
+# no mapa foram incorporadas (inline) em quem as chama ou o firmware foi compilado com
+# -DCODIGO_NA_RAM=0; o relatório as aponta à parte.
+
+import argparse
+import os
+import re
+import sys
+
+from uso_memoria import ENTRADA, RAM, SECAO, dentro, modulo
+
+MARCA = re.compile(r"\bNA_RAM\((\w+)\)")
+PREFIXO = ".time_critical."
+
+
+def ler_secoes(caminho):
+    funcoes = []
+    em_mapa = False
+    secao = None
+    with open(caminho, encoding="utf-8", errors="replace") as f:
+        for linha in f:
+            if linha.startswith("Linker script and memory map"):
+                em_mapa = True
+                continue
+            if not em_mapa:
+                continue
+            linha = linha.rstrip("\n")
+            so_secao = SECAO.match(linha)
+            if so_secao:
+                secao = so_secao.group(1)
+                continue
+            entrada = ENTRADA.match(linha)
+            if not entrada or "*fill*" in linha:
+                secao = None
+                continue
+            nome = entrada.group(1) or secao
+            secao = None
+            endereco, tamanho = int(entrada.group(2), 16), int(entrada.group(3), 16)
+            if not nome or not nome.startswith(PREFIXO) or tamanho == 0 or not dentro(RAM, endereco):
+                continue
+            funcoes.append((nome[len(PREFIXO):], modulo(entrada.group(4)), endereco, tamanho))
+    return funcoes
+
+
+def marcadas_nos_fontes(raiz):
+    marcadas = {}
+    for pasta, subpastas, arquivos in os.walk(raiz):
+        subpastas[:] = [s for s in subpastas if not s.startswith((".", "_"))]
+        for arquivo in arquivos:
+            if not arquivo.endswith(".c"):
+                continue
+            caminho = os.path.join(pasta, arquivo)
+            with open(caminho, encoding="utf-8", errors="replace") as f:
+                for nome in MARCA.findall(f.read()):
+                    marcadas[nome] = os.path.relpath(caminho, raiz)
+    return marcadas
+
+
+def main():
+    args = argparse.ArgumentParser()
+    args.add_argument("mapa")
+    args.add_argument("--fontes", default=os.path.join(os.path.dirname(os.path.abspath(__file__)), ".."))
+    opcoes = args.parse_args()
+
+    funcoes = ler_secoes(opcoes.mapa)
+    marcadas = marcadas_nos_fontes(opcoes.fontes)
+    if not funcoes and not marcadas:
+        sys.exit(f"{opcoes.mapa}: nenhuma função na RAM")
+
+    print(f"{'funcao':<28} {'modulo':<20} {'endereco':>10} {'bytes':>6}")
+    total = 0
+    for nome, dono, endereco, tamanho in sorted(funcoes, key=lambda f: (f[0] not in marcadas, f[1], f[0])):
+        origem = "" if nome in marcadas else "  (SDK)"
+        print(f"{nome:<28} {dono:<20} {endereco:#010x} {tamanho:6d}{origem}")
+        total += tamanho
+    print(f"{'TOTAL':<28} {'':<20} {'':>10} {total:6d}")
+
+    no_mapa = {f[0] for f in funcoes}
+    ausentes = sorted(n for n in marcadas if n not in no_mapa)
+    if ausentes:
+        print("\nmarcadas com NA_RAM sem seção própria no mapa (inline no chamador ou CODIGO_NA_RAM=0):")
+        for nome in ausentes:
+            print(f"  {nome:<26} {marcadas[nome]}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,36 @@
+#!/usr/bin/env python3
+# comparar_bench.py
+# Compara as medianas de duas execuções do firmware benchmark/bench_placa.c
+#
+# Uso: comparar_bench.py <log_antes> <log_depois>
+# Cada log é a saída serial contendo as linhas "BENCH;nome;n;min;mediana;max;mediana_us";
+# se houver várias rodadas no log, vale a última.
+
+import sys
+
+
+def ler(caminho):
+    casos = {}
+    with open(caminho, encoding="utf-8", errors="replace") as f:
+        for linha in f:
+            partes = linha.strip().split(";")
+            if len(partes) == 7 and partes[0] == "BENCH":
+                casos[partes[1]] = (int(partes[3]), int(partes[4]), int(partes[5]), float(partes[6]))
+    return casos
+
+
+def main(args):
+    if len(args) != 2:
+        sys.exit("uso: comparar_bench.py <log_antes> <log_depois>")
+    antes, depois = ler(args[0]), ler(args[1])
+    print(f"{'caso':22} {'antes':>10} {'depois':>10} {'variação':>9}   (mediana em ciclos)")
+    for nome, (_, mediana_antes, _, _) in antes.items():
+        if nome not in depois:
+            continue
+        mediana_depois = depois[nome][1]
+        variacao = (mediana_depois - mediana_antes) * 100 / mediana_antes if mediana_antes else 0
+        print(f"{nome:22} {mediana_antes:10d} {mediana_depois:10d} {variacao:8.1f}%")
+
+
+if __name__ == "__main__":
+    main(sys.argv[1:])
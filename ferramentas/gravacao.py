@@ -0,0 +1,135 @@
+#!/usr/bin/env python3
+# gravacao.py
+# Ferramenta de host para as gravações do módulo diagnostico/gravador.c
+#
+# Uso:
+#   gravacao.py decodificar <log_serial>           lista os registros da gravação
+#   gravacao.py metricas <log_serial>              latência tecla->tela e duração dos preparos
+#   gravacao.py comparar <log_a> <log_b>           compara duas sessões (ex.: duas versões do firmware)
+#   gravacao.py gerar-c <log_serial> <saida.c>     gera gravacao_reproducao.c para reproduzir no dispositivo
+#
+# O log serial é a saída da USB contendo as linhas "GRAV ..." enviadas ao apertar TEST no controle.
+
+import statistics
+import sys
+
+GRAV_TEMPO, GRAV_IR, GRAV_ADC, GRAV_DHT, GRAV_RTC, GRAV_ESTADO, GRAV_TELA = range(1, 8)
+CARGA = {GRAV_TEMPO: 4, GRAV_IR: 3, GRAV_ADC: 3, GRAV_DHT: 4, GRAV_RTC: 7, GRAV_ESTADO: 2, GRAV_TELA: 0}
+ESTADOS = ["TELA_INICIAL", "QUANTIDADE_XICARAS", "QUANDO_PREPARAR", "PREPARANDO", "PROGRAMANDO", "AGUARDANDO"]
+ESTADO_PREPARANDO = 3
+
+
+def ler_log(caminho):
+    """Extrai o último bloco GRAV INICIO ... GRAV FIM do log serial."""
+    dados, bloco = None, None
+    with open(caminho, encoding="utf-8", errors="replace") as f:
+        for linha in f:
+            linha = linha.strip()
+            if linha.startswith("GRAV INICIO"):
+                bloco = bytearray()
+            elif linha == "GRAV FIM" and bloco is not None:
+                dados, bloco = bytes(bloco), None
+            elif linha.startswith("GRAV ") and bloco is not None:
+                bloco += bytes.fromhex(linha[5:])
+    if dados is None or dados[:3] != b"CTG":
+        sys.exit(f"{caminho}: nenhuma gravação válida encontrada")
+    return dados
+
+
+def registros(dados):
+    """Gera (instante_ms, tipo, carga) para cada registro."""
+    pos, t = 4, 0
+    while pos + 3 <= len(dados):
+        tipo = dados[pos]
+        n = CARGA.get(tipo)
+        if n is None or pos + 3 + n > len(dados):
+            break
+        carga = dados[pos + 3:pos + 3 + n]
+        if tipo == GRAV_TEMPO:
+            t = int.from_bytes(carga, "little")
+        else:
+            t += dados[pos + 1] | (dados[pos + 2] << 8)
+        yield t, tipo, carga
+        pos += 3 + n
+
+
+def descrever(tipo, c):
+    if tipo == GRAV_TEMPO:
+        return "TEMPO"
+    if tipo == GRAV_IR:
+        return f"IR adr=0x{c[0]:02x} cmd=0x{c[1]:02x} {'REPEAT' if c[2] == 2 else 'NORMAL'}"
+    if tipo == GRAV_ADC:
+        return f"ADC{c[0]} {c[1] | (c[2] << 8)}"
+    if tipo == GRAV_DHT:
+        u = int.from_bytes(c[0:2], "little", signed=True) / 10
+        t = int.from_bytes(c[2:4], "little", signed=True) / 10
+        return f"DHT {t:.1f}C {u:.1f}%"
+    if tipo == GRAV_RTC:
+        bcd = [(b & 0x0F) + (b >> 4) * 10 for b in c]
+        return f"RTC {bcd[4]:02d}/{bcd[5]:02d}/{bcd[6]:02d} {bcd[2]:02d}:{bcd[1]:02d}:{bcd[0] & 0x7F:02d}"
+    if tipo == GRAV_ESTADO:
+        return f"ESTADO {ESTADOS[c[0]] if c[0] < len(ESTADOS) else c[0]} -> {ESTADOS[c[1]] if c[1] < len(ESTADOS) else c[1]}"
+    return "TELA"
+
+
+def metricas(dados):
+    """Latência de cada tecla até a próxima reação visível e duração de cada preparo."""
+    latencias, preparos = [], []
+    tecla_pendente, inicio_preparo = None, None
+    for t, tipo, c in registros(dados):
+        if tipo == GRAV_IR and c[2] != 2:
+            tecla_pendente = t
+        elif tipo in (GRAV_TELA, GRAV_ESTADO) and tecla_pendente is not None:
+            latencias.append(t - tecla_pendente)
+            tecla_pendente = None
+        if tipo == GRAV_ESTADO:
+            if c[1] == ESTADO_PREPARANDO:
+                inicio_preparo = t
+            elif c[0] == ESTADO_PREPARANDO and inicio_preparo is not None:
+                preparos.append(t - inicio_preparo)
+                inicio_preparo = None
+    return latencias, preparos
+
+
+def resumo(nome, valores):
+    if not valores:
+        return f"{nome}: sem amostras"
+    ordenados = sorted(valores)
+    p95 = ordenados[min(len(ordenados) - 1, int(0.95 * len(ordenados)))]
+    return (f"{nome}: n={len(valores)} min={ordenados[0]} mediana={statistics.median(ordenados):.0f} "
+            f"p95={p95} max={ordenados[-1]} ms")
+
+
+def main(args):
+    if len(args) < 2:
+        sys.exit("uso: gravacao.py decodificar|metricas|comparar|gerar-c ...")
+    comando = args[0]
+    if comando == "decodificar":
+        for t, tipo, c in registros(ler_log(args[1])):
+            print(f"{t:10d} ms  {descrever(tipo, c)}")
+    elif comando == "metricas":
+        lat, prep = metricas(ler_log(args[1]))
+        print(resumo("tecla -> tela", lat))
+        print(resumo("ciclo de preparo", prep))
+    elif comando == "comparar" and len(args) >= 3:
+        for caminho in args[1:3]:
+            lat, prep = metricas(ler_log(caminho))
+            print(caminho)
+            print("  " + resumo("tecla -> tela", lat))
+            print("  " + resumo("ciclo de preparo", prep))
+    elif comando == "gerar-c" and len(args) >= 3:
+        dados = ler_log(args[1])
+        with open(args[2], "w") as f:
+            f.write("// Gerado por ferramentas/gravacao.py a partir de uma sessão gravada\n")
+            f.write("#include <stdint.h>\n\n")
+            f.write(f"const uint32_t gravacao_reproducao_tamanho = {len(dados)};\n")
+            f.write("const uint8_t gravacao_reproducao[] = {\n")
+            for i in range(0, len(dados), 16):
+                f.write("  " + ", ".join(f"0x{b:02x}" for b in dados[i:i + 16]) + ",\n")
+            f.write("};\n")
+    else:
+        sys.exit("comando desconhecido")
+
+
+if __name__ == "__main__":
+    main(sys.argv[1:])
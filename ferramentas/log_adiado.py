@@ -0,0 +1,94 @@
+#!/usr/bin/env python3
+# log_adiado.py
+# Reconstrói o texto do log adiado (diagnostico/log_adiado.c) a partir das strings de formato no ELF
+#
+# Uso: log_adiado.py <log_serial> <firmware.elf>
+# O log serial contém as linhas "LOG ..." enviadas pelo firmware; as demais linhas são repassadas sem
+# alteração, para que a saída continue legível junto com os outros diagnósticos.
+
+import re
+import struct
+import sys
+
+BASE_FLASH = 0x10000000
+SHF_ALLOC = 0x2
+SHT_NOBITS = 8
+
+# Especificação de conversão do printf: flags, largura, precisão, modificador de tamanho e tipo
+CONVERSAO = re.compile(r"%([-+ #0]*\d*(?:\.\d+)?)(hh|h|ll|l|z|t|j)?([diouxXcsfFeEgGp%])")
+
+
+class Elf:
+    """Leitor mínimo de ELF32 little-endian: conteúdo das seções carregadas, por endereço."""
+
+    def __init__(self, caminho):
+        with open(caminho, "rb") as f:
+            self.dados = f.read()
+        if self.dados[:4] != b"\x7fELF" or self.dados[4] != 1:
+            sys.exit(f"{caminho}: não é um ELF de 32 bits")
+        shoff, = struct.unpack_from("<I", self.dados, 0x20)
+        shentsize, shnum = struct.unpack_from("<HH", self.dados, 0x2E)
+        self.secoes = []
+        for i in range(shnum):
+            _, tipo, flags, endereco, offset, tamanho = struct.unpack_from("<IIIIII", self.dados, shoff + i * shentsize)
+            if flags & SHF_ALLOC and tipo != SHT_NOBITS and tamanho > 0:
+                self.secoes.append((endereco, offset, tamanho))
+
+    def string(self, endereco):
+        for inicio, offset, tamanho in self.secoes:
+            if inicio <= endereco < inicio + tamanho:
+                pos = offset + endereco - inicio
+                fim = self.dados.index(b"\0", pos, offset + tamanho)
+                return self.dados[pos:fim].decode("utf-8", errors="replace")
+        return None
+
+
+def formatar(elf, formato, argumentos):
+    texto, args = [], iter(argumentos)
+    ultimo = 0
+    for m in CONVERSAO.finditer(formato):
+        texto.append(formato[ultimo:m.start()])
+        ultimo = m.end()
+        especificacao, tipo = m.group(1), m.group(3)
+        if tipo == "%":
+            texto.append("%")
+            continue
+        valor = next(args, 0)
+        if tipo in "di":
+            valor = struct.unpack("<i", struct.pack("<I", valor))[0]
+        elif tipo in "fFeEgG":
+            valor = struct.unpack("<f", struct.pack("<I", valor))[0]
+        elif tipo == "s":
+            valor = elf.string(valor) or f"<ram 0x{valor:08x}>"
+        elif tipo == "p":
+            especificacao, tipo, valor = "", "s", f"0x{valor:08x}"
+        elif tipo == "c":
+            valor = chr(valor & 0xFF)
+        texto.append(f"%{especificacao}{tipo}" % valor)
+    texto.append(formato[ultimo:])
+    return "".join(texto)
+
+
+def main(args):
+    if len(args) != 2:
+        sys.exit("uso: log_adiado.py <log_serial> <firmware.elf>")
+    elf = Elf(args[1])
+    with open(args[0], encoding="utf-8", errors="replace") as f:
+        for linha in f:
+            partes = linha.split()
+            if not partes or partes[0] != "LOG" or len(partes) < 3:
+                sys.stdout.write(linha)
+                continue
+            palavras = [int(p, 16) for p in partes[1:]]
+            endereco = BASE_FLASH + (palavras[0] & 0xFFFFFF)
+            formato = elf.string(endereco)
+            if formato is None:
+                print(f"[{palavras[1] / 1e6:12.6f}] <formato desconhecido em 0x{endereco:08x}>")
+                continue
+            print(f"[{palavras[1] / 1e6:12.6f}] {formatar(elf, formato, palavras[2:])}", end="")
+            if not formato.endswith("\n"):
+                print()
+
+
+if __name__ == "__main__":
+    main(sys.argv[1:])
@@ -0,0 +1,102 @@
+#!/usr/bin/env python3
+# perfil_simbolos.py
+# Simboliza o histograma do perfilador (diagnostico/perfil.c) contra o ELF do firmware
+#
+# Uso: perfil_simbolos.py <log_serial> <firmware.elf> [--nm arm-none-eabi-nm] [--top 30]
+# O log serial contém as linhas "PERF ..." enviadas ao apertar TEST no controle (TEST 4 liga a
+# amostragem, o TEST 4 seguinte envia o histograma). O relatório separa
+# o tempo ocioso (núcleo parado em WFE/WFI, ou dentro das rotinas de espera do SDK) do tempo ocupado
+# e agrupa o tempo ocupado por função e por módulo (pasta do arquivo-fonte).
+
+import argparse
+import bisect
+import collections
+import os
+import subprocess
+import sys
+
+# Rotinas de espera do SDK: amostras fora do WFE em si, mas ainda dentro de sleep_ms/sleep_until
+FUNCOES_OCIOSAS = {"sleep_ms", "sleep_until", "best_effort_wfe_or_timeout", "sleep_us"}
+
+
+def ler_log(caminho):
+    amostras, cabecalho = {}, {}
+    with open(caminho, encoding="utf-8", errors="replace") as f:
+        for linha in f:
+            partes = linha.split()
+            if len(partes) >= 2 and partes[0] == "PERF":
+                if partes[1] == "INICIO":
+                    amostras, cabecalho = {}, dict(p.split("=") for p in partes[2:])
+                elif partes[1] != "FIM" and len(partes) == 3:
+                    amostras[int(partes[1], 16)] = int(partes[2])
+    if not cabecalho:
+        sys.exit(f"{caminho}: nenhum perfil encontrado")
+    return {k: int(v) for k, v in cabecalho.items()}, amostras
+
+
+def ler_simbolos(elf, nm):
+    saida = subprocess.run([nm, "-n", "-S", "-l", "--defined-only", elf],
+                           capture_output=True, text=True, check=True).stdout
+    simbolos = []
+    for linha in saida.splitlines():
+        campos, _, origem = linha.partition("\t")
+        partes = campos.split()
+        if len(partes) == 4 and partes[2] in "tTwW":
+            inicio, tamanho = int(partes[0], 16) & ~1, int(partes[1], 16)
+            arquivo = origem.rsplit(":", 1)[0]
+            modulo = os.path.basename(os.path.dirname(arquivo)) if arquivo else "?"
+            simbolos.append((inicio, tamanho, partes[3], modulo or "?"))
+    simbolos.sort()
+    return simbolos
+
+
+def localizar(simbolos, inicios, pc):
+    i = bisect.bisect_right(inicios, pc) - 1
+    if i >= 0:
+        inicio, tamanho, nome, modulo = simbolos[i]
+        if pc < inicio + max(tamanho, 2):
+            return nome, modulo
+    return f"?{pc:08x}", "?"
+
+
+def main():
+    args = argparse.ArgumentParser()
+    args.add_argument("log")
+    args.add_argument("elf")
+    args.add_argument("--nm", default="arm-none-eabi-nm")
+    args.add_argument("--top", type=int, default=30)
+    opcoes = args.parse_args()
+
+    cabecalho, amostras = ler_log(opcoes.log)
+    simbolos = ler_simbolos(opcoes.elf, opcoes.nm)
+    inicios = [s[0] for s in simbolos]
+
+    por_funcao, por_modulo = collections.Counter(), collections.Counter()
+    ociosas = cabecalho.get("ociosas", 0)
+    for pc, n in amostras.items():
+        nome, modulo = localizar(simbolos, inicios, pc)
+        if nome in FUNCOES_OCIOSAS:
+            ociosas += n
+            continue
+        por_funcao[(nome, modulo)] += n
+        por_modulo[modulo] += n
+
+    total = cabecalho.get("total", 0) or 1
+    ocupadas = sum(por_funcao.values())
+    periodo = cabecalho.get("periodo_us", 1000)
+    print(f"amostras: {total} a cada {periodo} us ({total * periodo / 1e6:.1f} s), "
+          f"descartadas: {cabecalho.get('descartadas', 0)}")
+    print(f"ocioso:  {ociosas:8d} ({100 * ociosas / total:5.1f}%)")
+    print(f"ocupado: {ocupadas:8d} ({100 * ocupadas / total:5.1f}%)")
+
+    print("\npor módulo (tempo ocupado)")
+    for modulo, n in por_modulo.most_common():
+        print(f"  {n:8d} {100 * n / total:5.1f}%  {modulo}")
+
+    print(f"\npor função (tempo ocupado, {opcoes.top} maiores)")
+    for (nome, modulo), n in por_funcao.most_common(opcoes.top):
+        print(f"  {n:8d} {100 * n / total:5.1f}%  {nome} [{modulo}]")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,106 @@
+#!/usr/bin/env python3
+# placa.py
+# Lado do host da descrição da placa (placa/placa.h): lê os #define e as anotações "wokwi:" e
+#  - confere o diagram.json do Wokwi: cada GPIO precisa chegar à peça anotada (direto ou através de
+#    um resistor), e nenhum GPIO ligado no diagrama pode ficar sem descrição;
+#  - exporta a descrição em JSON para outras ferramentas (o bench_emulador.mjs lê o mesmo placa.h).
+#
+# Uso: placa.py [--placa placa/placa.h] [--diagrama diagram.json] [--json]
+# Termina com código 1 se houver divergência entre a placa e o diagrama.
+
+import argparse
+import json
+import os
+import re
+import sys
+
+RAIZ = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+# "#define SDA_PIN 4             // wokwi: lcd1:SDA rtc1:SDA"
+DEFINE = re.compile(r"^#define\s+(\w+)\s+(0x[0-9A-Fa-f]+|\d+)\b(?:.*//\s*wokwi:\s*([^()]*))?")
+PINOS_IGNORADOS = {"pico:GP0", "pico:GP1"}  # monitor serial do Wokwi (o GP1 também é o receptor IR)
+
+
+def ler_placa(caminho):
+    valores, ligacoes = {}, {}
+    with open(caminho, encoding="utf-8") as f:
+        for linha in f:
+            m = DEFINE.match(linha.strip())
+            if not m:
+                continue
+            nome, valor, anotacao = m.group(1), int(m.group(2), 0), m.group(3)
+            valores[nome] = valor
+            if anotacao:
+                ligacoes[nome] = anotacao.split()
+    return valores, ligacoes
+
+
+def vizinhos(diagrama):
+    tipos = {p["id"]: p["type"] for p in diagrama["parts"]}
+    grafo = {}
+    for conexao in diagrama["connections"]:
+        a, b = conexao[0], conexao[1]
+        grafo.setdefault(a, set()).add(b)
+        grafo.setdefault(b, set()).add(a)
+    return tipos, grafo
+
+
+# Pinos de peças alcançados a partir do GPIO, atravessando resistores (terminal 1 <-> 2)
+def alcancados(gpio, tipos, grafo):
+    vistos, pendentes = set(), [f"pico:GP{gpio}"]
+    while pendentes:
+        no = pendentes.pop()
+        if no in vistos:
+            continue
+        vistos.add(no)
+        for outro in grafo.get(no, ()):
+            pendentes.append(outro)
+            peca, _, pino = outro.partition(":")
+            if tipos.get(peca) == "wokwi-resistor":
+                pendentes.append(f"{peca}:{'2' if pino == '1' else '1'}")
+    return {n for n in vistos if not n.startswith("pico:")}
+
+
+def conferir(valores, ligacoes, diagrama):
+    tipos, grafo = vizinhos(diagrama)
+    erros = []
+    descritos = set()
+    for nome, esperados in ligacoes.items():
+        gpio = valores[nome]
+        descritos.add(f"pico:GP{gpio}")
+        chegam = alcancados(gpio, tipos, grafo)
+        for esperado in esperados:
+            peca = esperado.split(":")[0]
+            ok = esperado in chegam if ":" in esperado else any(n.split(":")[0] == peca for n in chegam)
+            if not ok:
+                erros.append(f"{nome} (GP{gpio}) deveria ligar em {esperado}; no diagrama chega em "
+                             f"{', '.join(sorted(chegam)) or 'nada'}")
+    for no in sorted(grafo):
+        if re.match(r"pico:GP\d+$", no) and no not in descritos and no not in PINOS_IGNORADOS:
+            erros.append(f"{no} está ligado no diagrama mas não aparece em placa.h")
+    return erros
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("--placa", default=os.path.join(RAIZ, "placa", "placa.h"))
+    parser.add_argument("--diagrama", default=os.path.join(RAIZ, "diagram.json"))
+    parser.add_argument("--json", action="store_true", help="imprime a descrição da placa em JSON")
+    args = parser.parse_args()
+
+    valores, ligacoes = ler_placa(args.placa)
+    if args.json:
+        print(json.dumps({"valores": valores, "wokwi": ligacoes}, indent=2, ensure_ascii=False))
+        return 0
+
+    with open(args.diagrama, encoding="utf-8") as f:
+        diagrama = json.load(f)
+    erros = conferir(valores, ligacoes, diagrama)
+    for erro in erros:
+        print(f"DIVERGÊNCIA: {erro}")
+    print(f"{len(ligacoes)} pinos conferidos, {len(erros)} divergências")
+    return 1 if erros else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,102 @@
+#!/usr/bin/env python3
+# rastreio_perfetto.py
+# Converte o rastreamento de eventos (diagnostico/rastreio.c) para o formato JSON do Chrome/Perfetto
+#
+# Uso: rastreio_perfetto.py <log_serial> <saida.json>
+# O log serial contém as linhas "RAST ..." enviadas ao apertar TEST no controle. O JSON pode ser aberto
+# em https://ui.perfetto.dev ou em chrome://tracing.
+
+import json
+import struct
+import sys
+
+ESTADOS = ["TELA_INICIAL", "QUANTIDADE_XICARAS", "QUANDO_PREPARAR", "PREPARANDO", "PROGRAMANDO", "AGUARDANDO"]
+ETAPAS = ["VERIFICACAO", "INICIO", "INTENSIDADE", "AQUECIMENTO", "GRAOS", "MOAGEM", "EXTRACAO", "FINALIZACAO"]
+ATUADORES = ["SERVO_GRAOS", "SERVO_CAFE_MOIDO", "MOTOR_PASSO", "BUZZER", "BARRA_LEDS"]
+TRECHOS = ESTADOS + ["CALLBACK_IR", "LER_DIGITO", "CONFIGURAR_HORARIO", "VERIFICAR_RECURSOS",
+                     "LEITURA_RTC", "LEITURA_DHT"]
+EVENTOS = (["TIQUE", "PLAY", "MENU"] + [f"TECLA_{d}" for d in range(10)] +
+           ["OUTRA_TECLA", "PREPARO_CONCLUIDO", "AGENDAMENTO_VALIDO", "AGENDAMENTO_CANCELADO"])
+ANIMACOES = ["DIGITAR", "PISCAR", "APAGAR_ESCREVER", "ROLAR", "CONTADOR"]
+DISPOSITIVOS_I2C = {0x27: "LCD", 0x68: "RTC"}
+
+(ESTADO, I2C_INICIO, I2C_FIM, IR_QUADRO, ATUADOR_INICIO, ATUADOR_FIM, ETAPA_INICIO, ETAPA_FIM,
+ PRAZO_ESTOURADO, TRANSICAO, ANIMACAO_INICIO, ANIMACAO_FIM) = range(1, 13)
+
+# Uma trilha (tid) por tipo de evento
+TRILHAS = {1: "Estados", 2: "Etapas do preparo", 3: "I2C", 4: "IR (IRQ)", 5: "Atuadores", 6: "Prazos estourados", 7: "Transições",
+           8: "Animações do LCD"}
+
+
+def nome(lista, indice):
+    return lista[indice] if indice < len(lista) else str(indice)
+
+
+def ler_registros(caminho):
+    registros = []
+    with open(caminho, encoding="utf-8", errors="replace") as f:
+        for linha in f:
+            linha = linha.strip()
+            if linha.startswith("RAST ") and not linha.startswith(("RAST INICIO", "RAST FIM")):
+                registros.append(struct.unpack("<IHHI", bytes.fromhex(linha[5:])))
+    return registros
+
+
+def converter(registros):
+    eventos = [{"ph": "M", "pid": 1, "tid": tid, "name": "thread_name", "args": {"name": n}}
+               for tid, n in TRILHAS.items()]
+    base, anterior, estendido = None, None, 0
+    estado_aberto = None
+    for tempo, evento, arg0, arg1 in registros:
+        if anterior is not None and tempo < anterior:  # time_us_32 voltou a zero (a cada ~71 min)
+            estendido += 1 << 32
+        anterior = tempo
+        ts = tempo + estendido
+        if base is None:
+            base = ts
+        ts -= base
+
+        if evento == ESTADO:
+            if estado_aberto is not None:
+                eventos.append({"ph": "E", "pid": 1, "tid": 1, "ts": ts})
+            eventos.append({"ph": "B", "pid": 1, "tid": 1, "ts": ts, "name": nome(ESTADOS, arg1)})
+            estado_aberto = arg1
+        elif evento in (ETAPA_INICIO, ETAPA_FIM):
+            eventos.append({"ph": "B" if evento == ETAPA_INICIO else "E", "pid": 1, "tid": 2, "ts": ts,
+                            "name": nome(ETAPAS, arg0), "args": {"arg": arg1}})
+        elif evento in (I2C_INICIO, I2C_FIM):
+            dispositivo = DISPOSITIVOS_I2C.get(arg0, f"0x{arg0:02x}")
+            chave = "bytes" if evento == I2C_INICIO else "resultado"
+            eventos.append({"ph": "B" if evento == I2C_INICIO else "E", "pid": 1, "tid": 3, "ts": ts,
+                            "name": dispositivo, "args": {chave: arg1}})
+        elif evento == IR_QUADRO:
+            eventos.append({"ph": "i", "s": "t", "pid": 1, "tid": 4, "ts": ts,
+                            "name": f"IR 0x{arg0:02x}" + (" (repetição)" if arg1 == 2 else "")})
+        elif evento in (ATUADOR_INICIO, ATUADOR_FIM):
+            eventos.append({"ph": "B" if evento == ATUADOR_INICIO else "E", "pid": 1, "tid": 5, "ts": ts,
+                            "name": nome(ATUADORES, arg0), "args": {"arg": arg1}})
+        elif evento == PRAZO_ESTOURADO:
+            eventos.append({"ph": "i", "s": "t", "pid": 1, "tid": 6, "ts": ts,
+                            "name": nome(TRECHOS, arg0), "args": {"duracao_us": arg1}})
+        elif evento == TRANSICAO:  # registrado no fim da transição, com a duração
+            eventos.append({"ph": "X", "pid": 1, "tid": 7, "ts": ts - arg1, "dur": arg1,
+                            "name": nome(EVENTOS, arg0)})
+        elif evento in (ANIMACAO_INICIO, ANIMACAO_FIM):  # assíncronos: várias animações ao mesmo tempo
+            fim = evento == ANIMACAO_FIM
+            eventos.append({"ph": "e" if fim else "b", "cat": "animacao", "id": arg1 & 0xFFFF, "pid": 1, "tid": 8,
+                            "ts": ts, "name": nome(ANIMACOES, arg0),
+                            "args": {"concluida": bool(arg1 & 0x10000)} if fim else {}})
+    return {"traceEvents": eventos, "displayTimeUnit": "ms"}
+
+
+def main(args):
+    if len(args) != 2:
+        sys.exit("uso: rastreio_perfetto.py <log_serial> <saida.json>")
+    registros = ler_registros(args[0])
+    with open(args[1], "w") as f:
+        json.dump(converter(registros), f)
+    print(f"{len(registros)} registros convertidos para {args[1]}")
+
+
+if __name__ == "__main__":
+    main(sys.argv[1:])
@@ -0,0 +1,121 @@
+#!/usr/bin/env python3
+# uso_memoria.py
+# Resumo estático do uso de flash e RAM por módulo, a partir do mapa do ligador (firmware.elf.map)
+#
+# Uso: uso_memoria.py <firmware.elf.map> [--todos]
+# Módulos do projeto são agrupados pela pasta do arquivo-fonte (sensores, display LCD, ...); os do SDK
+# pela biblioteca (hardware_i2c, pico_stdio_usb, ...); as bibliotecas do compilador pelo arquivo .a.
+# Seções .data contam nas duas memórias: ocupam RAM e a imagem de inicialização fica na flash.
+# Sem --todos, módulos com menos de 1% do total são somados em "outros".
+
+import argparse
+import collections
+import os
+import re
+import sys
+
+FLASH = (0x10000000, 0x11000000)
+RAM = (0x20000000, 0x20042000)
+
+# " .text.setup_machine  0x10000354  0x58 CMakeFiles/x.dir/processos_internos/processos_internos.c.obj"
+# (nomes de seção longos quebram a linha antes do endereço)
+SECAO = re.compile(r"^ (\.\S+|COMMON)\s*$")
+ENTRADA = re.compile(r"^ (?:(\.\S+|COMMON)\s+)?\s*0x([0-9a-f]+)\s+0x([0-9a-f]+)\s+(\S.*)$")
+PILHAS = re.compile(r"^\s+0x([0-9a-f]+)\s+(__Stack\w+|__HeapLimit|__end__)\s*=")
+
+
+def modulo(objeto):
+    objeto = objeto.strip()
+    arquivo = re.match(r"(.*\.a)\((.*)\)$", objeto)
+    if arquivo:
+        return os.path.basename(arquivo.group(1))
+    caminho = objeto.replace("\\", "/")
+    sdk = re.search(r"/src/(?:rp2_common|common|rp2040|host)/([^/]+)/", caminho)
+    if sdk:
+        return sdk.group(1)
+    if ".dir/" in caminho:
+        relativo = caminho.split(".dir/", 1)[1]
+        pasta = os.path.dirname(relativo)
+        return os.path.basename(pasta) if pasta else os.path.splitext(os.path.basename(relativo))[0].replace(".c", "")
+    return os.path.basename(caminho)
+
+
+def dentro(faixa, endereco):
+    return faixa[0] <= endereco < faixa[1]
+
+
+def ler_mapa(caminho):
+    flash, ram = collections.Counter(), collections.Counter()
+    simbolos = {}
+    em_mapa = False
+    secao = None
+    with open(caminho, encoding="utf-8", errors="replace") as f:
+        for linha in f:
+            if linha.startswith("Linker script and memory map"):
+                em_mapa = True
+                continue
+            if not em_mapa:
+                continue
+            linha = linha.rstrip("\n")
+            simbolo = PILHAS.match(linha)
+            if simbolo:
+                simbolos[simbolo.group(2)] = int(simbolo.group(1), 16)
+                continue
+            so_secao = SECAO.match(linha)
+            if so_secao:
+                secao = so_secao.group(1)
+                continue
+            entrada = ENTRADA.match(linha)
+            if not entrada or "*fill*" in linha:
+                secao = None
+                continue
+            nome = entrada.group(1) or secao
+            secao = None
+            endereco, tamanho = int(entrada.group(2), 16), int(entrada.group(3), 16)
+            if nome is None or tamanho == 0 or entrada.group(4).startswith(("LOAD", "0x")):
+                continue
+            dono = modulo(entrada.group(4))
+            if dentro(FLASH, endereco):
+                flash[dono] += tamanho
+            elif dentro(RAM, endereco):
+                ram[dono] += tamanho
+                if nome.startswith((".data", ".time_critical")):
+                    flash[dono] += tamanho  # cópia de inicialização na flash
+    return flash, ram, simbolos
+
+
+def main():
+    args = argparse.ArgumentParser()
+    args.add_argument("mapa")
+    args.add_argument("--todos", action="store_true")
+    opcoes = args.parse_args()
+
+    flash, ram, simbolos = ler_mapa(opcoes.mapa)
+    total_flash, total_ram = sum(flash.values()), sum(ram.values())
+    if total_flash == 0:
+        sys.exit(f"{opcoes.mapa}: nenhuma seção reconhecida")
+
+    modulos = sorted(set(flash) | set(ram), key=lambda m: -(flash[m] + ram[m]))
+    outros = [0, 0]
+    print(f"{'modulo':<24} {'flash':>8} {'ram':>8}")
+    for m in modulos:
+        if not opcoes.todos and flash[m] < total_flash / 100 and ram[m] < total_ram / 100:
+            outros[0] += flash[m]
+            outros[1] += ram[m]
+            continue
+        print(f"{m:<24} {flash[m]:8d} {ram[m]:8d}")
+    if outros != [0, 0]:
+        print(f"{'outros':<24} {outros[0]:8d} {outros[1]:8d}")
+    print(f"{'TOTAL':<24} {total_flash:8d} {total_ram:8d}")
+
+    # Reservas de pilha do script de ligação (a marca d'água em execução vem de diagnostico/pilha.c)
+    if "__StackTop" in simbolos and "__StackBottom" in simbolos:
+        print(f"\npilha nucleo0: {simbolos['__StackTop'] - simbolos['__StackBottom']} bytes")
+    if "__StackOneTop" in simbolos and "__StackOneBottom" in simbolos:
+        print(f"pilha nucleo1: {simbolos['__StackOneTop'] - simbolos['__StackOneBottom']} bytes")
+    if "__HeapLimit" in simbolos and "__end__" in simbolos:
+        print(f"heap: {simbolos['__HeapLimit'] - simbolos['__end__']} bytes")
+
+
+if __name__ == "__main__":
+    main()
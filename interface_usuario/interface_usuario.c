@@ -5,109 +5,227 @@
 #include <stdio.h>
 #include "pico/stdlib.h"
 #include <string.h>
+#include <ctype.h>
 #include "lcd_i2c.h"
 #include "sensores.h"
 #include "atuadores.h"
 #include "controle_ir.h"
 #include "estado.h"
-
-#define DHT_PIN 8 // DHT22 usado para monitorar temperatura/umidade ambiente
-#define I2C_PORT i2c0
-#define SDA_PIN 4
-#define SCL_PIN 5
-#define BUZZER_PIN 14 // Buzzer para notificações sonoras
+#include "gravador.h"
+#include "rastreio.h"
+#include "latencia.h"
+#include "perfil.h"
+#include "pilha.h"
+#include "monitor.h"
+#include "energia.h"
+#include "frequencia.h"
+#include "armazenamento.h"
+#include "telemetria.h"
+#include "servidor_status.h"
+#include "log_adiado.h"
+#include "tela.h"
+#include "placa.h"
+
+#define INTERVALO_DHT_MS 2000 // intervalo mínimo entre leituras do DHT22
+#define DHT_PRONTO_MS 2000    // o DHT22 só responde 2 s depois de ligado
 
 extern float agua_ml;
 extern float graos_g;
-extern Estado estado_atual;
-extern int xicaras;
 extern bool play_apertado;
 extern bool tecla_pressionada;
-extern bool preparo_agora;
 extern char tecla[16];
 
 // -------------------------------------------------------------------------------------------------- //
 // Funções de Tela e Menu
 
+static const Rotulo rotulos_quantidade_xicaras[] = {
+  {0, 0, "HOW MANY CUPS?"},
+  {2, 0, "- FROM 1 TO 5"},
+  {3, 0, "- 0 TO EXIT"},
+};
+static const Tela tela_quantidade_xicaras = {rotulos_quantidade_xicaras, TOTAL_ITENS(rotulos_quantidade_xicaras), NULL, 0, NULL};
+
+static const Rotulo rotulos_quando_preparar[] = {
+  {0, 0, "START TIME:"},
+  {2, 0, "1-NOW"},
+  {3, 0, "2-SCHEDULE"},
+};
+static const Tela tela_quando_preparar = {rotulos_quando_preparar, TOTAL_ITENS(rotulos_quando_preparar), NULL, 0, NULL};
+
 void perguntar_quantidade_xicaras() {
   lcd_clear();
-  lcd_set_cursor(0, 0);
-  lcd_print("HOW MANY CUPS?");
-  lcd_set_cursor(2, 0);
-  lcd_print("- FROM 1 TO 5");
-  lcd_set_cursor(3, 0);
-  lcd_print("- 0 TO EXIT");
+  tela_exibir(&tela_quantidade_xicaras);
 }
 
 void perguntar_quando_preparar() {
   lcd_clear();
-  lcd_set_cursor(0, 0);
-  lcd_print("START TIME:");
-  lcd_set_cursor(2, 0);
-  lcd_print("1-NOW");
-  lcd_set_cursor(3, 0);
-  lcd_print("2-SCHEDULE");
+  tela_exibir(&tela_quando_preparar);
 }
 
 // -------------------------------------------------------------------------------------------------- //
 // Tela Inicial e Monitoramento
 
-// Função que exibe a tela inicial com dados de B(beans = grãos de café) e W (water = água) atualizados
-void exibir_tela_inicial() {
-  gpio_put(7, 1); // Acende o LED verde para indicar que a máquina está ligada
-  static float last_agua_ml = -1.0;
-  static float last_graos_g = -1.0;
-
-  lcd_clear();
-  type_effect(" IT'S COFFEE TIME!", 0, 50);
-  sleep_ms(500);
-
-  if (agua_ml != last_agua_ml || graos_g != last_graos_g) {
-    char status[32];
-    snprintf(status, sizeof(status), "B:%.0fg|W:%.2fL", graos_g, agua_ml / 1000);
-    type_effect(status, 2, 100);
-    last_agua_ml = agua_ml;
-    last_graos_g = graos_g;
-  }
+// Fontes de dados da tela inicial: cada amostragem publica uma nova versão apenas se o valor mudou
+static struct {
+  FonteDados fonte;
+  float agua_ml, graos_g;
+} estoque = {{0}, -1.0, -1.0};
+
+static struct {
+  FonteDados fonte;
+  uint8_t horas, minutos;
+} relogio = {{0}, 0xFF, 0xFF};
+
+static struct {
+  FonteDados fonte;
+  int16_t temperatura_x10, umidade_x10; // décimos, na resolução do DHT22
+  bool valida;
+  bool lida; // primeira leitura feita (o DHT22 só responde 2 s depois de ligado)
+} ambiente;
+static uint32_t proxima_leitura_dht_ms = 0;
+
+static void formatar_estoque(char *destino, size_t tamanho) {
+  snprintf(destino, tamanho, "B:%.0fg|W:%.2fL", estoque.graos_g, estoque.agua_ml / 1000);
 }
 
-// Função que exibe as condições ambientes atualizadas na tela inicial
-void exibir_temperatura_umidade_ambiente() {
-  dht_reading reading;
-  read_from_dht(&reading, DHT_PIN);
+static void formatar_relogio(char *destino, size_t tamanho) {
+  snprintf(destino, tamanho, "%02d:%02d", relogio.horas, relogio.minutos);
+}
 
-  lcd_set_cursor(3, 0);
-  if (is_valid_reading(&reading)) {
-    char buffer[32];
-    snprintf(buffer, sizeof(buffer), "%.1fC|H:%.1f%%", reading.temp_celsius, reading.humidity);
-    lcd_print(buffer);
+static void formatar_ambiente(char *destino, size_t tamanho) {
+  if (!ambiente.lida) {
+    snprintf(destino, tamanho, "--.-C|H:--.-%%");
+  } else if (ambiente.valida) {
+    snprintf(destino, tamanho, "%.1fC|H:%.1f%%", ambiente.temperatura_x10 / 10.0, ambiente.umidade_x10 / 10.0);
   } else {
-    lcd_print("Error!");
-    play_error_tone(BUZZER_PIN);
+    snprintf(destino, tamanho, "Error!");
+  }
+}
+
+static const Campo campos_tela_inicial[] = {
+  {2, 0, LCD_COLS, &estoque.fonte, formatar_estoque},
+  {3, 0, 15, &ambiente.fonte, formatar_ambiente},
+  {3, 15, 5, &relogio.fonte, formatar_relogio},
+};
+static uint32_t versoes_tela_inicial[TOTAL_ITENS(campos_tela_inicial)];
+static const Tela tela_inicial = {NULL, 0, campos_tela_inicial, TOTAL_ITENS(campos_tela_inicial), versoes_tela_inicial};
+
+static void amostrar_estoque() {
+  if (agua_ml != estoque.agua_ml || graos_g != estoque.graos_g) {
+    estoque.agua_ml = agua_ml;
+    estoque.graos_g = graos_g;
+    fonte_publicar(&estoque.fonte);
   }
-  sleep_ms(300);
 }
 
-// Função que exibe o relógio HH:MM na tela inicial
-void exibir_relogio() {
+// Horário HH:MM lido do RTC
+static void amostrar_relogio() {
   uint8_t rtc_data[7];
-  char time_buffer[6];
   rtc_read(I2C_PORT, SDA_PIN, SCL_PIN, rtc_data);
 
   uint8_t hours = (rtc_data[2] & 0x0F) + ((rtc_data[2] >> 4) * 10);
   uint8_t minutes = (rtc_data[1] & 0x0F) + ((rtc_data[1] >> 4) * 10);
+  if (hours != relogio.horas || minutes != relogio.minutos) {
+    relogio.horas = hours;
+    relogio.minutos = minutes;
+    fonte_publicar(&relogio.fonte);
+  }
+}
+
+// Temperatura e umidade do DHT22, respeitando o intervalo mínimo de 2 s entre leituras do sensor
+static void amostrar_ambiente(bool forcar) {
+  uint32_t agora = to_ms_since_boot(get_absolute_time());
+  if (agora < DHT_PRONTO_MS) return; // no boot a tela mostra "--.-" até o sensor ligar
+  if (!forcar && agora < proxima_leitura_dht_ms) return;
+  proxima_leitura_dht_ms = agora + INTERVALO_DHT_MS;
+
+  dht_reading reading;
+  read_from_dht(&reading, DHT_PIN);
+  bool valida = is_valid_reading(&reading);
+  int16_t temperatura = (int16_t)(reading.temp_celsius * 10 + (reading.temp_celsius < 0 ? -0.5f : 0.5f));
+  int16_t umidade = (int16_t)(reading.humidity * 10 + 0.5f);
+  if (!valida) {
+    play_error_tone(BUZZER_PIN);
+  } else {
+    telemetria_registrar_ambiente(temperatura, umidade); // média do período vai para o histórico
+  }
+  if (!ambiente.lida || valida != ambiente.valida ||
+      (valida && (temperatura != ambiente.temperatura_x10 || umidade != ambiente.umidade_x10))) {
+    ambiente.lida = true;
+    ambiente.valida = valida;
+    ambiente.temperatura_x10 = temperatura;
+    ambiente.umidade_x10 = umidade;
+    fonte_publicar(&ambiente.fonte);
+  }
+}
+
+bool ambiente_atual(int16_t *temperatura_x10, int16_t *umidade_x10) {
+  *temperatura_x10 = ambiente.temperatura_x10;
+  *umidade_x10 = ambiente.umidade_x10;
+  return ambiente.lida && ambiente.valida;
+}
+
+// Função que exibe a tela inicial com dados de B(beans = grãos de café) e W (water = água) atualizados
+void exibir_tela_inicial() {
+  gpio_put(LED_VERDE, 1); // Acende o LED verde para indicar que a máquina está ligada
+
+  lcd_clear();
+  type_effect(" IT'S COFFEE TIME!", 0, 50); // segue digitando enquanto os campos são preenchidos
+
+  amostrar_estoque();
+  amostrar_relogio();
+  amostrar_ambiente(true);
+  tela_exibir(&tela_inicial);
+}
 
-  snprintf(time_buffer, sizeof(time_buffer), "%02d:%02d", hours, minutes);
-  lcd_set_cursor(3, 15);
-  lcd_print(time_buffer);
-  sleep_ms(300);
+// Atualiza estoque, relógio e condições ambientes; só os campos alterados são reescritos no display
+void atualizar_tela_inicial() {
+  amostrar_estoque();
+  amostrar_relogio();
+  amostrar_ambiente(false);
+  tela_atualizar(&tela_inicial);
+}
+
+// -------------------------------------------------------------------------------------------------- //
+// Relatórios pela USB: TEST abre a seleção e a tecla seguinte escolhe um relatório (TEST de novo pede
+// todos). A tecla da seleção não chega à máquina de estados; uma tecla fora da lista só a cancela
+
+static bool selecionando_relatorio = false;
+
+static void solicitar_relatorio(const char *key) {
+  bool todos = strcmp(key, "TEST") == 0;
+  if (todos || strcmp(key, "1") == 0) gravador_solicitar_descarga();      // gravação da sessão
+  if (todos || strcmp(key, "2") == 0) rastreio_solicitar_descarga();      // linha do tempo de eventos
+  if (todos || strcmp(key, "3") == 0) latencia_solicitar_relatorio();     // latência do controle
+  if (todos || strcmp(key, "4") == 0) perfil_solicitar_descarga();        // perfil de CPU (liga/envia)
+  if (todos || strcmp(key, "5") == 0) pilha_solicitar_relatorio();        // marcas d'água das pilhas
+  if (todos || strcmp(key, "6") == 0) monitor_solicitar_relatorio();      // estatísticas de prazos
+  if (todos || strcmp(key, "7") == 0) energia_solicitar_relatorio();      // estados de energia
+  if (todos || strcmp(key, "8") == 0) frequencia_solicitar_relatorio();   // perfis de clock
+  if (todos || strcmp(key, "9") == 0) armazenamento_solicitar_relatorio(); // desgaste e tempos da flash
+  if (todos || strcmp(key, "0") == 0) telemetria_solicitar_relatorio();   // histórico de preparos
+  if (todos || strcmp(key, "+") == 0) servidor_status_solicitar_relatorio(); // servidor de status
 }
 
 // -------------------------------------------------------------------------------------------------- //
 // Função de callback para processar comandos do controle IR
-// Mapeia botões do controle para ações específicas, como iniciar preparo, definir horário, etc
+// Roda na IRQ de entrega do IR (controle_ir.c), logo depois da IRQ do GPIO: apenas guarda a tecla para
+// as rotinas que a leem diretamente (agendamento, reabastecimento) e enfileira o evento correspondente
+// para a máquina de estados
 void callback_ir(uint16_t address, uint16_t command, int type) {
   const char* key = get_key_name(command);
+  latencia_marco(MARCO_CALLBACK);
+  pilha_marcar();
+  monitor_entrar(TRECHO_CALLBACK_IR);
+  energia_tecla(); // acende o display se a máquina estava ociosa
+
+  // Tecla que completa a seleção de relatório; a repetição de quem segura o TEST não conta
+  if (selecionando_relatorio && type != REPEAT) {
+    selecionando_relatorio = false;
+    solicitar_relatorio(key);
+    monitor_sair(TRECHO_CALLBACK_IR);
+    return;
+  }
 
   // Verifica se uma tecla válida foi pressionada
   if (strlen(key) > 0) {
@@ -118,31 +236,19 @@ void callback_ir(uint16_t address, uint16_t command, int type) {
 
   if (strcmp(key, "PLAY") == 0) {
     play_apertado = true; // Marca que o PLAY foi pressionado
-  } else if (estado_atual == ESTADO_QUANTIDADE_XICARAS) {
-    if (strcmp(key, "0") == 0) { // se o 0 for pressionado retorna ao ínicio
-      lcd_clear();
-      exibir_tela_inicial();
-      estado_atual = ESTADO_TELA_INICIAL; // Retorna à tela inicial
-    } else if (strcmp(key, "1") == 0 || strcmp(key, "2") == 0 ||
-               strcmp(key, "3") == 0 || strcmp(key, "4") == 0 || strcmp(key, "5") == 0) {
-      xicaras = key[0] - '0'; // Converte a tecla para número de xícaras desejadas
-      estado_atual = ESTADO_QUANDO_PREPARAR;
-    } else {
-      lcd_clear();
-      lcd_set_cursor(0, 0);
-      lcd_print("INVALID KEY"); // caso o usuário aperte uma tecla diferente
-      lcd_set_cursor(2, 0);
-      lcd_print("PLEASE SELECT 1 TO 5");
-      sleep_ms(1000);
-    }
-  } else if (estado_atual == ESTADO_QUANDO_PREPARAR) { // escolha do usuário de preparar logo ou agendar
-    if (strcmp(key, "1") == 0) {
-      preparo_agora = true;
-      estado_atual = ESTADO_PREPARANDO;
-    } else if (strcmp(key, "2") == 0)
-    {
-      preparo_agora = false;
-      estado_atual = ESTADO_PROGRAMANDO;
+    estado_postar_evento(EVENTO_PLAY);
+  } else if (strcmp(key, "TEST") == 0) {
+    if (type != REPEAT) {
+      selecionando_relatorio = true;
+      LOG("TEST 1 gravacao 2 rastreio 3 latencia 4 perfil 5 pilhas 6 prazos 7 energia 8 clock 9 flash "
+          "0 historico + http TEST todos\n");
     }
+  } else if (strcmp(key, "MENU") == 0) {
+    estado_postar_evento(EVENTO_MENU);
+  } else if (strlen(key) == 1 && isdigit((unsigned char)key[0])) {
+    estado_postar_evento(EVENTO_TECLA_0 + (key[0] - '0'));
+  } else if (strlen(key) > 0) {
+    estado_postar_evento(EVENTO_OUTRA_TECLA);
   }
+  monitor_sair(TRECHO_CALLBACK_IR);
 }
\ No newline at end of file
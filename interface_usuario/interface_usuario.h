@@ -5,6 +5,7 @@
 #define INTERFACE_USUARIO_H
 
 #include <stdint.h>  // Para tipos de dados padrão (uint8_t)
+#include <stdbool.h>
 
 // Funções para Controle de Interface
 void exibir_tela_inicial();           // Exibe a tela inicial com status do sistema (água, grãos, saudação)
@@ -12,8 +13,8 @@ void perguntar_quantidade_xicaras();  // Pergunta ao usuário a quantidade de x
 void perguntar_quando_preparar();     // Pergunta se o preparo deve ser imediato ou agendado
 
 // Funções para Monitoramento
-void exibir_temperatura_umidade_ambiente(); // Exibe temperatura e umidade do sensor DHT22
-void exibir_relogio();                      // Exibe o horário atual lido do RTC
+void atualizar_tela_inicial();        // Relógio, estoque e ambiente; reescreve só os campos alterados
+bool ambiente_atual(int16_t *temperatura_x10, int16_t *umidade_x10); // última leitura do DHT22; false se inválida
 
 // Função de callback para processar comandos do controle IR
 void callback_ir(uint16_t address, uint16_t command, int type);
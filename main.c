@@ -16,17 +16,49 @@
 #include "interface_usuario.h"
 #include "processos_internos.h"
 #include "estado.h"
+#include "gravador.h"
+#include "rastreio.h"
+#include "latencia.h"
+#include "perfil.h"
+#include "pilha.h"
+#include "monitor.h"
+#include "log_adiado.h"
+#include "placa.h"
+#include "energia.h"
+#include "frequencia.h"
+#include "retomada.h"
+#include "armazenamento.h"
+#include "telemetria.h"
+#include "servidor_status.h"
 
-#define IR_SENSOR_GPIO_PIN 1 // controle remoto IR para o usuário enviar comandos para a máquina
-
+// Os alvos de benchmark (pasta benchmark/) têm sua própria função principal
+#if !defined(COFFEETIME_BENCH_EMULADOR) && !defined(COFFEETIME_BENCH_PLACA)
 int main() {
 
-  setup_machine();
-  init_ir_irq_receiver(IR_SENSOR_GPIO_PIN, &callback_ir);
+  setup_machine();                     // display e controle IR primeiro
+  // Um preparo interrompido por um reinício continua da última etapa concluída
+  estado_iniciar(retomada_iniciar() ? ESTADO_PREPARANDO : ESTADO_TELA_INICIAL);
+  inicializacao_marcar_interativo();   // tempo do reset até aceitar o PLAY
 
   while (true) {
-    gerenciar_estado();  // Delegação do controle para o estado atual
-    sleep_ms(200);
+    frequencia_ajustar();  // clock do sistema para o passo: alto com evento, baixo nas telas de espera
+    gerenciar_estado();  // eventos pendentes e passo periódico do estado atual
+    inicializacao_servico(); // periféricos adiados do boot (só na primeira volta)
+    gravador_servico();  // descarga da gravação pela USB, quando solicitada
+    rastreio_servico();  // descarga do rastreamento de eventos, quando solicitada
+    latencia_servico();  // relatório/tela de latência do controle IR, quando solicitados
+    perfil_servico();    // descarga do perfil de CPU, quando solicitada
+    pilha_servico();     // marcas d'água das pilhas: relatório e aviso de margem
+    monitor_servico();   // relatório de prazos, quando solicitado
+    log_adiado_servico(); // envia o log adiado pela USB
+    energia_servico();   // relatório dos estados de energia, quando solicitado
+    frequencia_servico(); // relatório dos perfis de clock, quando solicitado
+    armazenamento_servico(); // gravações em lote na flash e apagamento antecipado do próximo setor
+    telemetria_servico();    // histórico: descarga das páginas e apagamento antecipado
+    servidor_status_servico(); // foto do estado para o servidor HTTP e conexão Wi-Fi
+    monitor_ciclo();     // o loop principal segue girando (mantém o watchdog alimentado)
+    energia_aguardar_evento(200); // próximo passo em 200 ms ou com uma tecla; ocioso, dorme até ela
   }
   return 0;
-}
\ No newline at end of file
+}
+#endif
\ No newline at end of file
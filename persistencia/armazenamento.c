@@ -0,0 +1,304 @@
+// armazenamento.c
+// Registro chave-valor em log nos últimos setores da flash, com CRC, compactação e rodízio de setores
+
+#include "armazenamento.h"
+#include <stdio.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hardware/flash.h"
+#include "hardware/sync.h"
+#include "estado.h"
+#include "placa.h"
+
+#define MARCA_SETOR 0x564B5443u // "CTKV"
+#define GERACAO_LIVRE 0xFFFFFFFFu
+#define LIVRE 0xFF
+#define TAMANHO_REGISTRO 16
+#define REGISTROS_POR_SETOR (FLASH_SECTOR_SIZE / TAMANHO_REGISTRO) // o primeiro é o cabeçalho
+#define REGISTROS_POR_PAGINA (FLASH_PAGE_SIZE / TAMANHO_REGISTRO)
+
+typedef struct {
+  uint8_t chave;     // LIVRE: fim do log
+  uint8_t tamanho;
+  uint16_t crc;      // CRC-16 da chave, do tamanho e do valor
+  uint8_t valor[ARMAZENAMENTO_VALOR_MAX];
+} Registro;
+
+// Gravado em duas programações: marca e desgaste logo após o apagamento; geração e CRC só depois do
+// instantâneo, quando o setor passa a valer
+typedef struct {
+  uint32_t marca;
+  uint32_t apagamentos; // desgaste do setor
+  uint32_t geracao;     // cresce a cada setor aberto: o maior é o ativo
+  uint16_t reservado;
+  uint16_t crc;
+} Cabecalho;
+
+_Static_assert(sizeof(Registro) == TAMANHO_REGISTRO, "registro de 16 bytes");
+_Static_assert(sizeof(Cabecalho) == TAMANHO_REGISTRO, "cabecalho do tamanho de um registro");
+
+// Valor atual de cada chave (o que vale na flash mais as gravações pendentes)
+static struct {
+  uint8_t tamanho;
+  bool valida;
+  bool pendente;
+  uint8_t valor[ARMAZENAMENTO_VALOR_MAX];
+} chaves[TOTAL_CHAVES];
+
+static int setor_ativo = -1;        // -1: nenhum setor válido (flash nova)
+static uint32_t geracao = 0;
+static uint16_t proximo = 1;        // próximo registro livre do setor ativo
+static bool proximo_preparado = false; // setor seguinte já apagado, com marca e desgaste
+static uint32_t apagamentos[FLASH_ARMAZENAMENTO_SETORES];
+static uint64_t pendente_desde_us = 0;
+static uint8_t pagina[FLASH_PAGE_SIZE];
+
+// Estatísticas desde o boot
+static uint32_t registros_gravados = 0;
+static uint32_t registros_copiados = 0; // instantâneos da compactação
+static uint32_t paginas_programadas = 0;
+static uint32_t apagamentos_boot = 0;
+static uint32_t compactacoes = 0;
+static uint32_t corrompidos = 0;        // registros com CRC inválido encontrados no boot
+static uint32_t programa_max_us = 0;
+static uint64_t programa_soma_us = 0;
+static uint32_t apagamento_max_us = 0;
+static uint32_t recuperacao_us = 0;
+
+static volatile bool relatorio_pendente = false;
+
+static uint32_t deslocamento_setor(int setor) {
+  return FLASH_ARMAZENAMENTO_INICIO + setor * FLASH_SECTOR_SIZE;
+}
+
+static const void *na_flash(int setor, int indice) {
+  return (const void *)(uintptr_t)(XIP_BASE + deslocamento_setor(setor) + indice * TAMANHO_REGISTRO);
+}
+
+static uint16_t crc16(const void *dados, size_t total, uint16_t crc) {
+  const uint8_t *p = dados;
+  for (size_t i = 0; i < total; i++) {
+    crc ^= (uint16_t)p[i] << 8;
+    for (int b = 0; b < 8; b++) {
+      crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+  }
+  return crc;
+}
+
+static uint16_t crc_registro(const Registro *r) {
+  return crc16(r->valor, r->tamanho, crc16(r, 2, 0xFFFF));
+}
+
+static uint16_t crc_cabecalho(const Cabecalho *c) {
+  return crc16(c, 12, 0xFFFF);
+}
+
+// -------------------------------------------------------------------------------------------------- //
+// Acesso à flash
+
+// Programa a página preparada em `pagina` (bytes 0xFF não alteram a flash). As interrupções ficam
+// desligadas só durante a programação: com o XIP parado, nenhum tratador pode rodar da flash
+static void programar_pagina(uint32_t deslocamento) {
+  uint64_t inicio = time_us_64();
+  uint32_t irq = save_and_disable_interrupts();
+  flash_range_program(deslocamento, pagina, FLASH_PAGE_SIZE);
+  restore_interrupts(irq);
+  uint32_t duracao = (uint32_t)(time_us_64() - inicio);
+  programa_soma_us += duracao;
+  if (duracao > programa_max_us) programa_max_us = duracao;
+  paginas_programadas++;
+}
+
+// Apaga o setor e grava a marca com o novo desgaste; a geração continua livre até a ativação
+static void preparar_setor(int setor) {
+  uint64_t inicio = time_us_64();
+  uint32_t irq = save_and_disable_interrupts();
+  flash_range_erase(deslocamento_setor(setor), FLASH_SECTOR_SIZE);
+  restore_interrupts(irq);
+  uint32_t duracao = (uint32_t)(time_us_64() - inicio);
+  if (duracao > apagamento_max_us) apagamento_max_us = duracao;
+  apagamentos[setor]++;
+  apagamentos_boot++;
+
+  memset(pagina, 0xFF, sizeof(pagina));
+  Cabecalho *c = (Cabecalho *)pagina;
+  c->marca = MARCA_SETOR;
+  c->apagamentos = apagamentos[setor];
+  programar_pagina(deslocamento_setor(setor));
+}
+
+static bool setor_preparado(int setor) {
+  const Cabecalho *c = na_flash(setor, 0);
+  if (c->marca != MARCA_SETOR || c->geracao != GERACAO_LIVRE) return false;
+  const uint8_t *registros = na_flash(setor, 1);
+  for (int i = 0; i < FLASH_SECTOR_SIZE - TAMANHO_REGISTRO; i++) { // apagamento interrompido?
+    if (registros[i] != 0xFF) return false;
+  }
+  return true;
+}
+
+// Acrescenta ao setor, a partir de *posicao, um registro por chave válida (todas: instantâneo da
+// compactação; só as pendentes: gravação normal), programando cada página uma vez
+static void anexar(int setor, uint16_t *posicao, bool todas) {
+  int pagina_atual = -1;
+  for (int k = 0; k < TOTAL_CHAVES; k++) {
+    if (!chaves[k].valida || !(todas || chaves[k].pendente)) continue;
+    int p = *posicao / REGISTROS_POR_PAGINA;
+    if (p != pagina_atual) {
+      if (pagina_atual >= 0) programar_pagina(deslocamento_setor(setor) + pagina_atual * FLASH_PAGE_SIZE);
+      memset(pagina, 0xFF, sizeof(pagina));
+      pagina_atual = p;
+    }
+    Registro *r = (Registro *)&pagina[(*posicao % REGISTROS_POR_PAGINA) * TAMANHO_REGISTRO];
+    r->chave = k;
+    r->tamanho = chaves[k].tamanho;
+    memcpy(r->valor, chaves[k].valor, chaves[k].tamanho);
+    r->crc = crc_registro(r);
+    chaves[k].pendente = false;
+    registros_gravados++;
+    (*posicao)++;
+  }
+  if (pagina_atual >= 0) programar_pagina(deslocamento_setor(setor) + pagina_atual * FLASH_PAGE_SIZE);
+}
+
+// Compactação: o próximo setor do anel recebe todas as chaves e só então ganha a geração; até lá, o
+// setor anterior continua valendo (uma queda no meio não perde nada)
+static void abrir_proximo_setor(void) {
+  int novo = setor_ativo < 0 ? 0 : (setor_ativo + 1) % FLASH_ARMAZENAMENTO_SETORES;
+  if (!proximo_preparado && !setor_preparado(novo)) preparar_setor(novo);
+
+  uint16_t posicao = 1;
+  uint32_t antes = registros_gravados;
+  for (int k = 0; k < TOTAL_CHAVES; k++) antes += chaves[k].pendente; // as pendentes não são cópias
+  anexar(novo, &posicao, true);
+  if (setor_ativo >= 0) registros_copiados += registros_gravados - antes;
+
+  memset(pagina, 0xFF, sizeof(pagina));
+  Cabecalho c = {MARCA_SETOR, apagamentos[novo], geracao + 1, 0xFFFF, 0};
+  c.crc = crc_cabecalho(&c);
+  Cabecalho *ativacao = (Cabecalho *)pagina; // marca e desgaste já estão na flash
+  ativacao->geracao = c.geracao;
+  ativacao->reservado = c.reservado;
+  ativacao->crc = c.crc;
+  programar_pagina(deslocamento_setor(novo));
+
+  setor_ativo = novo;
+  geracao = c.geracao;
+  proximo = posicao;
+  proximo_preparado = false;
+  compactacoes++;
+}
+
+// -------------------------------------------------------------------------------------------------- //
+// Interface
+
+// Só o cabeçalho de cada setor e os registros do setor ativo são lidos (pelo XIP, sem cópia)
+void armazenamento_iniciar(void) {
+  uint64_t inicio = time_us_64();
+  for (int s = 0; s < FLASH_ARMAZENAMENTO_SETORES; s++) {
+    const Cabecalho *c = na_flash(s, 0);
+    if (c->marca != MARCA_SETOR) continue; // nunca usado ou apagamento interrompido
+    apagamentos[s] = c->apagamentos;
+    if (c->geracao == GERACAO_LIVRE || c->crc != crc_cabecalho(c)) continue;
+    if (setor_ativo < 0 || c->geracao > geracao) {
+      setor_ativo = s;
+      geracao = c->geracao;
+    }
+  }
+
+  if (setor_ativo >= 0) {
+    for (proximo = 1; proximo < REGISTROS_POR_SETOR; proximo++) {
+      const Registro *r = na_flash(setor_ativo, proximo);
+      if (r->chave == LIVRE) break; // os registros são acrescentados em ordem
+      if (r->chave >= TOTAL_CHAVES || r->tamanho > ARMAZENAMENTO_VALOR_MAX || r->crc != crc_registro(r)) {
+        corrompidos++; // programação interrompida: o valor anterior continua valendo
+        continue;
+      }
+      chaves[r->chave].valida = true;
+      chaves[r->chave].tamanho = r->tamanho;
+      memcpy(chaves[r->chave].valor, r->valor, r->tamanho);
+    }
+    proximo_preparado = setor_preparado((setor_ativo + 1) % FLASH_ARMAZENAMENTO_SETORES);
+  }
+  recuperacao_us = (uint32_t)(time_us_64() - inicio);
+}
+
+bool armazenamento_ler(ChaveArmazenamento chave, void *valor, uint8_t tamanho) {
+  if (!chaves[chave].valida || chaves[chave].tamanho != tamanho) return false;
+  memcpy(valor, chaves[chave].valor, tamanho);
+  return true;
+}
+
+void armazenamento_gravar(ChaveArmazenamento chave, const void *valor, uint8_t tamanho) {
+  if (tamanho > ARMAZENAMENTO_VALOR_MAX) return;
+  if (chaves[chave].valida && chaves[chave].tamanho == tamanho && memcmp(chaves[chave].valor, valor, tamanho) == 0) {
+    return; // sem mudança: nenhum registro
+  }
+  bool havia_pendente = false;
+  for (int k = 0; k < TOTAL_CHAVES; k++) havia_pendente |= chaves[k].pendente;
+  if (!havia_pendente) pendente_desde_us = time_us_64();
+
+  memcpy(chaves[chave].valor, valor, tamanho);
+  chaves[chave].tamanho = tamanho;
+  chaves[chave].valida = true;
+  chaves[chave].pendente = true;
+}
+
+void armazenamento_descarregar(void) {
+  int pendentes = 0;
+  for (int k = 0; k < TOTAL_CHAVES; k++) pendentes += chaves[k].pendente;
+  if (pendentes == 0) return;
+
+  if (setor_ativo < 0 || proximo + pendentes > REGISTROS_POR_SETOR) {
+    abrir_proximo_setor(); // o instantâneo já leva as pendentes
+  } else {
+    anexar(setor_ativo, &proximo, false);
+  }
+}
+
+void armazenamento_solicitar_relatorio(void) {
+  relatorio_pendente = true;
+}
+
+static void imprimir_relatorio() {
+  uint32_t gravados = registros_gravados - registros_copiados; // sem as cópias da compactação
+  printf("ARMZ INICIO setor=%d geracao=%lu ocupacao=%u/%u recuperacao=%lu us corrompidos=%lu\n",
+         setor_ativo, (unsigned long)geracao, proximo - 1, REGISTROS_POR_SETOR - 1,
+         (unsigned long)recuperacao_us, (unsigned long)corrompidos);
+  for (int s = 0; s < FLASH_ARMAZENAMENTO_SETORES; s++) {
+    printf("ARMZ setor %d apagamentos=%lu\n", s, (unsigned long)apagamentos[s]);
+  }
+  printf("ARMZ registros=%lu copiados=%lu paginas=%lu apagamentos=%lu compactacoes=%lu\n",
+         (unsigned long)gravados, (unsigned long)registros_copiados, (unsigned long)paginas_programadas,
+         (unsigned long)apagamentos_boot, (unsigned long)compactacoes);
+  if (apagamentos_boot) {
+    printf("ARMZ registros por apagamento=%lu\n", (unsigned long)(gravados / apagamentos_boot));
+  } else {
+    printf("ARMZ registros por apagamento=-- (capacidade %u por setor)\n", REGISTROS_POR_SETOR - 1 - TOTAL_CHAVES);
+  }
+  printf("ARMZ programacao media=%lu max=%lu us, apagamento max=%lu us\n",
+         (unsigned long)(paginas_programadas ? programa_soma_us / paginas_programadas : 0),
+         (unsigned long)programa_max_us, (unsigned long)apagamento_max_us);
+  printf("ARMZ FIM\n");
+}
+
+void armazenamento_servico(void) {
+  bool pendente = false;
+  for (int k = 0; k < TOTAL_CHAVES; k++) pendente |= chaves[k].pendente;
+  uint64_t agora = time_us_64();
+
+  if (pendente && agora - pendente_desde_us >= ARMAZENAMENTO_ATRASO_MS * 1000ull) {
+    armazenamento_descarregar();
+  } else if (setor_ativo >= 0 && !proximo_preparado &&
+             agora - estado_ultimo_evento_us() >= ARMAZENAMENTO_QUIETO_MS * 1000ull) {
+    // Apagamento antecipado (dezenas de ms sem interrupções), fora de qualquer gravação e longe das teclas
+    preparar_setor((setor_ativo + 1) % FLASH_ARMAZENAMENTO_SETORES);
+    proximo_preparado = true;
+  }
+
+  if (relatorio_pendente) {
+    relatorio_pendente = false;
+    imprimir_relatorio();
+  }
+}
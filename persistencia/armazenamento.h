@@ -0,0 +1,44 @@
+// armazenamento.h
+// Registro chave-valor persistente na flash, estruturado em log: cada gravação acrescenta um registro
+// de 16 bytes (chave, tamanho, CRC-16 e valor) ao setor ativo, sem reescrever os anteriores; no boot,
+// o último registro válido de cada chave vale. Os FLASH_ARMAZENAMENTO_SETORES setores do fim da flash
+// (placa.h) formam um anel: quando o setor ativo enche, o próximo recebe um instantâneo das chaves
+// (compactação) e passa a ser o ativo, de modo que todos os setores são apagados na mesma proporção.
+// As gravações ficam na RAM e vão para a flash em lote, ARMAZENAMENTO_ATRASO_MS depois da primeira
+// (várias gravações da mesma chave viram um registro só), uma página por vez. As interrupções ficam
+// desligadas só durante cada programação de página (o XIP para enquanto a flash grava); o apagamento
+// do próximo setor é feito antes de ser necessário, no loop principal, sem teclas recentes.
+// A tecla TEST envia a ocupação, o desgaste por setor, os tempos de programação e de apagamento e a
+// média de registros por apagamento.
+
+#ifndef ARMAZENAMENTO_H
+#define ARMAZENAMENTO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef ARMAZENAMENTO_ATRASO_MS
+#define ARMAZENAMENTO_ATRASO_MS 5000 // junta as gravações próximas em uma programação
+#endif
+
+#ifndef ARMAZENAMENTO_QUIETO_MS
+#define ARMAZENAMENTO_QUIETO_MS 2000 // sem eventos por esse tempo: pode apagar o próximo setor
+#endif
+
+#define ARMAZENAMENTO_VALOR_MAX 12   // bytes de valor por registro
+
+// Chaves gravadas (a ordem faz parte do formato na flash: acrescente novas no fim)
+typedef enum {
+  CHAVE_AGUA_ML,   // float: água no reservatório
+  CHAVE_GRAOS_G,   // float: grãos no reservatório
+  TOTAL_CHAVES
+} ChaveArmazenamento;
+
+void armazenamento_iniciar(void);  // recupera o setor ativo (boot)
+bool armazenamento_ler(ChaveArmazenamento chave, void *valor, uint8_t tamanho); // false: chave nunca gravada
+void armazenamento_gravar(ChaveArmazenamento chave, const void *valor, uint8_t tamanho); // só na RAM
+void armazenamento_descarregar(void);         // programa agora as gravações pendentes
+void armazenamento_solicitar_relatorio(void); // relatório pela USB (seguro em IRQ)
+void armazenamento_servico(void);             // descarga em lote, apagamento antecipado e relatório
+
+#endif // ARMAZENAMENTO_H
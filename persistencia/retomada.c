@@ -0,0 +1,116 @@
+// retomada.c
+// Ponto de retomada do preparo nos registradores de rascunho do watchdog
+
+#include "retomada.h"
+#include "pico/stdlib.h"
+#include "hardware/watchdog.h"
+#include "hardware/structs/watchdog.h"
+#include "armazenamento.h"
+#include "log_adiado.h"
+
+// scratch[0]: marca (16 bits) | verificador (8) | etapas concluídas (4) | tentativas (2) | 00
+// scratch[1]: xícaras (3) | pressão (7) | temperatura em décimos (11) | água por xícara (11)
+// scratch[2]: água no reservatório em ml (16) | grãos em g (16)
+// O scratch[3] é do monitor e os scratch[4..7] do SDK (watchdog_reboot)
+#define MARCA 0xCAFEu
+#define SEM_PEDIDO 0xF // só o estoque registrado
+
+extern float agua_ml;
+extern float graos_g;
+
+static PedidoPreparo pedido;
+static uint8_t concluidas = SEM_PEDIDO;
+static uint8_t tentativas = 0;
+static bool pendente = false;
+
+// Dobra as três palavras em 8 bits; uma escrita interrompida entre os registradores não passa
+static uint8_t verificador(uint32_t controle, uint32_t parametros, uint32_t estoque) {
+  uint32_t x = (controle & 0xFF) ^ parametros ^ ((estoque << 13) | (estoque >> 19));
+  x ^= x >> 16;
+  x ^= x >> 8;
+  return (uint8_t)x;
+}
+
+static uint16_t saturar16(float valor) {
+  if (valor <= 0) return 0;
+  return valor >= UINT16_MAX ? UINT16_MAX : (uint16_t)(valor + 0.5f);
+}
+
+static void gravar(void) {
+  uint32_t parametros = (uint32_t)(pedido.xicaras & 0x7) << 29 | (uint32_t)(pedido.pressao & 0x7F) << 22 |
+                        (uint32_t)(pedido.temperatura_dc & 0x7FF) << 11 | (pedido.agua_por_xicara & 0x7FF);
+  uint32_t estoque = (uint32_t)saturar16(agua_ml) << 16 | saturar16(graos_g);
+  uint32_t controle = (uint32_t)concluidas << 4 | (uint32_t)tentativas << 2;
+
+  watchdog_hw->scratch[1] = parametros;
+  watchdog_hw->scratch[2] = estoque;
+  watchdog_hw->scratch[0] = MARCA << 16 | (uint32_t)verificador(controle, parametros, estoque) << 8 | controle;
+
+  // O estoque também vai para a flash (em lote, só quando muda) para sobreviver à falta de energia
+  armazenamento_gravar(CHAVE_AGUA_ML, &agua_ml, sizeof(agua_ml));
+  armazenamento_gravar(CHAVE_GRAOS_G, &graos_g, sizeof(graos_g));
+}
+
+bool retomada_iniciar(void) {
+  uint32_t controle = watchdog_hw->scratch[0];
+  uint32_t parametros = watchdog_hw->scratch[1];
+  uint32_t estoque = watchdog_hw->scratch[2];
+  if (controle >> 16 != MARCA || ((controle >> 8) & 0xFF) != verificador(controle, parametros, estoque)) {
+    // Ligada agora (rascunho zerado) ou registro corrompido: estoque gravado na flash, se houver
+    armazenamento_ler(CHAVE_AGUA_ML, &agua_ml, sizeof(agua_ml));
+    armazenamento_ler(CHAVE_GRAOS_G, &graos_g, sizeof(graos_g));
+    return false;
+  }
+
+  agua_ml = estoque >> 16;
+  graos_g = estoque & 0xFFFF;
+  concluidas = (controle >> 4) & 0xF;
+  tentativas = (controle >> 2) & 0x3;
+  if (concluidas == SEM_PEDIDO) return false;
+
+  pedido.xicaras = parametros >> 29;
+  pedido.pressao = (parametros >> 22) & 0x7F;
+  pedido.temperatura_dc = (parametros >> 11) & 0x7FF;
+  pedido.agua_por_xicara = parametros & 0x7FF;
+
+  if (++tentativas >= RETOMADA_MAX_TENTATIVAS) {
+    LOG("RET pedido abandonado: %u reinicios apos a etapa %u\n", tentativas, concluidas);
+    retomada_encerrar();
+    return false;
+  }
+  gravar(); // conta a tentativa antes de voltar a mover os atuadores
+  LOG("RET retomando %u xicara(s) apos %u etapa(s) concluida(s)\n", pedido.xicaras, concluidas);
+  pendente = true;
+  return true;
+}
+
+bool retomada_pendente(PedidoPreparo *saida, EtapaPreparo *proxima) {
+  if (!pendente) return false;
+  pendente = false;
+  *saida = pedido;
+  *proxima = (EtapaPreparo)concluidas;
+  return true;
+}
+
+void retomada_registrar_pedido(const PedidoPreparo *novo) {
+  pedido = *novo;
+  concluidas = 0;
+  tentativas = 0;
+  gravar();
+}
+
+void retomada_concluir_etapa(EtapaPreparo etapa) {
+  concluidas = etapa + 1;
+  tentativas = 0;
+  gravar();
+}
+
+void retomada_encerrar(void) {
+  concluidas = SEM_PEDIDO;
+  tentativas = 0;
+  gravar();
+}
+
+int retomada_etapas_concluidas(void) {
+  return concluidas == SEM_PEDIDO ? -1 : concluidas;
+}
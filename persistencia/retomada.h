@@ -0,0 +1,36 @@
+// retomada.h
+// Ponto de retomada do preparo: a cada etapa concluída, o pedido (xícaras, pressão, temperatura e água
+// por xícara), a última etapa concluída e o estoque de água e grãos vão para os registradores de rascunho
+// do watchdog (scratch[0..2]), que sobrevivem aos reinícios pelo watchdog e por software, mas não à
+// falta de energia. No boot, um pedido interrompido é retomado a partir da etapa seguinte à última
+// concluída (servos, moagem e extração não se repetem) e o estoque volta ao valor registrado.
+// Depois de uma falta de energia, o estoque vem do registro na flash (armazenamento.h).
+// Um pedido que reinicia a placa RETOMADA_MAX_TENTATIVAS vezes na mesma etapa é abandonado.
+
+#ifndef RETOMADA_H
+#define RETOMADA_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "processos_internos.h"
+
+#ifndef RETOMADA_MAX_TENTATIVAS
+#define RETOMADA_MAX_TENTATIVAS 3
+#endif
+
+// Parâmetros do pedido, lidos uma vez no início do preparo
+typedef struct {
+  uint8_t xicaras;          // 1 a 5
+  uint8_t pressao;          // 0 a 100 %
+  uint16_t temperatura_dc;  // décimos de °C (850 a 950)
+  uint16_t agua_por_xicara; // ml (50 a 200)
+} PedidoPreparo;
+
+bool retomada_iniciar(void);                          // no boot: restaura o estoque; true com pedido a retomar
+bool retomada_pendente(PedidoPreparo *pedido, EtapaPreparo *proxima); // consome o pedido interrompido
+void retomada_registrar_pedido(const PedidoPreparo *pedido); // antes da primeira etapa
+void retomada_concluir_etapa(EtapaPreparo etapa);     // etapa concluída, com o estoque atual
+void retomada_encerrar(void);                         // preparo concluído: guarda só o estoque
+int retomada_etapas_concluidas(void);                 // do preparo em andamento; -1 sem preparo
+
+#endif // RETOMADA_H
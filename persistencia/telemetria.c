@@ -0,0 +1,649 @@
+// telemetria.c
+// Histórico compactado de preparos e do ambiente em dois anéis de setores da flash
+
+#include "telemetria.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hardware/flash.h"
+#include "hardware/sync.h"
+#include "sensores.h"
+#include "estado.h"
+#include "placa.h"
+
+#define MARCA_PAGINA 0x4C455443u // "CTEL"
+#define PAGINAS_POR_SETOR (FLASH_SECTOR_SIZE / FLASH_PAGE_SIZE)
+#define TAMANHO_MAX_REGISTRO 40  // tipo + até 7 campos de 5 bytes
+#define MAX_DIAS_DOBRA 16        // dias acumulados na RAM ao resumir um setor
+#define MINUTOS_POR_DIA 1440
+
+typedef enum {
+  TIPO_PREPARO = 1,
+  TIPO_AMBIENTE = 2,
+  TIPO_RESUMO = 3,  // um dia (ou parte dele) de um setor resumido
+  TIPO_DOBRA = 4,   // páginas detalhadas abaixo de `seq` já estão nos resumos
+  TIPO_FIM = 0xFF,  // flash apagada: fim da página
+} TipoRegistro;
+
+typedef struct {
+  uint32_t marca;
+  uint32_t seq;         // cresce a cada página aberta no anel
+  uint32_t minuto_base; // referência do primeiro registro (minutos desde 01/01/2000)
+} CabecalhoPagina;
+
+// Registro decodificado (só os campos do tipo valem)
+typedef struct {
+  uint8_t tipo;
+  uint32_t minuto;           // preparo e ambiente
+  uint32_t dia;              // resumo
+  uint32_t seq;              // dobra
+  uint16_t xicaras;          // preparo; resumo: total do dia
+  uint16_t pressao;          // preparo
+  uint16_t agua_por_xicara;  // preparo
+  uint16_t preparos;         // resumo
+  uint16_t amostras;         // resumo: médias do ambiente no dia
+  uint32_t duracao;          // preparo: décimos de s; resumo: soma em s
+  int16_t temperatura_dc;    // preparo: água; ambiente e resumo: ambiente
+  int16_t umidade_dc;        // ambiente e resumo
+} Registro;
+
+// Referências dos deltas, zeradas a cada página
+typedef struct {
+  uint32_t minuto;
+  Registro preparo, ambiente, resumo;
+} Codificador;
+
+typedef struct {
+  const char *nome;
+  uint32_t inicio;       // deslocamento do primeiro setor na flash
+  uint16_t setores;
+  bool vazio;            // nenhuma página gravada ainda
+  bool aberta;           // a página da cabeça está na RAM
+  bool proximo_apagado;  // setor seguinte ao da cabeça já apagado
+  uint32_t seq;          // página da cabeça
+  uint16_t usado;        // bytes da página na RAM
+  uint16_t programado;   // bytes dela já programados na flash
+  uint8_t pagina[FLASH_PAGE_SIZE];
+  Codificador cod;
+} Anel;
+
+static Anel detalhe = {"detalhe", FLASH_TELEMETRIA_INICIO,
+                       FLASH_TELEMETRIA_SETORES - TELEMETRIA_SETORES_DIARIO, true};
+static Anel diario = {"diario",
+                      FLASH_TELEMETRIA_INICIO + (FLASH_TELEMETRIA_SETORES - TELEMETRIA_SETORES_DIARIO) * FLASH_SECTOR_SIZE,
+                      TELEMETRIA_SETORES_DIARIO, true};
+
+static uint32_t seq_minima = 0;  // páginas detalhadas com seq menor já foram resumidas
+static TelemetriaObservador observador = NULL;
+static bool iniciada = false;
+static bool pendente = false;
+static uint64_t pendente_desde_us = 0;
+static uint8_t imagem[FLASH_PAGE_SIZE];
+
+// Média do ambiente do período em andamento
+static struct {
+  int32_t soma_temperatura, soma_umidade;
+  uint16_t leituras;
+  uint32_t inicio_ms;
+} ambiente;
+
+// Estatísticas
+static uint32_t registros_gravados = 0;
+static uint32_t bytes_gravados = 0;
+static uint32_t apagamentos = 0;
+static uint32_t dobras = 0;
+static volatile bool relatorio_pendente = false;
+
+// -------------------------------------------------------------------------------------------------- //
+// Relógio
+
+static uint8_t bcd(uint8_t v) {
+  return (v & 0x0F) + (v >> 4) * 10;
+}
+
+static uint32_t dias_desde_2000(uint32_t ano, uint32_t mes, uint32_t dia) {
+  static const uint16_t antes_do_mes[12] = {0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334};
+  if (mes < 1 || mes > 12 || dia < 1) return 0; // RTC sem data
+  uint32_t dias = (ano - 2000) * 365 + (ano - 1997) / 4 + antes_do_mes[mes - 1] + dia - 1;
+  if (mes > 2 && ano % 4 == 0) dias++;
+  return dias;
+}
+
+uint32_t telemetria_minuto_atual(void) {
+  uint8_t rtc_data[7];
+  rtc_read(I2C_PORT, SDA_PIN, SCL_PIN, rtc_data);
+  uint32_t dias = dias_desde_2000(2000 + bcd(rtc_data[6]), bcd(rtc_data[5] & 0x1F), bcd(rtc_data[4] & 0x3F));
+  return dias * MINUTOS_POR_DIA + bcd(rtc_data[2] & 0x3F) * 60 + bcd(rtc_data[1] & 0x7F);
+}
+
+uint32_t telemetria_dia_atual(void) {
+  return telemetria_minuto_atual() / MINUTOS_POR_DIA;
+}
+
+// -------------------------------------------------------------------------------------------------- //
+// Codificação: varint (7 bits por byte) das diferenças em zigue-zague
+
+static uint8_t *escrever_varint(uint8_t *p, uint32_t v) {
+  while (v >= 0x80) {
+    *p++ = (uint8_t)v | 0x80;
+    v >>= 7;
+  }
+  *p++ = (uint8_t)v;
+  return p;
+}
+
+static uint8_t *escrever_delta(uint8_t *p, int32_t novo, int32_t anterior) {
+  int32_t d = novo - anterior;
+  return escrever_varint(p, ((uint32_t)d << 1) ^ (uint32_t)(d >> 31));
+}
+
+static bool ler_varint(const uint8_t **p, const uint8_t *fim, uint32_t *v) {
+  *v = 0;
+  for (int deslocamento = 0; deslocamento < 35 && *p < fim; deslocamento += 7) {
+    uint8_t b = *(*p)++;
+    *v |= (uint32_t)(b & 0x7F) << deslocamento;
+    if (!(b & 0x80)) return true;
+  }
+  return false; // página truncada (programação interrompida)
+}
+
+static bool ler_delta(const uint8_t **p, const uint8_t *fim, int32_t anterior, int32_t *novo) {
+  uint32_t z;
+  if (!ler_varint(p, fim, &z)) return false;
+  *novo = anterior + ((int32_t)(z >> 1) ^ -(int32_t)(z & 1));
+  return true;
+}
+
+static void iniciar_codificador(Codificador *c, uint32_t minuto_base) {
+  memset(c, 0, sizeof(*c));
+  c->minuto = minuto_base;
+}
+
+static size_t codificar(Codificador *c, const Registro *r, uint8_t *saida) {
+  uint8_t *p = saida;
+  *p++ = r->tipo;
+  switch (r->tipo) {
+    case TIPO_PREPARO:
+      p = escrever_delta(p, r->minuto, c->minuto);
+      p = escrever_delta(p, r->xicaras, c->preparo.xicaras);
+      p = escrever_delta(p, r->pressao, c->preparo.pressao);
+      p = escrever_delta(p, r->temperatura_dc, c->preparo.temperatura_dc);
+      p = escrever_delta(p, r->agua_por_xicara, c->preparo.agua_por_xicara);
+      p = escrever_delta(p, r->duracao, c->preparo.duracao);
+      c->minuto = r->minuto;
+      c->preparo = *r;
+      break;
+    case TIPO_AMBIENTE:
+      p = escrever_delta(p, r->minuto, c->minuto);
+      p = escrever_delta(p, r->temperatura_dc, c->ambiente.temperatura_dc);
+      p = escrever_delta(p, r->umidade_dc, c->ambiente.umidade_dc);
+      c->minuto = r->minuto;
+      c->ambiente = *r;
+      break;
+    case TIPO_RESUMO:
+      p = escrever_delta(p, r->dia, c->resumo.dia);
+      p = escrever_varint(p, r->preparos);
+      p = escrever_varint(p, r->xicaras);
+      p = escrever_varint(p, r->duracao);
+      p = escrever_varint(p, r->amostras);
+      p = escrever_delta(p, r->temperatura_dc, c->resumo.temperatura_dc);
+      p = escrever_delta(p, r->umidade_dc, c->resumo.umidade_dc);
+      c->resumo = *r;
+      break;
+    case TIPO_DOBRA:
+      p = escrever_varint(p, r->seq);
+      break;
+  }
+  return p - saida;
+}
+
+// Próximo registro da página; false no fim (flash apagada) ou em um registro truncado
+static bool decodificar(Codificador *c, const uint8_t **p, const uint8_t *fim, Registro *r) {
+  if (*p >= fim || **p == TIPO_FIM) return false;
+  memset(r, 0, sizeof(*r));
+  r->tipo = *(*p)++;
+  int32_t v[7];
+  uint32_t u[4];
+  switch (r->tipo) {
+    case TIPO_PREPARO:
+      if (!ler_delta(p, fim, c->minuto, &v[0]) || !ler_delta(p, fim, c->preparo.xicaras, &v[1]) ||
+          !ler_delta(p, fim, c->preparo.pressao, &v[2]) || !ler_delta(p, fim, c->preparo.temperatura_dc, &v[3]) ||
+          !ler_delta(p, fim, c->preparo.agua_por_xicara, &v[4]) || !ler_delta(p, fim, c->preparo.duracao, &v[5])) {
+        return false;
+      }
+      r->minuto = v[0];
+      r->xicaras = v[1];
+      r->pressao = v[2];
+      r->temperatura_dc = v[3];
+      r->agua_por_xicara = v[4];
+      r->duracao = v[5];
+      c->minuto = r->minuto;
+      c->preparo = *r;
+      return true;
+    case TIPO_AMBIENTE:
+      if (!ler_delta(p, fim, c->minuto, &v[0]) || !ler_delta(p, fim, c->ambiente.temperatura_dc, &v[1]) ||
+          !ler_delta(p, fim, c->ambiente.umidade_dc, &v[2])) {
+        return false;
+      }
+      r->minuto = v[0];
+      r->temperatura_dc = v[1];
+      r->umidade_dc = v[2];
+      c->minuto = r->minuto;
+      c->ambiente = *r;
+      return true;
+    case TIPO_RESUMO:
+      if (!ler_delta(p, fim, c->resumo.dia, &v[0]) || !ler_varint(p, fim, &u[0]) || !ler_varint(p, fim, &u[1]) ||
+          !ler_varint(p, fim, &u[2]) || !ler_varint(p, fim, &u[3]) ||
+          !ler_delta(p, fim, c->resumo.temperatura_dc, &v[1]) || !ler_delta(p, fim, c->resumo.umidade_dc, &v[2])) {
+        return false;
+      }
+      r->dia = v[0];
+      r->preparos = u[0];
+      r->xicaras = u[1];
+      r->duracao = u[2];
+      r->amostras = u[3];
+      r->temperatura_dc = v[1];
+      r->umidade_dc = v[2];
+      c->resumo = *r;
+      return true;
+    case TIPO_DOBRA:
+      return ler_varint(p, fim, &r->seq);
+    default:
+      return false; // TIPO_FIM
+  }
+}
+
+// -------------------------------------------------------------------------------------------------- //
+// Anéis de páginas
+
+static uint32_t total_paginas(const Anel *a) {
+  return a->setores * PAGINAS_POR_SETOR;
+}
+
+static uint16_t setor_da(const Anel *a, uint32_t seq) {
+  return (seq / PAGINAS_POR_SETOR) % a->setores;
+}
+
+static uint32_t deslocamento_pagina(const Anel *a, uint32_t indice) {
+  return a->inicio + indice * FLASH_PAGE_SIZE;
+}
+
+static const uint8_t *pagina_na_flash(const Anel *a, uint32_t indice) {
+  return (const uint8_t *)(uintptr_t)(XIP_BASE + deslocamento_pagina(a, indice));
+}
+
+// Página válida do anel (para o detalhado, ainda não resumida)
+static const CabecalhoPagina *cabecalho_valido(const Anel *a, uint32_t indice) {
+  const CabecalhoPagina *c = (const CabecalhoPagina *)pagina_na_flash(a, indice);
+  if (c->marca != MARCA_PAGINA) return NULL;
+  if (a == &detalhe && c->seq < seq_minima) return NULL;
+  return c;
+}
+
+// Programa os bytes da página da cabeça ainda só na RAM; o resto da imagem fica em 0xFF (não altera a
+// flash). As interrupções ficam desligadas só durante a programação (o XIP para)
+static void descarregar_anel(Anel *a) {
+  if (!a->aberta || a->programado == a->usado) return;
+  memset(imagem, 0xFF, sizeof(imagem));
+  memcpy(imagem + a->programado, a->pagina + a->programado, a->usado - a->programado);
+  uint32_t irq = save_and_disable_interrupts();
+  flash_range_program(deslocamento_pagina(a, a->seq % total_paginas(a)), imagem, FLASH_PAGE_SIZE);
+  restore_interrupts(irq);
+  bytes_gravados += a->usado - a->programado;
+  a->programado = a->usado;
+}
+
+static bool setor_apagado(const Anel *a, uint16_t setor) {
+  const uint32_t *p = (const uint32_t *)pagina_na_flash(a, setor * PAGINAS_POR_SETOR);
+  for (uint32_t i = 0; i < FLASH_SECTOR_SIZE / 4; i++) {
+    if (p[i] != 0xFFFFFFFFu) return false;
+  }
+  return true;
+}
+
+static void dobrar(uint16_t setor);
+
+// Deixa o setor pronto para receber páginas; o detalhado resume o conteúdo antes de apagá-lo
+static void preparar_setor(Anel *a, uint16_t setor) {
+  if (setor_apagado(a, setor)) return;
+  if (a == &detalhe) dobrar(setor);
+  uint32_t irq = save_and_disable_interrupts();
+  flash_range_erase(a->inicio + setor * FLASH_SECTOR_SIZE, FLASH_SECTOR_SIZE);
+  restore_interrupts(irq);
+  apagamentos++;
+}
+
+static void abrir_pagina(Anel *a, uint32_t minuto_base) {
+  descarregar_anel(a);
+  uint32_t seq = a->vazio ? 0 : a->seq + 1;
+  if (seq % PAGINAS_POR_SETOR == 0) { // entrando em outro setor
+    if (!a->proximo_apagado) preparar_setor(a, setor_da(a, seq));
+    a->proximo_apagado = false;       // o seguinte é apagado no serviço, longe das teclas
+  }
+
+  a->seq = seq;
+  a->vazio = false;
+  a->aberta = true;
+  memset(a->pagina, 0xFF, sizeof(a->pagina));
+  CabecalhoPagina *c = (CabecalhoPagina *)a->pagina;
+  c->marca = MARCA_PAGINA;
+  c->seq = seq;
+  c->minuto_base = minuto_base;
+  a->usado = sizeof(CabecalhoPagina);
+  a->programado = 0;
+  iniciar_codificador(&a->cod, minuto_base);
+}
+
+static void anexar(Anel *a, const Registro *r) {
+  uint8_t registro[TAMANHO_MAX_REGISTRO];
+  uint32_t base = r->tipo == TIPO_RESUMO ? r->dia * MINUTOS_POR_DIA : r->minuto;
+  if (!a->aberta) abrir_pagina(a, base);
+
+  Codificador anterior = a->cod;
+  size_t n = codificar(&a->cod, r, registro);
+  if (a->usado + n > FLASH_PAGE_SIZE) { // não cabe: página nova, com as referências zeradas
+    a->cod = anterior;
+    abrir_pagina(a, base);
+    n = codificar(&a->cod, r, registro);
+  }
+  memcpy(a->pagina + a->usado, registro, n);
+  a->usado += n;
+  registros_gravados++;
+  if (!pendente) pendente_desde_us = time_us_64();
+  pendente = true;
+}
+
+// Cabeça do anel: a página válida de maior seq. A página parcial não é reaberta (as referências dos
+// deltas ficaram na RAM); o próximo registro abre uma página nova
+static void recuperar_anel(Anel *a) {
+  for (uint32_t i = 0; i < total_paginas(a); i++) {
+    const CabecalhoPagina *c = (const CabecalhoPagina *)pagina_na_flash(a, i);
+    if (c->marca != MARCA_PAGINA) continue;
+    if (a->vazio || c->seq > a->seq) {
+      a->seq = c->seq;
+      a->vazio = false;
+    }
+  }
+  a->proximo_apagado = !a->vazio && setor_apagado(a, (setor_da(a, a->seq) + 1) % a->setores);
+}
+
+// -------------------------------------------------------------------------------------------------- //
+// Resumo diário do setor detalhado mais antigo
+
+typedef struct {
+  uint32_t dia;
+  uint16_t preparos, xicaras, amostras;
+  uint32_t duracao_ds;
+  int32_t soma_temperatura, soma_umidade;
+} AcumuladoDia;
+
+static void gravar_resumos(AcumuladoDia *dias, int total) {
+  for (int i = 0; i < total; i++) {
+    Registro r = {.tipo = TIPO_RESUMO, .dia = dias[i].dia, .preparos = dias[i].preparos,
+                  .xicaras = dias[i].xicaras, .duracao = dias[i].duracao_ds / 10, .amostras = dias[i].amostras};
+    if (dias[i].amostras) {
+      r.temperatura_dc = dias[i].soma_temperatura / dias[i].amostras;
+      r.umidade_dc = dias[i].soma_umidade / dias[i].amostras;
+    }
+    anexar(&diario, &r);
+  }
+}
+
+// As páginas do setor viram resumos por dia no anel diário; a marca de dobra vai logo depois, na
+// mesma descarga, e a partir dela as consultas deixam de ler as páginas detalhadas do setor
+static void dobrar(uint16_t setor) {
+  AcumuladoDia dias[MAX_DIAS_DOBRA];
+  int total = 0;
+  uint32_t ultima_seq = 0;
+  bool alguma = false;
+
+  for (uint32_t p = 0; p < PAGINAS_POR_SETOR; p++) {
+    uint32_t indice = setor * PAGINAS_POR_SETOR + p;
+    const CabecalhoPagina *c = cabecalho_valido(&detalhe, indice);
+    if (!c) continue;
+    alguma = true;
+    if (c->seq > ultima_seq) ultima_seq = c->seq;
+
+    Codificador cod;
+    iniciar_codificador(&cod, c->minuto_base);
+    const uint8_t *leitura = (const uint8_t *)(c + 1);
+    const uint8_t *fim = pagina_na_flash(&detalhe, indice) + FLASH_PAGE_SIZE;
+    Registro r;
+    while (decodificar(&cod, &leitura, fim, &r)) {
+      if (r.tipo != TIPO_PREPARO && r.tipo != TIPO_AMBIENTE) continue;
+      uint32_t dia = r.minuto / MINUTOS_POR_DIA;
+      int d = 0;
+      while (d < total && dias[d].dia != dia) d++;
+      if (d == total) {
+        if (total == MAX_DIAS_DOBRA) { // tabela cheia: grava o que tem e recomeça
+          gravar_resumos(dias, total);
+          total = d = 0;
+        }
+        memset(&dias[d], 0, sizeof(dias[d]));
+        dias[d].dia = dia;
+        total++;
+      }
+      if (r.tipo == TIPO_PREPARO) {
+        dias[d].preparos++;
+        dias[d].xicaras += r.xicaras;
+        dias[d].duracao_ds += r.duracao;
+      } else {
+        dias[d].amostras++;
+        dias[d].soma_temperatura += r.temperatura_dc;
+        dias[d].soma_umidade += r.umidade_dc;
+      }
+    }
+  }
+  if (!alguma) return;
+
+  gravar_resumos(dias, total);
+  seq_minima = ultima_seq + 1;
+  Registro marca = {.tipo = TIPO_DOBRA, .seq = seq_minima};
+  anexar(&diario, &marca);
+  descarregar_anel(&diario);
+  dobras++;
+}
+
+// -------------------------------------------------------------------------------------------------- //
+// Gravação
+
+void telemetria_iniciar(void) {
+  recuperar_anel(&diario);
+  recuperar_anel(&detalhe);
+
+  // A última marca de dobra diz até onde o anel detalhado já foi resumido
+  for (uint32_t i = 0; i < total_paginas(&diario); i++) {
+    const CabecalhoPagina *c = cabecalho_valido(&diario, i);
+    if (!c) continue;
+    Codificador cod;
+    iniciar_codificador(&cod, c->minuto_base);
+    const uint8_t *leitura = (const uint8_t *)(c + 1);
+    const uint8_t *fim = pagina_na_flash(&diario, i) + FLASH_PAGE_SIZE;
+    Registro r;
+    while (decodificar(&cod, &leitura, fim, &r)) {
+      if (r.tipo == TIPO_DOBRA && r.seq > seq_minima) seq_minima = r.seq;
+    }
+  }
+  iniciada = true;
+}
+
+void telemetria_observar(TelemetriaObservador novo) {
+  observador = novo;
+}
+
+static void avisar(const Registro *r) {
+  if (!observador) return;
+  ResumoPeriodo parte = {0};
+  if (r->tipo == TIPO_PREPARO) {
+    parte.preparos = 1;
+    parte.xicaras = r->xicaras;
+    parte.duracao_s = (r->duracao + 5) / 10;
+  } else {
+    parte.amostras_ambiente = 1;
+    parte.soma_temperatura_dc = r->temperatura_dc;
+    parte.soma_umidade_dc = r->umidade_dc;
+  }
+  observador(r->minuto / MINUTOS_POR_DIA, &parte);
+}
+
+void telemetria_registrar_preparo(uint8_t xicaras, uint8_t pressao, uint16_t temperatura_dc,
+                                  uint16_t agua_por_xicara, uint32_t duracao_ms) {
+  if (!iniciada) return;
+  Registro r = {.tipo = TIPO_PREPARO, .minuto = telemetria_minuto_atual(), .xicaras = xicaras,
+                .pressao = pressao, .temperatura_dc = temperatura_dc, .agua_por_xicara = agua_por_xicara,
+                .duracao = (duracao_ms + 50) / 100};
+  anexar(&detalhe, &r);
+  avisar(&r);
+}
+
+void telemetria_registrar_ambiente(int16_t temperatura_dc, int16_t umidade_dc) {
+  if (!iniciada) return;
+  uint32_t agora = to_ms_since_boot(get_absolute_time());
+  if (ambiente.leituras == 0) ambiente.inicio_ms = agora;
+  ambiente.soma_temperatura += temperatura_dc;
+  ambiente.soma_umidade += umidade_dc;
+  ambiente.leituras++;
+  if (agora - ambiente.inicio_ms < TELEMETRIA_PERIODO_AMBIENTE_MIN * 60000u) return;
+
+  Registro r = {.tipo = TIPO_AMBIENTE, .minuto = telemetria_minuto_atual(),
+                .temperatura_dc = ambiente.soma_temperatura / ambiente.leituras,
+                .umidade_dc = ambiente.soma_umidade / ambiente.leituras};
+  anexar(&detalhe, &r);
+  avisar(&r);
+  memset(&ambiente, 0, sizeof(ambiente));
+}
+
+// -------------------------------------------------------------------------------------------------- //
+// Consultas
+
+static struct {
+  uint32_t paginas, registros, bytes, duracao_us;
+} ultima_consulta;
+
+static ResumoPeriodo *periodo_do_dia(uint32_t dia, uint32_t dia_inicio, uint16_t periodos, uint8_t dias_por_periodo,
+                                     ResumoPeriodo *saida) {
+  if (dia < dia_inicio) return NULL;
+  uint32_t periodo = (dia - dia_inicio) / dias_por_periodo;
+  return periodo < periodos ? &saida[periodo] : NULL;
+}
+
+// Decodifica uma página (da flash ou a da cabeça, na RAM) somando os registros aos períodos
+static void somar_pagina(const uint8_t *pagina, uint32_t dia_inicio, uint16_t periodos, uint8_t dias_por_periodo,
+                         ResumoPeriodo *saida) {
+  const CabecalhoPagina *c = (const CabecalhoPagina *)pagina;
+  Codificador cod;
+  iniciar_codificador(&cod, c->minuto_base);
+  const uint8_t *leitura = pagina + sizeof(CabecalhoPagina);
+  Registro r;
+  while (decodificar(&cod, &leitura, pagina + FLASH_PAGE_SIZE, &r)) {
+    ultima_consulta.registros++;
+    uint32_t dia = r.tipo == TIPO_RESUMO ? r.dia : r.minuto / MINUTOS_POR_DIA;
+    ResumoPeriodo *s = periodo_do_dia(dia, dia_inicio, periodos, dias_por_periodo, saida);
+    if (!s) continue;
+    if (r.tipo == TIPO_PREPARO) {
+      s->preparos++;
+      s->xicaras += r.xicaras;
+      s->duracao_s += (r.duracao + 5) / 10;
+    } else if (r.tipo == TIPO_AMBIENTE) {
+      s->amostras_ambiente++;
+      s->soma_temperatura_dc += r.temperatura_dc;
+      s->soma_umidade_dc += r.umidade_dc;
+    } else if (r.tipo == TIPO_RESUMO) {
+      s->preparos += r.preparos;
+      s->xicaras += r.xicaras;
+      s->duracao_s += r.duracao;
+      s->amostras_ambiente += r.amostras;
+      s->soma_temperatura_dc += (int32_t)r.temperatura_dc * r.amostras;
+      s->soma_umidade_dc += (int32_t)r.umidade_dc * r.amostras;
+    }
+  }
+  ultima_consulta.paginas++;
+  ultima_consulta.bytes += leitura - pagina;
+}
+
+static void somar_anel(const Anel *a, uint32_t dia_inicio, uint16_t periodos, uint8_t dias_por_periodo,
+                       ResumoPeriodo *saida) {
+  uint32_t cabeca = a->seq % total_paginas(a);
+  for (uint32_t i = 0; i < total_paginas(a); i++) {
+    if (a->aberta && i == cabeca) {
+      somar_pagina(a->pagina, dia_inicio, periodos, dias_por_periodo, saida); // inclui o que não foi programado
+    } else if (cabecalho_valido(a, i)) {
+      somar_pagina(pagina_na_flash(a, i), dia_inicio, periodos, dias_por_periodo, saida);
+    }
+  }
+}
+
+void telemetria_consultar(uint32_t dia_inicio, uint16_t periodos, uint8_t dias_por_periodo, ResumoPeriodo *saida) {
+  uint64_t inicio = time_us_64();
+  memset(saida, 0, periodos * sizeof(ResumoPeriodo));
+  memset(&ultima_consulta, 0, sizeof(ultima_consulta));
+  if (dias_por_periodo == 0 || !iniciada) return;
+  somar_anel(&diario, dia_inicio, periodos, dias_por_periodo, saida);
+  somar_anel(&detalhe, dia_inicio, periodos, dias_por_periodo, saida);
+  ultima_consulta.duracao_us = (uint32_t)(time_us_64() - inicio);
+}
+
+// -------------------------------------------------------------------------------------------------- //
+// Relatório e serviço
+
+void telemetria_solicitar_relatorio(void) {
+  relatorio_pendente = true;
+}
+
+static void imprimir_relatorio() {
+  uint32_t hoje = telemetria_dia_atual();
+  ResumoPeriodo dias[7], semanas[4];
+
+  telemetria_consultar(hoje - 6, 7, 1, dias);
+  printf("TELE INICIO paginas=%lu registros=%lu bytes=%lu (%lu.%lu bytes/registro) consulta=%lu us\n",
+         (unsigned long)ultima_consulta.paginas, (unsigned long)ultima_consulta.registros,
+         (unsigned long)ultima_consulta.bytes,
+         (unsigned long)(ultima_consulta.registros ? ultima_consulta.bytes / ultima_consulta.registros : 0),
+         (unsigned long)(ultima_consulta.registros ? ultima_consulta.bytes * 10 / ultima_consulta.registros % 10 : 0),
+         (unsigned long)ultima_consulta.duracao_us);
+  for (int d = 0; d < 7; d++) {
+    const ResumoPeriodo *s = &dias[d];
+    int32_t n = s->amostras_ambiente ? (int32_t)s->amostras_ambiente : 1;
+    int32_t temperatura = s->soma_temperatura_dc / n, umidade = s->soma_umidade_dc / n;
+    printf("TELE dia -%d xicaras=%u preparos=%u ambiente=%s%ld.%ldC %ld.%ld%%\n", 6 - d, s->xicaras, s->preparos,
+           temperatura < 0 ? "-" : "", (long)(abs(temperatura) / 10), (long)(abs(temperatura) % 10),
+           (long)(umidade / 10), (long)(umidade % 10));
+  }
+
+  telemetria_consultar(hoje - 27, 4, 7, semanas);
+  for (int w = 0; w < 4; w++) {
+    const ResumoPeriodo *s = &semanas[w];
+    printf("TELE semana -%d preparos=%u xicaras=%u tempo medio=%lu s\n", 3 - w, s->preparos, s->xicaras,
+           (unsigned long)(s->preparos ? s->duracao_s / s->preparos : 0));
+  }
+  printf("TELE gravados=%lu registros %lu bytes, apagamentos=%lu dobras=%lu\n", (unsigned long)registros_gravados,
+         (unsigned long)bytes_gravados, (unsigned long)apagamentos, (unsigned long)dobras);
+  printf("TELE FIM\n");
+}
+
+void telemetria_servico(void) {
+  if (!iniciada) return;
+  uint64_t agora = time_us_64();
+
+  if (pendente && agora - pendente_desde_us >= TELEMETRIA_ATRASO_MS * 1000ull) {
+    descarregar_anel(&detalhe);
+    descarregar_anel(&diario);
+    pendente = false;
+  } else if (agora - estado_ultimo_evento_us() >= TELEMETRIA_QUIETO_MS * 1000ull) {
+    // Apagamento antecipado do setor seguinte ao da cabeça (um por volta do loop)
+    Anel *aneis[] = {&detalhe, &diario};
+    for (int i = 0; i < 2; i++) {
+      Anel *a = aneis[i];
+      if (a->vazio || a->proximo_apagado) continue;
+      preparar_setor(a, (setor_da(a, a->seq) + 1) % a->setores);
+      a->proximo_apagado = true;
+      break;
+    }
+  }
+
+  if (relatorio_pendente) {
+    relatorio_pendente = false;
+    imprimir_relatorio();
+  }
+}
@@ -0,0 +1,62 @@
+// telemetria.h
+// Histórico de preparos e do ambiente na flash, compactado por página: cada registro guarda o tempo e
+// os campos como diferenças (zigue-zague + varint) em relação ao registro anterior do mesmo tipo na
+// página, de modo que um preparo ocupa ~8 bytes e uma amostra do ambiente ~4. Cada página de 256 bytes
+// começa do zero (cabeçalho com a sequência e o minuto base) e pode ser lida sozinha.
+// Dois anéis de setores (placa.h): o detalhado recebe os preparos e a média do ambiente a cada
+// TELEMETRIA_PERIODO_AMBIENTE_MIN; antes de apagar o setor mais antigo, o conteúdo dele vira resumos
+// diários (preparos, xícaras, tempo de preparo e médias do ambiente) no anel diário, que guarda anos.
+// As consultas percorrem as páginas direto da flash (XIP), uma por vez, somando por período.
+// Como o registro de chaves (armazenamento.h), as gravações vão em lote, com as interrupções
+// desligadas só durante a programação, e os apagamentos são feitos antes de serem necessários.
+
+#ifndef TELEMETRIA_H
+#define TELEMETRIA_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef TELEMETRIA_PERIODO_AMBIENTE_MIN
+#define TELEMETRIA_PERIODO_AMBIENTE_MIN 10 // média das leituras do DHT22 gravada a cada período
+#endif
+
+#ifndef TELEMETRIA_ATRASO_MS
+#define TELEMETRIA_ATRASO_MS 60000 // junta os registros de um minuto em uma programação
+#endif
+
+#ifndef TELEMETRIA_QUIETO_MS
+#define TELEMETRIA_QUIETO_MS 2000  // sem eventos por esse tempo: pode apagar o próximo setor
+#endif
+
+#define TELEMETRIA_SETORES_DIARIO 4 // dos FLASH_TELEMETRIA_SETORES, os últimos guardam os resumos diários
+
+// Totais de um período da consulta
+typedef struct {
+  uint16_t preparos;
+  uint16_t xicaras;
+  uint32_t duracao_s;           // soma das durações dos preparos
+  uint32_t amostras_ambiente;   // médias de TELEMETRIA_PERIODO_AMBIENTE_MIN somadas
+  int32_t soma_temperatura_dc;  // décimos de °C
+  int32_t soma_umidade_dc;      // décimos de %
+} ResumoPeriodo;
+
+// Avisado a cada preparo ou média do ambiente anexados, com o dia do registro e a parte dele nos totais
+// (a mesma das consultas): quem mantém totais soma sem reler a flash
+typedef void (*TelemetriaObservador)(uint32_t dia, const ResumoPeriodo *registro);
+
+void telemetria_iniciar(void); // encontra as cabeças dos anéis (fora do caminho rápido do boot)
+void telemetria_observar(TelemetriaObservador observador); // um só; NULL desliga
+void telemetria_registrar_preparo(uint8_t xicaras, uint8_t pressao, uint16_t temperatura_dc,
+                                  uint16_t agua_por_xicara, uint32_t duracao_ms);
+void telemetria_registrar_ambiente(int16_t temperatura_dc, int16_t umidade_dc); // acumula a média do período
+
+uint32_t telemetria_minuto_atual(void); // minutos desde 01/01/2000, pelo RTC
+uint32_t telemetria_dia_atual(void);    // dias desde 01/01/2000, pelo RTC
+// Soma os registros de `periodos` períodos de `dias_por_periodo` dias a partir de dia_inicio
+// (ex.: xícaras por dia com 1, tempo médio de preparo por semana com 7)
+void telemetria_consultar(uint32_t dia_inicio, uint16_t periodos, uint8_t dias_por_periodo, ResumoPeriodo *saida);
+
+void telemetria_solicitar_relatorio(void); // relatório pela USB (seguro em IRQ)
+void telemetria_servico(void);             // descarga em lote, apagamento antecipado e relatório
+
+#endif // TELEMETRIA_H
@@ -0,0 +1,44 @@
+// hal_gpio.h
+// Acesso direto aos registradores do SIO para as operações de pino frequentes (passos do motor,
+// barra de LEDs, leitura do DHT22). Com o pino constante de placa.h, cada chamada vira uma única
+// escrita ou leitura de registrador, também nos builds de depuração (inline forçado).
+// Configuração de pinos (função, direção, pull) continua com as funções do SDK.
+
+#ifndef HAL_GPIO_H
+#define HAL_GPIO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "pico/platform.h"
+#include "hardware/structs/sio.h"
+
+static __force_inline void hal_gpio_ligar(uint32_t pino) {
+  sio_hw->gpio_set = 1u << pino;
+}
+
+static __force_inline void hal_gpio_desligar(uint32_t pino) {
+  sio_hw->gpio_clr = 1u << pino;
+}
+
+static __force_inline void hal_gpio_escrever(uint32_t pino, bool valor) {
+  if (valor) {
+    sio_hw->gpio_set = 1u << pino;
+  } else {
+    sio_hw->gpio_clr = 1u << pino;
+  }
+}
+
+static __force_inline void hal_gpio_alternar(uint32_t pino) {
+  sio_hw->gpio_togl = 1u << pino;
+}
+
+static __force_inline bool hal_gpio_ler(uint32_t pino) {
+  return (sio_hw->gpio_in >> pino) & 1u;
+}
+
+// Escreve vários pinos de uma vez: só os bits da máscara mudam (um XOR no registrador de alternância)
+static __force_inline void hal_gpio_escrever_mascara(uint32_t mascara, uint32_t valor) {
+  sio_hw->gpio_togl = (sio_hw->gpio_out ^ valor) & mascara;
+}
+
+#endif // HAL_GPIO_H
@@ -0,0 +1,30 @@
+// na_ram.h
+// Funções executadas da SRAM em vez da flash: tratadores de IRQ e laços sensíveis ao tempo das bordas.
+// Na flash o código passa pelo cache XIP de 16 KB, e uma falta custa dezenas de ciclos de espera pela
+// memória QSPI; com NA_RAM(nome) a função vai para a seção .time_critical.<nome>, que o script de ligação
+// do SDK copia para a RAM no boot. Só a própria função muda de lugar: o que ela chama (SDK, printf,
+// divisões da libgcc) continua na flash. Por isso um tratador de IRQ marcado só chama outras funções
+// marcadas ou inline (registradores lidos direto, time_us_32) e adia o resto: a decodificação do IR
+// entrega o quadro ao gravador, à latência e ao callback por uma IRQ de software, e o tique da barra de
+// LEDs calcula o padrão sem divisões. read_from_dht e lcd_send_char chamam a flash só fora do trecho
+// sensível (antes e depois do laço das bordas; o driver I2C do SDK). Os despachantes do SDK que chamam
+// esses tratadores (GPIO, alarmes) não mudam.
+// ferramentas/codigo_na_ram.py lista a partir do mapa do ligador o que foi colocado e o tamanho.
+// -DCODIGO_NA_RAM=0 deixa tudo na flash, para comparar os benchmarks com e sem a colocação.
+
+#ifndef NA_RAM_H
+#define NA_RAM_H
+
+#include "pico/platform.h"
+
+#ifndef CODIGO_NA_RAM
+#define CODIGO_NA_RAM 1
+#endif
+
+#if CODIGO_NA_RAM
+#define NA_RAM(nome) __not_in_flash_func(nome)
+#else
+#define NA_RAM(nome) nome
+#endif
+
+#endif // NA_RAM_H
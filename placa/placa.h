@@ -0,0 +1,78 @@
+// placa.h
+// Descrição da placa: todos os pinos, barramentos e endereços do Coffee Time em um só lugar.
+// Os comentários "wokwi:" indicam a peça (e o pino) ligada a cada GPIO no diagram.json;
+// ferramentas/placa.py lê este arquivo para conferir o diagrama do simulador e exportar a mesma
+// descrição para as ferramentas de host.
+
+#ifndef PLACA_H
+#define PLACA_H
+
+#define PLACA_NOME "Raspberry Pi Pico W + Wokwi (CoffeeTime)"
+
+// Controle remoto IR
+#define IR_SENSOR_GPIO_PIN 1  // wokwi: ir1:DAT
+
+// I2C: display LCD 20x4 (PCF8574) e RTC DS1307 no mesmo barramento
+#define I2C_PORT i2c0
+#define SDA_PIN 4             // wokwi: lcd1:SDA rtc1:SDA
+#define SCL_PIN 5             // wokwi: lcd1:SCL rtc1:SCL
+#define LCD_ADDR 0x27         // Endereço padrão do PCF8574
+#define RTC_ADDR 0x68         // DS1307
+
+// Motor de passo (driver A4988)
+#define DIR_PIN 2             // wokwi: drv2:DIR
+#define STEP_PIN 3            // wokwi: drv2:STEP
+
+// LEDs de status
+#define LED_VERDE 7           // wokwi: led1  (sistema ligado)
+#define LED_VERMELHO 12       // wokwi: led2  (reabastecer)
+#define LED_AZUL 13           // wokwi: led3  (preparo em andamento)
+
+// Barra de LEDs da intensidade, do primeiro ao último segmento aceso
+#define LED_BARRA_0 6         // wokwi: bargraph1:A10
+#define LED_BARRA_1 9         // wokwi: bargraph1:A9
+#define LED_BARRA_2 15        // wokwi: bargraph1:A8
+#define LED_BARRA_3 22        // wokwi: bargraph1:A7
+#define LED_BARRA_4 21        // wokwi: bargraph1:A6
+#define LED_BARRA_5 20        // wokwi: bargraph1:A5
+#define LED_BARRA_6 19        // wokwi: bargraph1:A4
+#define LED_BARRA_7 18        // wokwi: bargraph1:A3
+#define LED_BARRA_8 17        // wokwi: bargraph1:A2
+#define LED_BARRA_9 16        // wokwi: bargraph1:A1
+#define PINOS_BARRA_LEDS {LED_BARRA_0, LED_BARRA_1, LED_BARRA_2, LED_BARRA_3, LED_BARRA_4, \
+                          LED_BARRA_5, LED_BARRA_6, LED_BARRA_7, LED_BARRA_8, LED_BARRA_9}
+#define MASCARA_BARRA_LEDS ((1u << LED_BARRA_0) | (1u << LED_BARRA_1) | (1u << LED_BARRA_2) | \
+                            (1u << LED_BARRA_3) | (1u << LED_BARRA_4) | (1u << LED_BARRA_5) | \
+                            (1u << LED_BARRA_6) | (1u << LED_BARRA_7) | (1u << LED_BARRA_8) | \
+                            (1u << LED_BARRA_9))
+
+// Sensor de temperatura/umidade ambiente
+#define DHT_PIN 8             // wokwi: dht1:SDA
+
+// Servos (PWM, fatia 5) e buzzer (PWM, fatia 7A)
+#define SERVO1_PIN 11         // wokwi: servo2:PWM  (comporta de grãos)
+#define SERVO2_PIN 10         // wokwi: servo1:PWM  (comporta de café moído)
+#define BUZZER_PIN 14         // wokwi: bz1
+
+// Potenciômetros (ADC0 a ADC2)
+#define INTENSITY_POT_PIN 26  // wokwi: pot1:SIG
+#define TEMP_WATER_PIN 27     // wokwi: pot2:SIG
+#define WATER_AMOUNT_PIN 28   // wokwi: pot3:SIG
+#define ADC_CANAL(pino) ((pino) - 26)
+
+// Flash (2 MB na Pico W): o firmware fica no início e os dados persistentes nos últimos setores
+#define FLASH_ARMAZENAMENTO_SETORES 4 // registro chave-valor em anel (armazenamento.h)
+#define FLASH_REGISTRO_INICIO (PICO_FLASH_SIZE_BYTES - FLASH_ARMAZENAMENTO_SETORES * FLASH_SECTOR_SIZE)
+#define FLASH_BENCH_INICIO (FLASH_REGISTRO_INICIO - FLASH_ARMAZENAMENTO_SETORES * FLASH_SECTOR_SIZE)
+#define FLASH_TELEMETRIA_SETORES 64   // histórico de preparos e do ambiente, 256 KB (telemetria.h)
+#define FLASH_TELEMETRIA_INICIO (FLASH_BENCH_INICIO - FLASH_TELEMETRIA_SETORES * FLASH_SECTOR_SIZE)
+
+// O benchmark da placa grava o registro em setores de rascunho, logo abaixo do registro, sem gastar os
+// do firmware nem tocar no estoque gravado
+#if defined(COFFEETIME_BENCH_PLACA)
+#define FLASH_ARMAZENAMENTO_INICIO FLASH_BENCH_INICIO
+#else
+#define FLASH_ARMAZENAMENTO_INICIO FLASH_REGISTRO_INICIO
+#endif
+
+#endif // PLACA_H
@@ -4,59 +4,179 @@
 #include "sensores.h"
 #include "atuadores.h"
 #include "lcd_i2c.h"
+#include "animacao.h"
 #include "interface_usuario.h"  
 #include "estado.h"            
+#include "gravador.h"
+#include "rastreio.h"
+#include "pilha.h"
+#include "monitor.h"
+#include "energia.h"
+#include "frequencia.h"
+#include "retomada.h"
+#include "armazenamento.h"
+#include "telemetria.h"
+#include "servidor_status.h"
+#include "log_adiado.h"
+#include "tela.h"
 #include <stdio.h>
 #include "pico/stdlib.h"
-
-#define DHT_PIN 8      // DHT22 para monitorar temperatura/umidade ambiente
-#define BUZZER_PIN 14  // Buzzer para notificações sonoras
-#define LED_AZUL 13          // LED azul: indica que a rotina de preparo do café está ativa
+#include "placa.h"
+#include "controle_ir.h"
 
 extern float agua_ml;
 extern float graos_g;
 extern bool play_apertado;
-extern Estado estado_atual;
 
+// Marcos do boot em µs desde o reset (o temporizador começa a contar junto com o processador)
+static uint32_t boot_lcd_us = 0;         // display inicializado
+static uint32_t boot_interativo_us = 0;  // tela inicial exibida e teclas tratadas pela máquina de estados
+static uint32_t boot_completo_us = 0;    // inicialização adiada concluída
+static bool inicializacao_pendente = true;
+
+// Caminho rápido do boot: só o necessário para mostrar a tela inicial e aceitar teclas. O controle IR
+// vem antes do LCD, para que uma tecla durante a espera do display já entre na fila de eventos, e o tom
+// de boas-vindas toca em segundo plano. O resto fica para inicializacao_servico.
 void setup_machine() {
+  pilha_pintar();     // antes de tudo: marca d'água das pilhas
   stdio_init_all();
+  gravador_iniciar(); // grava a sessão (ou reproduz a gravação ligada ao firmware)
+  monitor_iniciar();  // orçamentos de tempo por estado (e watchdog, se habilitado)
+  armazenamento_iniciar(); // estoque gravado na flash (lê só o setor ativo)
+  init_ir_irq_receiver(IR_SENSOR_GPIO_PIN, &callback_ir);
   init_leds();
+  servo_init();       // o alocador de PWM também prepara o buzzer
+  play_success_tone(BUZZER_PIN); // não bloqueia
+  init_i2c_lcd();     // espera o LCD completar 50 ms ligado
+  boot_lcd_us = time_us_32();
+  energia_iniciar();  // contabilidade dos estados de energia
+  frequencia_iniciar(); // contabilidade dos perfis de clock
+}
+
+void inicializacao_marcar_interativo(void) {
+  boot_interativo_us = time_us_32();
+}
+
+uint32_t inicializacao_interativo_us(void) {
+  return boot_interativo_us;
+}
+
+// Inicialização adiada: roda no loop principal depois que a tela inicial já aceita teclas. Nenhum dos
+// periféricos abaixo é usado antes de um preparo (o DHT22 só é lido 2 s após o boot)
+void inicializacao_servico(void) {
+  if (!inicializacao_pendente) return;
+  inicializacao_pendente = false;
+
   init_led_bar();
-  init_i2c_lcd();
-  servo_init();
   stepper_init();
   gpio_init(DHT_PIN);
   init_adc();
-  play_success_tone(BUZZER_PIN);
-
-  printf("INSTRUÇÕES DE USO DA MÁQUINA DE CAFÉ\n");
-  printf("=====================================================================================\n");
-  printf(">> Ajuste a bebida conforme desejado: intensidade, temperatura e quantidade de água.\n");
-  printf(">> Use o controle IR para navegar. Aperte PLAY para iniciar.\n");
-  printf(">> Use o sensor DHT22 para monitorar temperatura/umidade ambiente.\n");
-  printf(">> Caso agende o preparo, a máquina aguardará o horário marcado.\n");
-  printf(">> Durante o preparo, a barra de LEDs indica a força do café.\n");
-  printf(">> A tela inicial atualiza os valores conforme o uso.\n");
+  telemetria_iniciar(); // cabeças dos anéis do histórico (percorre os cabeçalhos das páginas)
+  servidor_status_iniciar(); // só agenda: o firmware do CYW43 leva centenas de ms e carrega depois
+
+  LOG("INSTRUÇÕES DE USO DA MÁQUINA DE CAFÉ\n");
+  LOG("=====================================================================================\n");
+  LOG(">> Ajuste a bebida conforme desejado: intensidade, temperatura e quantidade de água.\n");
+  LOG(">> Use o controle IR para navegar. Aperte PLAY para iniciar.\n");
+  LOG(">> Use o sensor DHT22 para monitorar temperatura/umidade ambiente.\n");
+  LOG(">> Caso agende o preparo, a máquina aguardará o horário marcado.\n");
+  LOG(">> Durante o preparo, a barra de LEDs indica a força do café.\n");
+  LOG(">> A tela inicial atualiza os valores conforme o uso.\n");
+
+  boot_completo_us = time_us_32();
+  LOG("BOOT: LCD em %lu us, interativo em %lu us (meta %u us), completo em %lu us\n",
+      (unsigned long)boot_lcd_us, (unsigned long)boot_interativo_us, BOOT_META_INTERATIVO_US,
+      (unsigned long)boot_completo_us);
+}
+
+// Telas do preparo: os valores vêm das fontes abaixo e só os campos alterados são reescritos
+static struct {
+  FonteDados fonte;
+  float temperatura;
+} aquecimento;
+
+static struct {
+  FonteDados fonte;
+  int xicaras, agua_por_xicara;
+  const char *intensidade, *nivel_temperatura;
+} pedido;
+
+static void formatar_temperatura_agua(char *destino, size_t tamanho) {
+  snprintf(destino, tamanho, "TEMP: %.1f C", aquecimento.temperatura);
+}
+
+static void formatar_nivel_temperatura(char *destino, size_t tamanho) {
+  snprintf(destino, tamanho, "%s", pedido.nivel_temperatura);
 }
 
+static void formatar_quantidade(char *destino, size_t tamanho) {
+  if (pedido.xicaras == 1) {
+    snprintf(destino, tamanho, "1 CUP OF %d ML", pedido.agua_por_xicara);
+  } else {
+    snprintf(destino, tamanho, "%d CUPS OF %d ML", pedido.xicaras, pedido.agua_por_xicara);
+  }
+}
+
+static void formatar_intensidade(char *destino, size_t tamanho) {
+  snprintf(destino, tamanho, "%s", pedido.intensidade);
+}
+
+static const Rotulo rotulos_aquecimento[] = {
+  {1, 2, "HEATING WATER..."},
+};
+static const Campo campos_aquecimento[] = {
+  {2, 4, 13, &aquecimento.fonte, formatar_temperatura_agua},
+};
+static const Icone icones_aquecimento[] = {
+  {1, 0, GLIFO_GOTA},
+  {2, 2, GLIFO_TERMOMETRO},
+};
+static uint32_t versoes_aquecimento[TOTAL_ITENS(campos_aquecimento)];
+static const Tela tela_aquecimento = {rotulos_aquecimento, TOTAL_ITENS(rotulos_aquecimento),
+                                      campos_aquecimento, TOTAL_ITENS(campos_aquecimento), versoes_aquecimento,
+                                      icones_aquecimento, TOTAL_ITENS(icones_aquecimento)};
+
+static const Rotulo rotulos_extracao[] = {
+  {0, 0, "BREWING COFFEE:"},
+  {3, 0, "INTENSITY: "},
+};
+static const Campo campos_extracao[] = {
+  {0, 15, 5, &pedido.fonte, formatar_nivel_temperatura}, // nível de temperatura escolhida
+  {2, 0, LCD_COLS, &pedido.fonte, formatar_quantidade},   // quantidade preparada
+  {3, 11, 9, &pedido.fonte, formatar_intensidade},        // nível de intensidade do café
+};
+static const Rotulo rotulos_graos[] = {{1, 1, "RELEASING BEANS..."}};
+static const Tela tela_graos = {rotulos_graos, TOTAL_ITENS(rotulos_graos), NULL, 0, NULL};
+
+static const Rotulo rotulos_moagem[] = {{1, 4, "GRINDING ..."}};
+static const Tela tela_moagem = {rotulos_moagem, TOTAL_ITENS(rotulos_moagem), NULL, 0, NULL};
+
+static const Icone icones_extracao[] = {
+  {1, 8, GLIFO_XICARA},
+  {1, 11, GLIFO_GOTA},
+};
+static uint32_t versoes_extracao[TOTAL_ITENS(campos_extracao)];
+static const Tela tela_extracao = {rotulos_extracao, TOTAL_ITENS(rotulos_extracao),
+                                   campos_extracao, TOTAL_ITENS(campos_extracao), versoes_extracao,
+                                   icones_extracao, TOTAL_ITENS(icones_extracao)};
+
 // Função para determinar a temperatura da bebida
 void simular_aquecimento_automatico(float temp_desejada) {
-  float temperatura_atual = 25.0;
+  aquecimento.temperatura = 25.0;
+  fonte_publicar(&aquecimento.fonte);
   lcd_clear();
-  lcd_set_cursor(1, 2);
-  lcd_print("HEATING WATER...");
-
-  while (temperatura_atual <= temp_desejada) {
-    char buffer[16];
-    snprintf(buffer, sizeof(buffer), "TEMP: %.1f C", temperatura_atual);
-    lcd_set_cursor(2, 4);
-    lcd_print(buffer);
-    temperatura_atual += 2.5;
+  tela_exibir(&tela_aquecimento);
+
+  while (aquecimento.temperatura <= temp_desejada) {
+    tela_atualizar(&tela_aquecimento);
+    aquecimento.temperatura += 2.5;
+    fonte_publicar(&aquecimento.fonte);
     sleep_ms(400);
   }
 
   lcd_clear();
   type_effect("   WATER READY!", 1, 50);
+  animacao_aguardar_todas(); // a próxima etapa limpa o display: a mensagem precisa terminar antes
   sleep_ms(500);
 }
 
@@ -74,90 +194,139 @@ const char* determinar_nivel_temperatura(float temperatura) {
   else return "HOT++";
 }
 
-// Função principal para simular o preparo do café:
+// Fim de uma etapa: rastreio, ponto de retomada (com o estoque atual) e nova foto para o servidor de status,
+// que responde durante o preparo
+static void concluir_etapa(EtapaPreparo etapa) {
+  rastreio_evento(RASTREIO_ETAPA_FIM, etapa, 0);
+  retomada_concluir_etapa(etapa);
+  servidor_status_publicar();
+}
+
 // Função principal para simular o preparo do café:
 // 1. Verifica recursos
 // 2. Acende a barra de LEDs conforme a força do café
 // 3. Simula o aquecimento da água conforme ajuste do usuário
 // 4. Movimenta os servomotores e o motor de passo
 // 5. Finaliza o preparo e atualiza os recursos
+// Cada etapa concluída vai para o ponto de retomada (retomada.h); depois de um reinício, o preparo
+// continua da etapa seguinte com os parâmetros registrados
 void preparar_cafe(int xicaras) {
-  int pressao = ler_intensidade(); // Intensidade do café (pressão da extração)
-  float temperatura_desejada = ler_temperatura_desejada(); // Temperatura da bebida
-  int agua_por_xicara = ler_quantidade_agua(); // Quantidade de água por xícara
+  inicializacao_servico(); // um preparo retomado no boot chega aqui antes da primeira volta do loop
+  uint64_t inicio_preparo = time_us_64();
+
+  // Pedido novo: lê os potenciômetros; pedido interrompido por um reinício: parâmetros registrados
+  PedidoPreparo registro;
+  EtapaPreparo inicio = ETAPA_VERIFICACAO;
+  bool retomado = retomada_pendente(&registro, &inicio);
+  if (!retomado) {
+    registro.xicaras = xicaras;
+    registro.pressao = ler_intensidade();
+    registro.temperatura_dc = (uint16_t)(ler_temperatura_desejada() * 10 + 0.5f);
+    registro.agua_por_xicara = ler_quantidade_agua();
+    retomada_registrar_pedido(&registro);
+  }
+  servidor_status_publicar(); // o preparo já aparece no /status
+  xicaras = registro.xicaras;
+  int pressao = registro.pressao; // Intensidade do café (pressão da extração)
+  float temperatura_desejada = registro.temperatura_dc / 10.0f; // Temperatura da bebida
+  int agua_por_xicara = registro.agua_por_xicara; // Quantidade de água por xícara
   const char* intensidade = determinar_intensidade(pressao); // intensidade do café
   const char* nivel_temperatura = determinar_nivel_temperatura(temperatura_desejada); //temperatura do café
 
-  verificar_recursos_simulado(xicaras, agua_por_xicara); // Verifica com a rotina simulada
+  if (retomado) { // as etapas já concluídas não se repetem; só a sinalização volta
+    lcd_clear();
+    lcd_set_cursor(1, 2);
+    lcd_print("RESUMING BREW...");
+    gpio_put(LED_AZUL, 1);
+    if (inicio > ETAPA_INTENSIDADE) atualizar_led_bar(pressao);
+    sleep_ms(1000);
+  }
 
-  gpio_put(LED_AZUL, 1); // Acende o LED azul para indicar preparo
-  play_tone(BUZZER_PIN, 500, 600, 0.8);  // Som início do preparo
-  sleep_ms(1000);
+  if (inicio <= ETAPA_VERIFICACAO) {
+    rastreio_evento(RASTREIO_ETAPA_INICIO, ETAPA_VERIFICACAO, xicaras);
+    verificar_recursos_simulado(xicaras, agua_por_xicara); // Verifica com a rotina simulada
+    concluir_etapa(ETAPA_VERIFICACAO); // inclui um eventual reabastecimento
+  }
 
-  lcd_clear();
-  lcd_set_cursor(1, 0);
-  lcd_print("STARTING PROCESS ..."); //máquina iniciando o preparo
-  for (int i = 0; i <= 80; i += 10) {
-    progress_bar(i, 2);
-    sleep_ms(300);
+  if (inicio <= ETAPA_INICIO) {
+    rastreio_evento(RASTREIO_ETAPA_INICIO, ETAPA_INICIO, 0);
+    gpio_put(LED_AZUL, 1); // Acende o LED azul para indicar preparo
+    play_tone(BUZZER_PIN, 500, 600, 0.8);  // Som início do preparo
+    sleep_ms(1000);
+
+    lcd_clear();
+    lcd_set_cursor(1, 0);
+    lcd_print("STARTING PROCESS ..."); //máquina iniciando o preparo
+    for (int i = 0; i <= 80; i += 2) { // 1% = uma coluna de pixel da barra
+      progress_bar(i, 2);
+      sleep_ms(66);
+    }
+
+    concluir_etapa(ETAPA_INICIO);
   }
 
   // Atualiza a barra de LEDs com a intensidade do café
-  atualizar_led_bar(pressao);
+  if (inicio <= ETAPA_INTENSIDADE) {
+    rastreio_evento(RASTREIO_ETAPA_INICIO, ETAPA_INTENSIDADE, pressao);
+    atualizar_led_bar(pressao);
+    concluir_etapa(ETAPA_INTENSIDADE);
+  }
 
   // Ajusta o aquecimento conforme escolha do usuário
-  simular_aquecimento_automatico(temperatura_desejada);
+  if (inicio <= ETAPA_AQUECIMENTO) {
+    rastreio_evento(RASTREIO_ETAPA_INICIO, ETAPA_AQUECIMENTO, (uint32_t)temperatura_desejada);
+    simular_aquecimento_automatico(temperatura_desejada);
+    concluir_etapa(ETAPA_AQUECIMENTO);
+  }
   // Ajusta a quantidade total de água
   int agua_total = xicaras * agua_por_xicara;
 
   // Movimento do primeiro servo (grãos liberados para a moagem)
-  lcd_clear();
-  lcd_set_cursor(1, 1);
-  lcd_print("RELEASING BEANS...");
-  servo1_movimento();
+  if (inicio <= ETAPA_GRAOS) {
+    rastreio_evento(RASTREIO_ETAPA_INICIO, ETAPA_GRAOS, 0);
+    lcd_clear();
+    tela_exibir(&tela_graos);
+    servo1_movimento();
+    concluir_etapa(ETAPA_GRAOS);
+  }
 
   // Movimento do motor de passo (moagem dos grãos)
-  lcd_clear();
-  lcd_set_cursor(1, 4);
-  lcd_print("GRINDING ...");
-  stepper_rotate(true, 5000, 5);
-  sleep_ms(500);
+  if (inicio <= ETAPA_MOAGEM) {
+    rastreio_evento(RASTREIO_ETAPA_INICIO, ETAPA_MOAGEM, 0);
+    lcd_clear();
+    tela_exibir(&tela_moagem);
+    stepper_rotate(true, 5000, 5);
+    sleep_ms(500);
+    concluir_etapa(ETAPA_MOAGEM);
+  }
 
   // Início da extração do café
   // Tempo de brewing ajustado pela pressão (quanto maior a pressão, menor o tempo)
-  int tempo_brewing = 5000 - (pressao * 20); // Tempo base reduzido pela pressão
-  lcd_clear();
+  if (inicio <= ETAPA_EXTRACAO) {
+    int tempo_brewing = 5000 - (pressao * 20); // Tempo base reduzido pela pressão
+    rastreio_evento(RASTREIO_ETAPA_INICIO, ETAPA_EXTRACAO, tempo_brewing);
+    pedido.xicaras = xicaras;
+    pedido.agua_por_xicara = agua_por_xicara;
+    pedido.intensidade = intensidade;
+    pedido.nivel_temperatura = nivel_temperatura;
+    fonte_publicar(&pedido.fonte);
+    lcd_clear();
+    tela_exibir(&tela_extracao);
 
-  char buffer_temperatura[21]; // nível de temperatura escolhida
-  snprintf(buffer_temperatura, sizeof(buffer_temperatura), "BREWING COFFEE:%s", nivel_temperatura);
-  lcd_set_cursor(0, 0);
-  lcd_print(buffer_temperatura);
+    servo2_move(45);
+    sleep_ms(tempo_brewing); // Simula o tempo de brewing proporcional à pressão da água
 
-  char buffer_agua[21]; // quantidade preparada
-  if (xicaras == 1) {
-    snprintf(buffer_agua, sizeof(buffer_agua), "1 CUP OF %d ML", agua_por_xicara);
-  } else {
-    snprintf(buffer_agua, sizeof(buffer_agua), "%d CUPS OF %d ML", xicaras, agua_por_xicara);
+    // Atualiza os níveis de água e grãos de café
+    agua_ml -= agua_total;
+    graos_g -= xicaras * 10;
+    concluir_etapa(ETAPA_EXTRACAO); // o estoque descontado vai junto com a etapa
   }
-  lcd_set_cursor(2, 0);
-  lcd_print(buffer_agua);
-
-  char buffer_intensidade[21]; // nível de intensidade do café
-  snprintf(buffer_intensidade, sizeof(buffer_intensidade), "INTENSITY: %s", intensidade);
-  lcd_set_cursor(3, 0);
-  lcd_print(buffer_intensidade);
-
-  servo2_move(45);
-  sleep_ms(tempo_brewing); // Simula o tempo de brewing proporcional à pressão da água
-
-  // Atualiza os níveis de água e grãos de café
-  agua_ml -= agua_total;
-  graos_g -= xicaras * 10;
 
   // Mensagem final no display
+  rastreio_evento(RASTREIO_ETAPA_INICIO, ETAPA_FINALIZACAO, 0);
   servo2_movimento();
   lcd_clear();
-  fade_text("  COFFEE IS READY!", "      GRAB IT!", 1, 1000);
+  fade_text("  COFFEE IS READY!", "      GRAB IT!", 1, 1000); // anima durante o som e a barra de LEDs
   play_coffee_ready(BUZZER_PIN);      // toca som para indicar que o café está pronto para retirar
   // Efeito especial: Piscada na barra de LEDs e desligamento em seguida
   piscar_led_bar(3, 300);
@@ -165,7 +334,8 @@ void preparar_cafe(int xicaras) {
   sleep_ms(2000);
 
 
-  exibir_tela_inicial();
-  estado_atual = ESTADO_TELA_INICIAL; // Volta à tela inicial
+  rastreio_evento(RASTREIO_ETAPA_FIM, ETAPA_FINALIZACAO, 0);
+  retomada_encerrar(); // pedido atendido: fica só o estoque
+  telemetria_registrar_preparo(registro.xicaras, registro.pressao, registro.temperatura_dc,
+                               registro.agua_por_xicara, (uint32_t)((time_us_64() - inicio_preparo) / 1000));
 }
-
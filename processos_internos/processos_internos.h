@@ -4,7 +4,26 @@
 #ifndef PROCESSOS_INTERNOS_H
 #define PROCESSOS_INTERNOS_H
 
-void setup_machine();                     // Configura a máquina ao iniciar
+#include <stdint.h>
+
+// Etapas da rotina de preparo do café, na ordem em que são executadas
+typedef enum {
+  ETAPA_VERIFICACAO,   // verificação de água e grãos
+  ETAPA_INICIO,        // sinalização e barra de progresso inicial
+  ETAPA_INTENSIDADE,   // barra de LEDs com a força do café
+  ETAPA_AQUECIMENTO,   // aquecimento da água
+  ETAPA_GRAOS,         // liberação dos grãos (servo 1)
+  ETAPA_MOAGEM,        // moagem (motor de passo)
+  ETAPA_EXTRACAO,      // extração proporcional à pressão
+  ETAPA_FINALIZACAO,   // liberação do café moído, avisos e retorno à tela inicial
+} EtapaPreparo;
+
+#define BOOT_META_INTERATIVO_US 150000 // do reset até a tela inicial aceitar o PLAY
+
+void setup_machine();                     // Configura o mínimo para a tela inicial (display e controle IR)
+void inicializacao_marcar_interativo(void); // a máquina de estados já trata as teclas
+void inicializacao_servico(void);         // periféricos adiados, na primeira volta do loop principal
+uint32_t inicializacao_interativo_us(void); // µs do reset até a máquina ficar interativa
 void preparar_cafe(int xicaras);           // Simula o preparo do café
 void simular_aquecimento_automatico(float temp_desejada); // Simula o aquecimento da água
 const char* determinar_intensidade(int pressao);          // Determina a intensidade do café
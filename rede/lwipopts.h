@@ -0,0 +1,65 @@
+// lwipopts.h
+// Configuração do lwIP para pico_cyw43_arch_lwip_threadsafe_background: sem sistema operacional, pilha
+// rodando na IRQ do rádio e memória só em filas estáticas (MEM_LIBC_MALLOC 0). Dimensionada para o
+// servidor de status: SERVIDOR_CONEXOES conexões com uma resposta de até 1 KB cada, referenciada sem
+// cópia (pbufs do tipo ROM, de MEMP_NUM_PBUF). O heap (MEM_SIZE) recebe só os cabeçalhos TCP/IP de
+// cada segmento; o relatório HTTP da tecla TEST mostra o uso máximo do heap e dos pbufs.
+
+#ifndef LWIPOPTS_H
+#define LWIPOPTS_H
+
+#define NO_SYS                      1
+#define LWIP_SOCKET                 0
+#define LWIP_NETCONN                0
+#define MEM_LIBC_MALLOC             0
+#define MEM_ALIGNMENT               4
+#define MEM_SIZE                    4000
+#define MEMP_NUM_PBUF               16
+#define MEMP_NUM_TCP_SEG            32
+#define MEMP_NUM_TCP_PCB            6  // SERVIDOR_CONEXOES + conexões em TIME_WAIT
+#define MEMP_NUM_TCP_PCB_LISTEN     1
+#define MEMP_NUM_ARP_QUEUE          10
+#define PBUF_POOL_SIZE              24
+
+#define LWIP_ARP                    1
+#define LWIP_ETHERNET               1
+#define LWIP_ICMP                   1
+#define LWIP_RAW                    1
+#define LWIP_IPV4                   1
+#define LWIP_TCP                    1
+#define LWIP_UDP                    1
+#define LWIP_DNS                    1
+#define LWIP_DHCP                   1
+#define DHCP_DOES_ARP_CHECK         0
+#define LWIP_DHCP_DOES_ACD_CHECK    0
+
+#define TCP_MSS                     1460
+#define TCP_WND                     (4 * TCP_MSS)
+#define TCP_SND_BUF                 (4 * TCP_MSS)
+#define TCP_SND_QUEUELEN            ((4 * (TCP_SND_BUF) + (TCP_MSS - 1)) / (TCP_MSS))
+#define LWIP_TCP_KEEPALIVE          1
+
+#define LWIP_NETIF_STATUS_CALLBACK  1
+#define LWIP_NETIF_LINK_CALLBACK    1
+#define LWIP_NETIF_HOSTNAME         1
+// 0: o tcp_write mantém a resposta referenciada (com 1 ele copia cada segmento para o heap, para entregar
+// um quadro contíguo); o driver do CYW43 junta a cadeia de pbufs (cabeçalho + dados) ao enviar
+#define LWIP_NETIF_TX_SINGLE_PBUF   0
+#define LWIP_CHKSUM_ALGORITHM       3
+
+// Só as estatísticas de memória, para o relatório HTTP
+#define LWIP_STATS                  1
+#define LWIP_STATS_DISPLAY          0
+#define MEM_STATS                   1
+#define MEMP_STATS                  1
+#define LINK_STATS                  0
+#define ETHARP_STATS                0
+#define IP_STATS                    0
+#define IPFRAG_STATS                0
+#define ICMP_STATS                  0
+#define UDP_STATS                   0
+#define TCP_STATS                   0
+#define SYS_STATS                   0
+#define LWIP_DEBUG                  0
+
+#endif // LWIPOPTS_H
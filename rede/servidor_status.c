@@ -0,0 +1,351 @@
+// servidor_status.c
+// Servidor HTTP de status sobre o lwIP da Pico W
+
+#include "servidor_status.h"
+#include <stdio.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hardware/sync.h"
+#include "status_http.h"
+#include "estado.h"
+#include "retomada.h"
+#include "telemetria.h"
+#include "interface_usuario.h"
+#include "log_adiado.h"
+
+#if SERVIDOR_STATUS
+#include "pico/cyw43_arch.h"
+#include "lwip/tcp.h"
+#include "lwip/netif.h"
+#include "lwip/stats.h"
+#include "hardware/gpio.h"
+#endif
+
+#define MINUTOS_POR_DIA 1440
+
+extern float agua_ml;
+extern float graos_g;
+
+// Fotos alternadas: o loop principal escreve na que não está publicada e só então troca o índice. Os
+// callbacks do lwIP interrompem o loop no mesmo núcleo e vão até o fim antes de ele continuar, então
+// sempre leem uma foto completa, sem travas nem cópia
+static FotoStatus fotos[2];
+static volatile uint8_t foto_publicada = 0;
+static uint32_t sequencia = 0;
+
+static ResumoPeriodo hoje, semana;
+
+static volatile bool relatorio_pendente = false;
+
+void servidor_status_publicar(void) {
+  FotoStatus *f = &fotos[foto_publicada ^ 1];
+  f->sequencia = ++sequencia;
+  f->tempo_ligado_s = (uint32_t)(time_us_64() / 1000000);
+  f->estado = (uint8_t)estado_corrente();
+  int etapas = retomada_etapas_concluidas();
+  f->etapas_concluidas = etapas < 0 ? STATUS_SEM_PREPARO : (uint8_t)etapas;
+  f->ambiente_valido = ambiente_atual(&f->temperatura_dc, &f->umidade_dc);
+  f->agua_ml = (int32_t)agua_ml;
+  f->graos_g = (int32_t)graos_g;
+  f->hoje = hoje;
+  f->semana = semana;
+  __dmb(); // a foto inteira antes do índice
+  foto_publicada ^= 1;
+}
+
+void servidor_status_solicitar_relatorio(void) {
+  relatorio_pendente = true;
+}
+
+#if SERVIDOR_STATUS
+
+// -------------------------------------------------------------------------------------------------- //
+// Histórico: lido da flash uma vez com o rádio ligado e outra a cada virada do dia; entre elas, os
+// registros novos chegam pela telemetria e são somados aqui
+
+static uint32_t dia_hoje = 0;
+static uint64_t virada_us = 0; // meia-noite, pelo RTC lido na última consulta
+static bool historico_valido = false;
+
+static void consultar_historico(void) {
+  uint32_t minuto = telemetria_minuto_atual();
+  dia_hoje = minuto / MINUTOS_POR_DIA;
+  telemetria_consultar(dia_hoje, 1, 1, &hoje);
+  telemetria_consultar(dia_hoje - 6, 1, 7, &semana);
+  virada_us = time_us_64() + (MINUTOS_POR_DIA - minuto % MINUTOS_POR_DIA) * 60000000ull;
+  historico_valido = true;
+}
+
+static void somar(ResumoPeriodo *total, const ResumoPeriodo *parte) {
+  total->preparos += parte->preparos;
+  total->xicaras += parte->xicaras;
+  total->duracao_s += parte->duracao_s;
+  total->amostras_ambiente += parte->amostras_ambiente;
+  total->soma_temperatura_dc += parte->soma_temperatura_dc;
+  total->soma_umidade_dc += parte->soma_umidade_dc;
+}
+
+// Registro novo na telemetria (loop principal ou etapa do preparo); outro dia refaz a consulta
+static void registro_anexado(uint32_t dia, const ResumoPeriodo *parte) {
+  if (!historico_valido) return;
+  if (dia != dia_hoje) {
+    historico_valido = false;
+    return;
+  }
+  somar(&hoje, parte);
+  somar(&semana, parte);
+}
+
+// -------------------------------------------------------------------------------------------------- //
+// Conexões: vetor fixo; a resposta fica no bloco da conexão até o cliente confirmar o último byte
+
+#define POLL_INTERVALO 10 // x 500 ms: uma conexão aberta há mais de 5 s é abortada
+
+typedef struct {
+  struct tcp_pcb *pcb;   // NULL: livre
+  uint16_t confirmados;  // bytes da resposta já confirmados pelo cliente
+  bool respondido;
+  ConexaoHttp http;
+} Conexao;
+
+static Conexao conexoes[SERVIDOR_CONEXOES];
+static struct tcp_pcb *escuta = NULL;
+static bool radio_ligado = false;
+static bool radio_pendente = false; // o rádio espera a primeira janela quieta do loop
+static bool economia = false;       // modo ocioso: rádio em economia agressiva
+static uint64_t tentativa_us = 0;
+
+// Contadores escritos nos callbacks (IRQ do rádio) e lidos só pelo relatório
+static uint32_t aceitas = 0, recusadas = 0, expiradas = 0, pedidos = 0, respostas_ok = 0;
+static uint32_t montagem_soma_us = 0, montagem_max_us = 0;
+static uint8_t ativas = 0, ativas_max = 0;
+
+static void liberar(Conexao *c) {
+  c->pcb = NULL;
+  ativas--;
+}
+
+static void desligar_callbacks(struct tcp_pcb *pcb) {
+  tcp_arg(pcb, NULL);
+  tcp_recv(pcb, NULL);
+  tcp_sent(pcb, NULL);
+  tcp_err(pcb, NULL);
+  tcp_poll(pcb, NULL, 0);
+}
+
+// Só quando a pilha não referencia mais a resposta (toda confirmada ou ainda não enviada)
+static err_t fechar(Conexao *c) {
+  struct tcp_pcb *pcb = c->pcb;
+  desligar_callbacks(pcb);
+  liberar(c);
+  if (tcp_close(pcb) == ERR_OK) return ERR_OK;
+  tcp_abort(pcb);
+  return ERR_ABRT;
+}
+
+// O abort descarta os segmentos pendentes junto com o pcb: a resposta pode ser liberada na hora
+static err_t abortar(Conexao *c) {
+  struct tcp_pcb *pcb = c->pcb;
+  desligar_callbacks(pcb);
+  liberar(c);
+  tcp_abort(pcb);
+  return ERR_ABRT;
+}
+
+static err_t enviado(void *arg, struct tcp_pcb *pcb, u16_t tamanho) {
+  Conexao *c = (Conexao *)arg;
+  c->confirmados += tamanho;
+  if (c->confirmados < c->http.tamanho_resposta) return ERR_OK;
+  return fechar(c); // Connection: close
+}
+
+static err_t receber(void *arg, struct tcp_pcb *pcb, struct pbuf *p, err_t err) {
+  Conexao *c = (Conexao *)arg;
+  if (!p) { // o cliente fechou o lado dele
+    if (c->respondido) return ERR_OK; // a resposta continua com a pilha até a confirmação
+    return fechar(c);
+  }
+  bool completo = false;
+  for (struct pbuf *q = p; q && !c->respondido && !completo; q = q->next) {
+    completo = status_http_receber(&c->http, (const uint8_t *)q->payload, q->len);
+  }
+  tcp_recved(pcb, p->tot_len);
+  pbuf_free(p);
+  if (!completo) return ERR_OK;
+
+  uint32_t inicio = time_us_32();
+  uint16_t tamanho = status_http_responder(&c->http, &fotos[foto_publicada]);
+  uint32_t duracao = time_us_32() - inicio;
+  montagem_soma_us += duracao;
+  if (duracao > montagem_max_us) montagem_max_us = duracao;
+  pedidos++;
+  if (c->http.codigo == 200) respostas_ok++;
+  c->respondido = true;
+
+  // Sem TCP_WRITE_FLAG_COPY: os segmentos apontam para c->http.resposta, inclusive nas retransmissões
+  if (tcp_write(pcb, c->http.resposta, tamanho, 0) != ERR_OK) return abortar(c);
+  tcp_output(pcb);
+  return ERR_OK;
+}
+
+static void erro(void *arg, err_t err) {
+  Conexao *c = (Conexao *)arg;
+  if (c) liberar(c); // o lwIP já liberou o pcb e os segmentos
+}
+
+static err_t expirar(void *arg, struct tcp_pcb *pcb) {
+  Conexao *c = (Conexao *)arg;
+  expiradas++;
+  return abortar(c);
+}
+
+static err_t aceitar(void *arg, struct tcp_pcb *pcb, err_t err) {
+  if (err != ERR_OK || !pcb) return ERR_VAL;
+  Conexao *c = NULL;
+  for (int i = 0; i < SERVIDOR_CONEXOES && !c; i++) {
+    if (!conexoes[i].pcb) c = &conexoes[i];
+  }
+  if (!c) { // sem bloco livre: recusa em vez de alocar
+    recusadas++;
+    tcp_abort(pcb);
+    return ERR_ABRT;
+  }
+
+  c->pcb = pcb;
+  c->confirmados = 0;
+  c->respondido = false;
+  status_http_iniciar(&c->http);
+  aceitas++;
+  if (++ativas > ativas_max) ativas_max = ativas;
+
+  tcp_arg(pcb, c);
+  tcp_recv(pcb, receber);
+  tcp_sent(pcb, enviado);
+  tcp_err(pcb, erro);
+  tcp_poll(pcb, expirar, POLL_INTERVALO);
+  tcp_nagle_disable(pcb); // a resposta sai inteira no tcp_output
+  return ERR_OK;
+}
+
+// -------------------------------------------------------------------------------------------------- //
+// Wi-Fi
+
+static void conectar(void) {
+  bool aberta = WIFI_SENHA[0] == '\0';
+  cyw43_arch_wifi_connect_async(WIFI_SSID, aberta ? NULL : WIFI_SENHA,
+                                aberta ? CYW43_AUTH_OPEN : CYW43_AUTH_WPA2_AES_PSK);
+  tentativa_us = time_us_64();
+}
+
+static void abrir_escuta(void) {
+  cyw43_arch_lwip_begin(); // fora dos callbacks, o lwIP só com o contexto do rádio travado
+  struct tcp_pcb *pcb = tcp_new_ip_type(IPADDR_TYPE_ANY);
+  if (pcb && tcp_bind(pcb, IP_ANY_TYPE, SERVIDOR_STATUS_PORTA) == ERR_OK) {
+    escuta = tcp_listen_with_backlog(pcb, SERVIDOR_CONEXOES);
+    if (escuta) tcp_accept(escuta, aceitar);
+  } else if (pcb) {
+    tcp_close(pcb);
+  }
+  cyw43_arch_lwip_end();
+  printf("HTTP http://%s:%d/status\n", ip4addr_ntoa(netif_ip4_addr(&cyw43_state.netif[CYW43_ITF_STA])),
+         SERVIDOR_STATUS_PORTA);
+}
+
+// A escuta fica aberta entre as quedas do Wi-Fi; uma falha (senha, rede fora do ar) tenta de novo depois
+static void verificar_conexao(void) {
+  int status = cyw43_tcpip_link_status(&cyw43_state, CYW43_ITF_STA);
+  if (status == CYW43_LINK_UP) {
+    if (!escuta) abrir_escuta();
+  } else if (status != CYW43_LINK_JOIN && status != CYW43_LINK_NOIP &&
+             time_us_64() - tentativa_us >= SERVIDOR_RECONEXAO_MS * 1000ull) {
+    conectar();
+  }
+}
+
+static void imprimir_relatorio(void) {
+  printf("HTTP INICIO wifi=%d porta=%d foto=%lu\n", cyw43_tcpip_link_status(&cyw43_state, CYW43_ITF_STA),
+         SERVIDOR_STATUS_PORTA, (unsigned long)sequencia);
+  printf("HTTP conexoes=%lu recusadas=%lu expiradas=%lu simultaneas_max=%u/%d\n", (unsigned long)aceitas,
+         (unsigned long)recusadas, (unsigned long)expiradas, ativas_max, SERVIDOR_CONEXOES);
+  printf("HTTP pedidos=%lu ok=%lu montagem media=%lu max=%lu us\n", (unsigned long)pedidos,
+         (unsigned long)respostas_ok, (unsigned long)(pedidos ? montagem_soma_us / pedidos : 0),
+         (unsigned long)montagem_max_us);
+  // Sem cópia das respostas, o heap só guarda cabeçalhos e o pico de pbufs ROM acompanha as conexões
+  const struct stats_mem *rom = lwip_stats.memp[MEMP_PBUF], *pool = lwip_stats.memp[MEMP_PBUF_POOL];
+  printf("HTTP lwip heap usado=%u max=%u de %u falhas=%lu\n", (unsigned)lwip_stats.mem.used,
+         (unsigned)lwip_stats.mem.max, (unsigned)lwip_stats.mem.avail, (unsigned long)lwip_stats.mem.err);
+  printf("HTTP lwip pbuf_rom max=%u de %u falhas=%lu pbuf_pool max=%u de %u falhas=%lu\n",
+         (unsigned)rom->max, (unsigned)rom->avail, (unsigned long)rom->err, (unsigned)pool->max,
+         (unsigned)pool->avail, (unsigned long)pool->err);
+  printf("HTTP FIM\n");
+}
+
+// O cyw43_arch_init carrega o firmware do rádio e bloqueia o loop por centenas de ms: fica para uma
+// volta sem eventos há SERVIDOR_RADIO_QUIETO_MS, depois do boot, e a duração vai para o log à parte
+static void ligar_radio(void) {
+  radio_pendente = false;
+  uint64_t inicio = time_us_64();
+  if (cyw43_arch_init()) {
+    printf("HTTP radio nao iniciou\n");
+    return;
+  }
+  radio_ligado = true;
+  telemetria_observar(registro_anexado);
+  cyw43_arch_enable_sta_mode();
+  if (economia) cyw43_wifi_pm(&cyw43_state, CYW43_AGGRESSIVE_PM);
+  conectar();
+  LOG("HTTP: radio ligado em %lu us (%lu ms após o reset)\n", (unsigned long)(time_us_64() - inicio),
+      (unsigned long)(inicio / 1000));
+}
+
+void servidor_status_iniciar(void) {
+  radio_pendente = true;
+}
+
+// No modo ocioso o rádio continua associado, mas dorme entre mais beacons: menos despertares pelo
+// host-wake, com resposta mais lenta ao primeiro pacote
+void servidor_status_modo_ocioso(bool ocioso) {
+  economia = ocioso;
+  if (radio_ligado) cyw43_wifi_pm(&cyw43_state, ocioso ? CYW43_AGGRESSIVE_PM : CYW43_DEFAULT_PM);
+}
+
+bool servidor_status_irq_radio(void) {
+  return radio_ligado && gpio_get_irq_event_mask(CYW43_PIN_WL_HOST_WAKE) != 0;
+}
+
+#else
+
+static void imprimir_relatorio(void) {
+  printf("HTTP desligado (SERVIDOR_STATUS=0)\n");
+}
+
+void servidor_status_iniciar(void) {
+}
+
+void servidor_status_modo_ocioso(bool ocioso) {
+}
+
+bool servidor_status_irq_radio(void) {
+  return false;
+}
+
+#endif // SERVIDOR_STATUS
+
+void servidor_status_servico(void) {
+#if SERVIDOR_STATUS
+  if (radio_pendente && time_us_64() - estado_ultimo_evento_us() >= SERVIDOR_RADIO_QUIETO_MS * 1000ull) {
+    ligar_radio();
+  }
+  // Sem rádio ninguém lê a foto: nem consulta ao histórico nem leitura do RTC
+  if (radio_ligado && (!historico_valido || time_us_64() >= virada_us)) consultar_historico();
+#endif
+  servidor_status_publicar();
+#if SERVIDOR_STATUS
+  if (radio_ligado) verificar_conexao();
+#endif
+
+  if (relatorio_pendente) {
+    relatorio_pendente = false;
+    imprimir_relatorio();
+  }
+}
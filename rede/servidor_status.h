@@ -0,0 +1,55 @@
+// servidor_status.h
+// Servidor HTTP de status no Wi-Fi da Pico W (lwIP, modo threadsafe_background): GET /status devolve um
+// JSON com o estado da máquina, a etapa do preparo, o estoque, o ambiente e as estatísticas de preparo
+// do histórico (telemetria.h).
+// O loop principal e as etapas do preparo publicam uma foto do estado em dois buffers alternados; os
+// callbacks do lwIP, que rodam na IRQ do rádio mesmo durante as rotinas bloqueantes, respondem a partir
+// da última foto completa. Cada conexão tem um bloco fixo (status_http.h) onde a resposta inteira é
+// montada e entregue ao tcp_write sem cópia: a pilha envia e retransmite direto desse buffer, que só é
+// liberado quando tudo foi confirmado (LWIP_NETIF_TX_SINGLE_PBUF 0 em lwipopts.h). Nenhuma alocação
+// além das filas fixas e do heap estático do lwIP, que recebe só os cabeçalhos dos segmentos.
+// As estatísticas do histórico são lidas da flash quando o rádio liga e a cada virada do dia; os
+// registros seguintes chegam pelo observador da telemetria, sem nova leitura.
+// A tecla TEST envia pela USB os pedidos atendidos, as conexões recusadas, o tempo de montagem e o uso
+// máximo do heap e dos pbufs do lwIP.
+
+#ifndef SERVIDOR_STATUS_H
+#define SERVIDOR_STATUS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef SERVIDOR_STATUS
+#define SERVIDOR_STATUS 1 // 0: rádio desligado (o firmware não usa o Wi-Fi)
+#endif
+
+#ifndef WIFI_SSID
+#define WIFI_SSID "Wokwi-GUEST" // rede aberta da simulação; na placa, -DWIFI_SSID=... -DWIFI_SENHA=...
+#endif
+
+#ifndef WIFI_SENHA
+#define WIFI_SENHA ""
+#endif
+
+#ifndef SERVIDOR_STATUS_PORTA
+#define SERVIDOR_STATUS_PORTA 80
+#endif
+
+#ifndef SERVIDOR_CONEXOES
+#define SERVIDOR_CONEXOES 4 // conexões simultâneas; as demais são recusadas
+#endif
+
+#define SERVIDOR_RECONEXAO_MS 10000    // nova tentativa depois de uma falha no Wi-Fi
+
+#ifndef SERVIDOR_RADIO_QUIETO_MS
+#define SERVIDOR_RADIO_QUIETO_MS 2000 // sem eventos por esse tempo: pode ligar o rádio
+#endif
+
+void servidor_status_iniciar(void);   // agenda o rádio para uma volta quieta do loop (fora do boot)
+void servidor_status_publicar(void);  // nova foto do estado (loop principal e etapas do preparo)
+void servidor_status_modo_ocioso(bool ocioso); // economia agressiva do rádio no modo ocioso (energia.c)
+bool servidor_status_irq_radio(void); // IRQ do host-wake do rádio pendente (despertares do sono)
+void servidor_status_solicitar_relatorio(void); // relatório pela USB (seguro em IRQ)
+void servidor_status_servico(void);   // foto, estatísticas, conexão Wi-Fi e relatório
+
+#endif // SERVIDOR_STATUS_H
@@ -0,0 +1,186 @@
+// status_host.c
+// Alvo de host do servidor de status: o mesmo protocolo (status_http.c) atrás de sockets POSIX, com uma
+// foto simulada que percorre os estados e as etapas do preparo. Serve para testar as respostas e medir
+// pedidos/s e latência no loopback, sem a placa:
+//   cc -O2 -DCOFFEETIME_STATUS_HOST -Irede -Ipersistencia -Iestado -Iprocessos_internos
+//      rede/status_http.c rede/status_host.c -o status_host
+//   ./status_host 8080 &
+//   python3 ferramentas/carga_http.py 127.0.0.1:8080
+// Como no firmware, as conexões são um vetor fixo de SERVIDOR_CONEXOES; com todas ocupadas, as novas
+// esperam na fila do accept. Ctrl+C encerra e imprime o relatório "HTTP".
+
+#if defined(COFFEETIME_STATUS_HOST)
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+#include "status_http.h"
+#include "estado.h"
+
+#ifndef SERVIDOR_CONEXOES
+#define SERVIDOR_CONEXOES 4
+#endif
+
+typedef struct {
+  int socket;          // -1: livre
+  uint16_t enviados;
+  bool respondendo;
+  ConexaoHttp http;
+} Conexao;
+
+static Conexao conexoes[SERVIDOR_CONEXOES];
+static FotoStatus foto;
+static volatile sig_atomic_t encerrar = 0;
+
+static uint32_t pedidos = 0, respostas_200 = 0, aceitas = 0;
+static uint64_t montagem_soma_ns = 0, montagem_max_ns = 0;
+
+static uint64_t agora_ns(void) {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return (uint64_t)t.tv_sec * 1000000000ull + (uint64_t)t.tv_nsec;
+}
+
+// Máquina simulada: um preparo de 8 etapas a cada 12 s e uma leitura do ambiente por segundo
+static void publicar(uint64_t inicio_ns) {
+  uint32_t decorrido_ms = (uint32_t)((agora_ns() - inicio_ns) / 1000000);
+  uint32_t ciclo = decorrido_ms % 12000;
+  foto.sequencia++;
+  foto.tempo_ligado_s = decorrido_ms / 1000;
+  if (ciclo < 4000) {
+    foto.estado = ESTADO_TELA_INICIAL;
+    foto.etapas_concluidas = STATUS_SEM_PREPARO;
+  } else {
+    foto.estado = ESTADO_PREPARANDO;
+    foto.etapas_concluidas = (uint8_t)((ciclo - 4000) / 1000);
+  }
+  foto.ambiente_valido = true;
+  foto.temperatura_dc = (int16_t)(235 + (decorrido_ms / 1000) % 10);
+  foto.umidade_dc = (int16_t)(550 - (decorrido_ms / 1000) % 20);
+  foto.agua_ml = 2000 - (int32_t)(decorrido_ms / 12000 % 10) * 150;
+  foto.graos_g = 500 - (int32_t)(decorrido_ms / 12000 % 10) * 10;
+  foto.hoje = (ResumoPeriodo){3, 5, 126, 48, 48 * 241, 48 * 532};
+  foto.semana = (ResumoPeriodo){19, 31, 817, 1008, 1008 * 238, 1008 * 547};
+}
+
+static void fechar(Conexao *c) {
+  close(c->socket);
+  c->socket = -1;
+}
+
+static void receber(Conexao *c) {
+  uint8_t dados[512];
+  ssize_t n = recv(c->socket, dados, sizeof(dados), 0);
+  if (n <= 0) {
+    if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) fechar(c);
+    return;
+  }
+  if (c->respondendo || !status_http_receber(&c->http, dados, (size_t)n)) return;
+
+  uint64_t t0 = agora_ns();
+  status_http_responder(&c->http, &foto);
+  uint64_t t = agora_ns() - t0;
+  montagem_soma_ns += t;
+  if (t > montagem_max_ns) montagem_max_ns = t;
+  pedidos++;
+  if (c->http.codigo == 200) respostas_200++;
+  c->respondendo = true;
+  c->enviados = 0;
+}
+
+static void enviar(Conexao *c) {
+  ssize_t n = send(c->socket, c->http.resposta + c->enviados, c->http.tamanho_resposta - c->enviados, MSG_NOSIGNAL);
+  if (n < 0) {
+    if (errno != EAGAIN && errno != EWOULDBLOCK) fechar(c);
+    return;
+  }
+  c->enviados += (uint16_t)n;
+  if (c->enviados == c->http.tamanho_resposta) {
+    shutdown(c->socket, SHUT_WR); // Connection: close
+    fechar(c);
+  }
+}
+
+static void aceitar(int servidor) {
+  for (int i = 0; i < SERVIDOR_CONEXOES; i++) {
+    if (conexoes[i].socket >= 0) continue;
+    int s = accept(servidor, NULL, NULL);
+    if (s < 0) return;
+    int um = 1;
+    setsockopt(s, IPPROTO_TCP, TCP_NODELAY, &um, sizeof(um)); // como o tcp_output imediato no lwIP
+    fcntl(s, F_SETFL, O_NONBLOCK);
+    conexoes[i].socket = s;
+    conexoes[i].respondendo = false;
+    status_http_iniciar(&conexoes[i].http);
+    aceitas++;
+    return;
+  }
+}
+
+static void ao_sinal(int sinal) {
+  (void)sinal;
+  encerrar = 1;
+}
+
+int main(int argc, char **argv) {
+  int porta = argc > 1 ? atoi(argv[1]) : 8080;
+  int servidor = socket(AF_INET, SOCK_STREAM, 0);
+  int um = 1;
+  setsockopt(servidor, SOL_SOCKET, SO_REUSEADDR, &um, sizeof(um));
+  struct sockaddr_in endereco = {0};
+  endereco.sin_family = AF_INET;
+  endereco.sin_port = htons((uint16_t)porta);
+  endereco.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if (bind(servidor, (struct sockaddr *)&endereco, sizeof(endereco)) < 0 || listen(servidor, 64) < 0) {
+    perror("status_host");
+    return 1;
+  }
+  fcntl(servidor, F_SETFL, O_NONBLOCK);
+  signal(SIGINT, ao_sinal);
+  signal(SIGTERM, ao_sinal);
+  for (int i = 0; i < SERVIDOR_CONEXOES; i++) conexoes[i].socket = -1;
+  printf("HTTP http://127.0.0.1:%d/status (%d conexoes)\n", porta, SERVIDOR_CONEXOES);
+  fflush(stdout);
+
+  uint64_t inicio = agora_ns();
+  while (!encerrar) {
+    publicar(inicio); // como o loop principal do firmware: uma foto nova a cada volta
+
+    struct pollfd fds[SERVIDOR_CONEXOES + 1];
+    int livres = 0;
+    for (int i = 0; i < SERVIDOR_CONEXOES; i++) {
+      fds[i].fd = conexoes[i].socket;
+      fds[i].events = conexoes[i].respondendo ? POLLOUT : POLLIN;
+      if (conexoes[i].socket < 0) livres++;
+    }
+    fds[SERVIDOR_CONEXOES].fd = livres ? servidor : -1;
+    fds[SERVIDOR_CONEXOES].events = POLLIN;
+    if (poll(fds, SERVIDOR_CONEXOES + 1, 100) <= 0) continue;
+
+    for (int i = 0; i < SERVIDOR_CONEXOES; i++) {
+      if (conexoes[i].socket < 0 || !fds[i].revents) continue;
+      if (conexoes[i].respondendo) {
+        enviar(&conexoes[i]);
+      } else {
+        receber(&conexoes[i]);
+      }
+    }
+    if (fds[SERVIDOR_CONEXOES].revents & POLLIN) aceitar(servidor);
+  }
+
+  printf("HTTP conexoes=%u pedidos=%u ok=%u montagem media=%llu max=%llu ns\n", aceitas, pedidos, respostas_200,
+         (unsigned long long)(pedidos ? montagem_soma_ns / pedidos : 0), (unsigned long long)montagem_max_ns);
+  close(servidor);
+  return 0;
+}
+
+#endif // COFFEETIME_STATUS_HOST
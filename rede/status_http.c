@@ -0,0 +1,225 @@
+// status_http.c
+// Leitura do pedido e montagem da resposta do servidor de status
+
+#include "status_http.h"
+#include <string.h>
+#include "estado.h"
+#include "processos_internos.h"
+
+#define TOTAL_ETAPAS (ETAPA_FINALIZACAO + 1)
+#define LARGURA_TAMANHO 5 // dígitos reservados para o Content-Length
+
+static const char *nomes_estados[TOTAL_ESTADOS] = {
+  "TELA_INICIAL", "QUANTIDADE_XICARAS", "QUANDO_PREPARAR", "PREPARANDO", "PROGRAMANDO", "AGUARDANDO",
+};
+
+static const char *nomes_etapas[TOTAL_ETAPAS] = {
+  "VERIFICACAO", "INICIO", "INTENSIDADE", "AQUECIMENTO", "GRAOS", "MOAGEM", "EXTRACAO", "FINALIZACAO",
+};
+
+void status_http_iniciar(ConexaoHttp *c) {
+  c->tamanho_linha = 0;
+  c->fim_cabecalho = 0;
+  c->linha_completa = false;
+  c->linha_longa = false;
+  c->codigo = 0;
+  c->tamanho_resposta = 0;
+}
+
+// O fim dos cabeçalhos é a primeira linha vazia. Como permite a RFC 9112 (seção 2.2), um LF sozinho
+// também termina a linha e o CR antes dele é ignorado: valem "\r\n\r\n" e "\n\n"
+bool status_http_receber(ConexaoHttp *c, const uint8_t *dados, size_t tamanho) {
+  for (size_t i = 0; i < tamanho; i++) {
+    char byte = (char)dados[i];
+    if (!c->linha_completa) {
+      if (byte == '\r' || byte == '\n') {
+        c->linha_completa = true;
+      } else if (c->tamanho_linha < STATUS_HTTP_LINHA_BYTES - 1) {
+        c->linha[c->tamanho_linha++] = byte;
+      } else {
+        c->linha_longa = true;
+      }
+    }
+    if (byte == '\n') {
+      if (++c->fim_cabecalho == 2) return true; // o que vier depois (corpo, outro pedido) é ignorado
+    } else if (byte != '\r') {
+      c->fim_cabecalho = 0;
+    }
+  }
+  return false;
+}
+
+// -------------------------------------------------------------------------------------------------- //
+// Escrita sem formatação da libc: o printf de ponto flutuante da newlib aloca memória
+
+typedef struct {
+  char *p, *fim;
+} Escrita;
+
+static void escrever(Escrita *e, const char *texto) {
+  while (*texto && e->p < e->fim) *e->p++ = *texto++;
+}
+
+static void escrever_inteiro(Escrita *e, int32_t valor) {
+  char digitos[11];
+  int n = 0;
+  uint32_t v = valor < 0 ? 0u - (uint32_t)valor : (uint32_t)valor;
+  do {
+    digitos[n++] = (char)('0' + v % 10);
+    v /= 10;
+  } while (v);
+  if (valor < 0 && e->p < e->fim) *e->p++ = '-';
+  while (n && e->p < e->fim) *e->p++ = digitos[--n];
+}
+
+static void escrever_decimos(Escrita *e, int32_t decimos) {
+  if (decimos < 0) {
+    escrever(e, "-");
+    decimos = -decimos;
+  }
+  escrever_inteiro(e, decimos / 10);
+  escrever(e, ".");
+  escrever_inteiro(e, decimos % 10);
+}
+
+static int32_t media_decimos(int32_t soma, uint32_t amostras) {
+  int32_t n = (int32_t)amostras;
+  return soma >= 0 ? (soma + n / 2) / n : (soma - n / 2) / n;
+}
+
+static void escrever_resumo(Escrita *e, const char *nome, const ResumoPeriodo *r) {
+  escrever(e, "\"");
+  escrever(e, nome);
+  escrever(e, "\":{\"preparos\":");
+  escrever_inteiro(e, r->preparos);
+  escrever(e, ",\"xicaras\":");
+  escrever_inteiro(e, r->xicaras);
+  escrever(e, ",\"duracao_media_s\":");
+  if (r->preparos) {
+    escrever_inteiro(e, (int32_t)((r->duracao_s + r->preparos / 2) / r->preparos));
+  } else {
+    escrever(e, "null");
+  }
+  escrever(e, ",\"temperatura_media_c\":");
+  if (r->amostras_ambiente) {
+    escrever_decimos(e, media_decimos(r->soma_temperatura_dc, r->amostras_ambiente));
+    escrever(e, ",\"umidade_media_pct\":");
+    escrever_decimos(e, media_decimos(r->soma_umidade_dc, r->amostras_ambiente));
+  } else {
+    escrever(e, "null,\"umidade_media_pct\":null");
+  }
+  escrever(e, "}");
+}
+
+static void escrever_json(Escrita *e, const FotoStatus *f) {
+  escrever(e, "{\"sequencia\":");
+  escrever_inteiro(e, (int32_t)f->sequencia);
+  escrever(e, ",\"tempo_ligado_s\":");
+  escrever_inteiro(e, (int32_t)f->tempo_ligado_s);
+  escrever(e, ",\"estado\":\"");
+  escrever(e, f->estado < TOTAL_ESTADOS ? nomes_estados[f->estado] : "?");
+  escrever(e, "\",\"preparo\":");
+  if (f->etapas_concluidas == STATUS_SEM_PREPARO) {
+    escrever(e, "null");
+  } else {
+    escrever(e, "{\"etapas_concluidas\":");
+    escrever_inteiro(e, f->etapas_concluidas);
+    escrever(e, ",\"total_etapas\":");
+    escrever_inteiro(e, TOTAL_ETAPAS);
+    escrever(e, ",\"etapa\":\"");
+    escrever(e, f->etapas_concluidas < TOTAL_ETAPAS ? nomes_etapas[f->etapas_concluidas] : "CONCLUIDO");
+    escrever(e, "\"}");
+  }
+  escrever(e, ",\"estoque\":{\"agua_ml\":");
+  escrever_inteiro(e, f->agua_ml);
+  escrever(e, ",\"graos_g\":");
+  escrever_inteiro(e, f->graos_g);
+  escrever(e, "},\"ambiente\":");
+  if (f->ambiente_valido) {
+    escrever(e, "{\"temperatura_c\":");
+    escrever_decimos(e, f->temperatura_dc);
+    escrever(e, ",\"umidade_pct\":");
+    escrever_decimos(e, f->umidade_dc);
+    escrever(e, "}");
+  } else {
+    escrever(e, "null");
+  }
+  escrever(e, ",\"estatisticas\":{");
+  escrever_resumo(e, "hoje", &f->hoje);
+  escrever(e, ",");
+  escrever_resumo(e, "ultimos_7_dias", &f->semana);
+  escrever(e, "}}\n");
+}
+
+// -------------------------------------------------------------------------------------------------- //
+// Resposta: o Content-Length é reservado com largura fixa (espaços à esquerda são permitidos no valor
+// do campo) e preenchido depois do corpo, sem montar o JSON em outro buffer
+
+static uint16_t montar(ConexaoHttp *c, const char *status, const FotoStatus *foto, const char *erro, bool corpo) {
+  Escrita e = {c->resposta, c->resposta + STATUS_HTTP_RESPOSTA_BYTES};
+  escrever(&e, "HTTP/1.1 ");
+  escrever(&e, status);
+  escrever(&e, "\r\nContent-Type: application/json\r\nCache-Control: no-store\r\nConnection: close\r\n");
+  if (c->codigo == 405) escrever(&e, "Allow: GET, HEAD\r\n");
+  escrever(&e, "Content-Length:");
+  char *tamanho = e.p;
+  escrever(&e, "      \r\n\r\n");
+  char *inicio = e.p;
+
+  if (foto) {
+    escrever_json(&e, foto);
+  } else {
+    escrever(&e, "{\"erro\":\"");
+    escrever(&e, erro);
+    escrever(&e, "\"}\n");
+  }
+  if (e.p >= e.fim) { // não cabe (não acontece com os campos atuais): resposta vazia em vez de truncada
+    c->codigo = 500;
+    e.p = c->resposta;
+    escrever(&e, "HTTP/1.1 500 Internal Server Error\r\nContent-Length: 0\r\nConnection: close\r\n\r\n");
+    return (uint16_t)(e.p - c->resposta);
+  }
+
+  uint32_t n = (uint32_t)(e.p - inicio);
+  for (int i = LARGURA_TAMANHO; i > 0; i--) {
+    tamanho[i] = (char)('0' + n % 10);
+    n /= 10;
+    if (n == 0) break;
+  }
+  if (!corpo) e.p = inicio; // HEAD: mesmo cabeçalho, sem o corpo
+  return (uint16_t)(e.p - c->resposta);
+}
+
+static bool caminho_status(const char *caminho, size_t tamanho) {
+  for (size_t i = 0; i < tamanho; i++) {
+    if (caminho[i] == '?') tamanho = i; // parâmetros ignorados
+  }
+  return (tamanho == 1 && caminho[0] == '/') || (tamanho == 7 && memcmp(caminho, "/status", 7) == 0);
+}
+
+uint16_t status_http_responder(ConexaoHttp *c, const FotoStatus *foto) {
+  c->linha[c->tamanho_linha] = '\0';
+  const char *metodo = c->linha;
+  const char *caminho = strchr(metodo, ' ');
+  const char *versao = caminho ? strchr(caminho + 1, ' ') : NULL;
+  bool get = caminho && caminho - metodo == 3 && memcmp(metodo, "GET", 3) == 0;
+  bool head = caminho && caminho - metodo == 4 && memcmp(metodo, "HEAD", 4) == 0;
+
+  if (c->linha_longa) {
+    c->codigo = 414;
+    c->tamanho_resposta = montar(c, "414 URI Too Long", NULL, "pedido longo", true);
+  } else if (!versao || strncmp(versao + 1, "HTTP/1.", 7) != 0) {
+    c->codigo = 400;
+    c->tamanho_resposta = montar(c, "400 Bad Request", NULL, "pedido invalido", true);
+  } else if (!get && !head) {
+    c->codigo = 405;
+    c->tamanho_resposta = montar(c, "405 Method Not Allowed", NULL, "metodo nao suportado", true);
+  } else if (!caminho_status(caminho + 1, (size_t)(versao - caminho - 1))) {
+    c->codigo = 404;
+    c->tamanho_resposta = montar(c, "404 Not Found", NULL, "use /status", get);
+  } else {
+    c->codigo = 200;
+    c->tamanho_resposta = montar(c, "200 OK", foto, NULL, get);
+  }
+  return c->tamanho_resposta;
+}
@@ -0,0 +1,54 @@
+// status_http.h
+// Protocolo do servidor de status, sem dependência do SDK nem da pilha TCP: o firmware (servidor_status.c,
+// sobre o lwIP) e o alvo de host (status_host.c, sobre sockets POSIX) usam o mesmo código.
+// Cada conexão tem um bloco fixo com a linha do pedido e a resposta: o pedido é lido em fluxo (só a
+// primeira linha é guardada, o resto dos cabeçalhos é descartado até a linha em branco) e a resposta é
+// montada de uma vez, cabeçalho e JSON, a partir de uma foto do estado, sem snprintf nem heap.
+// O firmware entrega esse mesmo buffer à pilha TCP sem cópia.
+
+#ifndef STATUS_HTTP_H
+#define STATUS_HTTP_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "telemetria.h"
+
+#define STATUS_HTTP_LINHA_BYTES 64     // "GET /status HTTP/1.1"; mais que isso recebe 414
+#define STATUS_HTTP_RESPOSTA_BYTES 1024 // cabeçalho (~130 bytes) + JSON (~600 bytes no pior caso)
+
+#define STATUS_SEM_PREPARO 0xFF // etapas_concluidas fora de um preparo
+
+// Foto do estado da máquina, publicada pelo loop principal; uma resposta usa uma única foto
+typedef struct {
+  uint32_t sequencia;          // conta as publicações (o cliente vê se a foto mudou)
+  uint32_t tempo_ligado_s;
+  uint8_t estado;              // Estado (estado.h)
+  uint8_t etapas_concluidas;   // etapas do preparo em andamento; STATUS_SEM_PREPARO fora dele
+  bool ambiente_valido;        // última leitura do DHT22
+  int16_t temperatura_dc;      // décimos de °C
+  int16_t umidade_dc;          // décimos de %
+  int32_t agua_ml;
+  int32_t graos_g;
+  ResumoPeriodo hoje;          // histórico (telemetria.h)
+  ResumoPeriodo semana;        // últimos 7 dias, incluindo hoje
+} FotoStatus;
+
+typedef struct {
+  char linha[STATUS_HTTP_LINHA_BYTES];
+  uint8_t tamanho_linha;
+  uint8_t fim_cabecalho;       // fins de linha seguidos, sem texto entre eles (2: linha vazia)
+  bool linha_completa;
+  bool linha_longa;
+  uint16_t codigo;             // status da última resposta (200, 404...)
+  uint16_t tamanho_resposta;
+  char resposta[STATUS_HTTP_RESPOSTA_BYTES];
+} ConexaoHttp;
+
+void status_http_iniciar(ConexaoHttp *c);
+// Consome os bytes recebidos; true quando o pedido terminou (linha em branco após os cabeçalhos)
+bool status_http_receber(ConexaoHttp *c, const uint8_t *dados, size_t tamanho);
+// Monta a resposta em c->resposta a partir da foto e devolve o tamanho
+uint16_t status_http_responder(ConexaoHttp *c, const FotoStatus *foto);
+
+#endif // STATUS_HTTP_H
@@ -12,12 +12,17 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include "lcd_i2c.h"
+#include "barramento.h"
 #include "controle_ir.h"
 #include "pico/time.h"
 #include "atuadores.h" 
-
-#define LED_VERMELHO 12 // LED vermelho: indica que a máquina precisa ser reabastecida
-#define BUZZER_PIN 14   // Buzzer: usado para notificações sonoras
+#include "gravador.h"
+#include "rastreio.h"
+#include "monitor.h"
+#include "log_adiado.h"
+#include "placa.h"
+#include "hal_gpio.h"
+#include "na_ram.h"
 extern float agua_ml;
 extern float graos_g;
 extern bool play_apertado;
@@ -36,26 +41,26 @@ typedef enum {
 // Inicializa o ADC e configura os pinos dos potenciômetros
 void init_adc() {
   adc_init();
-  adc_gpio_init(26); // INTENSITY_POT_PIN
-  adc_gpio_init(27); // TEMP_WATER_PIN
-  adc_gpio_init(28); // WATER_AMOUNT_PIN
+  adc_gpio_init(INTENSITY_POT_PIN);
+  adc_gpio_init(TEMP_WATER_PIN);
+  adc_gpio_init(WATER_AMOUNT_PIN);
 }
 
 // Lê o potenciômetro de intensidade (0 a 100%)
 int ler_intensidade() {
-  adc_select_input(0); // ADC0 (GPIO26)
+  adc_select_input(ADC_CANAL(INTENSITY_POT_PIN));
   sleep_us(500);       // Aguarda estabilização
   adc_read();          // Descartar primeira leitura
-  uint16_t raw_value = adc_read();
+  uint16_t raw_value = gravador_adc(0, adc_read());
   return (raw_value * 100) / 4095; // Converte para percentual
 }
 
 // Lê o potenciômetro de temperatura (85°C a 95°C)
 float ler_temperatura_desejada() {
-  adc_select_input(1); // ADC1 (GPIO27)
+  adc_select_input(ADC_CANAL(TEMP_WATER_PIN));
   sleep_us(500);
   adc_read();          // Descartar primeira leitura
-  uint16_t raw_value = adc_read();
+  uint16_t raw_value = gravador_adc(1, adc_read());
 
   float percentual = (raw_value * 100.0) / 4095.0;
   return 85.0 + ((percentual * 10.0) / 100.0); // Mapeia para 85°C - 95°C
@@ -63,63 +68,75 @@ float ler_temperatura_desejada() {
 
 // Lê o potenciômetro de quantidade de água (50 ml a 200 ml)
 int ler_quantidade_agua() {
-  adc_select_input(2); // ADC2 (GPIO28)
+  adc_select_input(ADC_CANAL(WATER_AMOUNT_PIN));
   sleep_us(500);
   adc_read();          // Descartar primeira leitura
-  uint16_t raw_value = adc_read();
+  uint16_t raw_value = gravador_adc(2, adc_read());
   return 50 + ((raw_value * 150) / 4095); // Mapeia para 50 ml - 200 ml
 }
 
 // ---------------------------------- DHT22 (Temperatura e Umidade) ---------------------------------- //
-void read_from_dht(dht_reading *result, const uint DHT_PIN) {
+// Valida o checksum e converte os 40 bits lidos do DHT22 em umidade e temperatura
+void decodificar_dht(const int data[5], uint bits, dht_reading *result) {
+  // Validação dos dados
+  if ((bits >= 40) && (data[4] == ((data[0] + data[1] + data[2] + data[3]) & 0xFF))) {
+    result->humidity = (float)((data[0] << 8) + data[1]) / 10;
+    if (result->humidity > 100) {
+      result->humidity = data[0];
+    }
+    result->temp_celsius = (float)(((data[2] & 0x7F) << 8) + data[3]) / 10;
+    if (result->temp_celsius > 125) {
+      result->temp_celsius = data[2];
+    }
+    if (data[2] & 0x80) {
+      result->temp_celsius = -result->temp_celsius;
+    }
+  } else {
+    LOG("Dados inválidos do DHT22\n");
+    result->humidity = -1; // Valor de erro
+    result->temp_celsius = -1; // Valor de erro
+  }
+}
+
+void NA_RAM(read_from_dht)(dht_reading *result, const uint pino) {
   int data[5] = {0, 0, 0, 0, 0};
   uint last = 1;
+  monitor_entrar(TRECHO_LEITURA_DHT);
   uint j = 0;
 
   // Pulso de inicialização
-  gpio_set_dir(DHT_PIN, GPIO_OUT);
-  gpio_put(DHT_PIN, 0);
+  gpio_set_dir(pino, GPIO_OUT);
+  gpio_put(pino, 0);
   sleep_ms(20);
-  gpio_set_dir(DHT_PIN, GPIO_IN);
+  gpio_set_dir(pino, GPIO_IN);
 
-  // Leitura do sensor
+  // Leitura do sensor. A reserva do barramento segura a escrita das animações no LCD (IRQ de software,
+  // até ~2 ms), que alongaria um nível e cortaria a leitura
+  barramento_reservar();
   for (uint i = 0; i < MAX_TIMINGS; i++) {
+    // Largura do nível em µs pelo temporizador (não por voltas do laço, que dependem de clk_sys)
+    uint32_t inicio = time_us_32();
     uint count = 0;
-    while (gpio_get(DHT_PIN) == last) {
-      count++;
-      sleep_us(1);
-      if (count == 255) break;
+    while (hal_gpio_ler(pino) == last) { // leitura direta do SIO
+      count = time_us_32() - inicio;
+      if (count >= 255) break;
     }
-    last = gpio_get(DHT_PIN);
-    if (count == 255) break;
+    last = hal_gpio_ler(pino);
+    if (count >= 255) break;
 
     if ((i >= 4) && (i % 2 == 0)) {
       data[j / 8] <<= 1;
-      if (count > 50) { // Ajuste fino do timing
+      if (count > 50) { // nível alto: 26-28 µs para 0, 70 µs para 1
         data[j / 8] |= 1;
       }
       j++;
     }
   }
+  barramento_liberar();
 
-  // Validação dos dados
-  if ((j >= 40) && (data[4] == ((data[0] + data[1] + data[2] + data[3]) & 0xFF))) {
-    result->humidity = (float)((data[0] << 8) + data[1]) / 10;
-    if (result->humidity > 100) {
-      result->humidity = data[0];
-    }
-    result->temp_celsius = (float)(((data[2] & 0x7F) << 8) + data[3]) / 10;
-    if (result->temp_celsius > 125) {
-      result->temp_celsius = data[2];
-    }
-    if (data[2] & 0x80) {
-      result->temp_celsius = -result->temp_celsius;
-    }
-  } else {
-    printf("Dados inválidos do DHT22\n");
-    result->humidity = -1; // Valor de erro
-    result->temp_celsius = -1; // Valor de erro
-  }
+  decodificar_dht(data, j, result);
+  gravador_dht(result); // grava a leitura (ou a substitui pela gravada, em reprodução)
+  monitor_sair(TRECHO_LEITURA_DHT);
 }
 
 float convert_to_fahrenheit(float temp_celsius) {
@@ -133,10 +150,10 @@ bool is_valid_reading(const dht_reading *reading) {
 void print_dht_reading(const dht_reading *reading) {
   if (is_valid_reading(reading)) {
     float fahrenheit = convert_to_fahrenheit(reading->temp_celsius);
-    printf("Umidade: %.1f%%, Temperatura: %.1f°C (%.1f°F)\n",
+    LOG("Umidade: %.1f%%, Temperatura: %.1f°C (%.1f°F)\n",
            reading->humidity, reading->temp_celsius, fahrenheit);
   } else {
-    printf("Erro na leitura do DHT22. Tente novamente.\n");
+    LOG("Erro na leitura do DHT22. Tente novamente.\n");
   }
 }
 
@@ -144,24 +161,28 @@ void print_dht_reading(const dht_reading *reading) {
 // ---------------------------------- RTC (Relógio de Tempo Real) ---------------------------------- //
 // Função para ler dados do RTC
 void rtc_read(i2c_inst_t *i2c, uint8_t sda_pin, uint8_t scl_pin, uint8_t *rtc_data) {
-  // Configure os pinos I2C para o RTC
-  gpio_set_function(sda_pin, GPIO_FUNC_I2C);
-  gpio_set_function(scl_pin, GPIO_FUNC_I2C);
-  gpio_pull_up(sda_pin);
-  gpio_pull_up(scl_pin);
+  monitor_entrar(TRECHO_LEITURA_RTC);
+  (void)sda_pin; // pinos configurados uma vez em barramento_iniciar
+  (void)scl_pin;
 
   // Leitura dos dados do RTC
   uint8_t reg = 0x00;
+  rastreio_evento(RASTREIO_I2C_INICIO, RTC_ADDR, 8);
+  barramento_reservar(); // escrita + leitura com início repetido: sem escrita de animação no meio
+  barramento_selecionar(RTC_ADDR); // DS1307 em 100 kHz
   int ret = i2c_write_blocking(i2c, RTC_ADDR, &reg, 1, true);
   if (ret < 0) {
-    printf("Erro ao escrever no RTC\n");
-    return;
-  }
-  ret = i2c_read_blocking(i2c, RTC_ADDR, rtc_data, 7, false);
-  if (ret < 0) {
-    printf("Erro ao ler do RTC\n");
-    return;
+    LOG("Erro ao escrever no RTC\n");
+  } else {
+    ret = i2c_read_blocking(i2c, RTC_ADDR, rtc_data, 7, false);
+    if (ret < 0) {
+      LOG("Erro ao ler do RTC\n");
+    }
   }
+  barramento_liberar();
+  rastreio_evento(RASTREIO_I2C_FIM, RTC_ADDR, ret);
+  gravador_rtc(rtc_data); // grava a leitura (ou a substitui pela gravada, em reprodução)
+  monitor_sair(TRECHO_LEITURA_RTC);
 }
 
 // Função para formatar os dados do RTC
@@ -257,6 +278,7 @@ void configurar_dia(i2c_inst_t *i2c, uint8_t sda_pin, uint8_t scl_pin, uint8_t *
 uint8_t read_digit(const char *key, uint32_t timeout_ms) {
   uint32_t start_time = to_ms_since_boot(get_absolute_time());
   uint8_t digit = 0xFF; // Valor inválido por padrão
+  monitor_entrar(TRECHO_LER_DIGITO);
 
   while (to_ms_since_boot(get_absolute_time()) - start_time < timeout_ms) {
     if (strlen(key) == 1 && isdigit(key[0])) {
@@ -265,6 +287,7 @@ uint8_t read_digit(const char *key, uint32_t timeout_ms) {
     }
   }
   sleep_ms(100);
+  monitor_sair(TRECHO_LER_DIGITO);
   return digit;
 }
 
@@ -296,7 +319,7 @@ void configurar_hora(uint8_t *hour, const char *key) {
 
   lcd_set_cursor(0, 0);
   lcd_print("HOURS OK!         ");
-  printf("Hora configurada para %02d\n", *hour);
+  LOG("Hora configurada para %02d\n", *hour);
   sleep_ms(2000);
 }
 
@@ -326,7 +349,7 @@ void configurar_minutos(uint8_t *minutes, const char *key) {
 
   lcd_clear();
   lcd_print("MIN CONFIRMED!");
-  printf("Minutos configurados para %02d\n", *minutes);
+  LOG("Minutos configurados para %02d\n", *minutes);
   sleep_ms(1000);
 }
 
@@ -335,6 +358,7 @@ HorarioConfigurado configurar_horario(i2c_inst_t *i2c, uint8_t sda_pin, uint8_t
 {
   HorarioConfigurado horario = {0, 0, 0, 0, false};
   EstadoHorario estado_atual = ESTADO_CONFIG_DIA;
+  monitor_entrar(TRECHO_CONFIGURAR_HORARIO);
 
   while (true) {
     switch (estado_atual) {
@@ -399,6 +423,7 @@ HorarioConfigurado configurar_horario(i2c_inst_t *i2c, uint8_t sda_pin, uint8_t
         lcd_set_cursor(3, 6);
         lcd_print(buffer);
         sleep_ms(3000);
+        monitor_sair(TRECHO_CONFIGURAR_HORARIO);
         return horario;
 
       case ESTADO_INVALIDO:
@@ -420,6 +445,7 @@ void verificar_recursos_simulado(int xicaras, int agua_por_xicara) {
   float graos_necessarios = xicaras * 10; // 10g por xícara
   float agua_necessaria = xicaras * agua_por_xicara; // considera a quantidade de água escolhida
   bool precisa_reabastecer = false;
+  monitor_entrar(TRECHO_VERIFICAR_RECURSOS);
 
   if (agua_ml < agua_necessaria) { // Verifica se há água suficiente
     gpio_put(LED_VERMELHO, 1);     // Acende o LED vermelho
@@ -459,4 +485,5 @@ void verificar_recursos_simulado(int xicaras, int agua_por_xicara) {
     sleep_ms(2000);
     play_apertado = false; // Reseta a flag
   }
+  monitor_sair(TRECHO_VERIFICAR_RECURSOS);
 }
\ No newline at end of file
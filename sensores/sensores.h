@@ -14,9 +14,7 @@
 #include <ctype.h>
 #include "controle_ir.h"
 #include "lcd_i2c.h"
-
-// Endereço do RTC
-#define RTC_ADDR 0x68
+#include "placa.h" // endereço do RTC
 
 // Tipos e estruturas
 
@@ -42,7 +40,8 @@ float ler_temperatura_desejada(); // Lê a temperatura desejada (85°C a 95°C)
 int ler_quantidade_agua();        // Lê a quantidade de água desejada (50 ml a 200 ml)
 
 // Funções para o sensor DHT22
-void read_from_dht(dht_reading *result, const uint DHT_PIN);
+void read_from_dht(dht_reading *result, const uint pino);
+void decodificar_dht(const int data[5], uint bits, dht_reading *result);
 float convert_to_fahrenheit(float temp_celsius);
 bool is_valid_reading(const dht_reading *reading);
 void print_dht_reading(const dht_reading *reading);
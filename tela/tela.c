@@ -0,0 +1,51 @@
+// tela.c
+// Renderização das telas declarativas com redesenho apenas dos campos alterados
+
+#include "tela.h"
+#include <string.h>
+#include "lcd_i2c.h"
+
+// Formata o campo e escreve no display; lcd_compor completa a largura com espaços (apaga o valor
+// anterior) e envia só os caracteres que mudaram
+static void desenhar_campo(const Tela *tela, int i) {
+  const Campo *campo = &tela->campos[i];
+  char texto[LCD_COLS + 1];
+  size_t largura = campo->largura < LCD_COLS ? campo->largura : LCD_COLS;
+
+  tela->versoes_exibidas[i] = campo->fonte->versao;
+  campo->formatar(texto, largura + 1);
+  size_t n = strlen(texto);
+  memset(texto + n, ' ', largura - n);
+  texto[largura] = '\0';
+
+  lcd_compor(campo->linha, campo->coluna, texto, largura);
+}
+
+void tela_exibir(const Tela *tela) {
+  for (int i = 0; i < tela->total_rotulos; i++) {
+    lcd_set_cursor(tela->rotulos[i].linha, tela->rotulos[i].coluna);
+    lcd_print(tela->rotulos[i].texto);
+  }
+  if (tela->total_icones > 0) {
+    GlifoId ids[TOTAL_GLIFOS];
+    int n = 0;
+    for (int i = 0; i < tela->total_icones && n < TOTAL_GLIFOS; i++) {
+      ids[n++] = tela->icones[i].glifo;
+    }
+    glifos_preparar(ids, n); // as faltas da tela inteira em uma só transação
+    for (int i = 0; i < tela->total_icones; i++) {
+      glifo_desenhar(tela->icones[i].glifo, tela->icones[i].linha, tela->icones[i].coluna);
+    }
+  }
+  for (int i = 0; i < tela->total_campos; i++) {
+    desenhar_campo(tela, i);
+  }
+}
+
+void tela_atualizar(const Tela *tela) {
+  for (int i = 0; i < tela->total_campos; i++) {
+    if (tela->campos[i].fonte->versao != tela->versoes_exibidas[i]) {
+      desenhar_campo(tela, i);
+    }
+  }
+}
@@ -0,0 +1,54 @@
+// tela.h
+// Descrição declarativa das telas do LCD: rótulos fixos e campos ligados a fontes de dados.
+// As definições são constantes (ficam na flash); cada fonte de dados tem um contador de versão que o
+// dono do dado incrementa quando o valor muda. tela_atualizar reescreve apenas os campos cuja fonte
+// mudou desde o último quadro, então o custo no I2C acompanha as mudanças e não o tamanho da tela.
+
+#ifndef TELA_H
+#define TELA_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "glifos.h"
+
+// Fonte de dados versionada; embutida na estrutura que guarda o valor
+typedef struct {
+  uint32_t versao;
+} FonteDados;
+
+static inline void fonte_publicar(FonteDados *fonte) {
+  fonte->versao++;
+}
+
+typedef struct {
+  uint8_t linha, coluna;
+  const char *texto;
+} Rotulo;
+
+typedef struct {
+  uint8_t linha, coluna, largura;          // a largura é sempre preenchida (com espaços) ao reescrever
+  const FonteDados *fonte;
+  void (*formatar)(char *destino, size_t tamanho);
+} Campo;
+
+typedef struct {
+  uint8_t linha, coluna;
+  GlifoId glifo;                           // carregado na CGRAM pelo cache de glifos
+} Icone;
+
+typedef struct {
+  const Rotulo *rotulos;
+  uint8_t total_rotulos;
+  const Campo *campos;
+  uint8_t total_campos;
+  uint32_t *versoes_exibidas;              // RAM: uma posição por campo
+  const Icone *icones;
+  uint8_t total_icones;
+} Tela;
+
+#define TOTAL_ITENS(vetor) ((uint8_t)(sizeof(vetor) / sizeof((vetor)[0])))
+
+void tela_exibir(const Tela *tela);   // rótulos, ícones e todos os campos, sobre o display já limpo
+void tela_atualizar(const Tela *tela); // somente os campos cuja fonte mudou
+
+#endif // TELA_H